@@ -27,6 +27,7 @@ extern "C"
 #endif // __cplusplus
 
 #include <stdint.h>
+#include <string.h>
 #include "engine_common.h"
 
 typedef uint8_t cce_endianess;
@@ -34,6 +35,29 @@ typedef uint8_t cce_endianess;
 #define CCE_BIG_ENDIAN 0
 #define CCE_LITTLE_ENDIAN 1
 
+/* Host endianess is resolved at compile time when compiler tells it (define CCE_HOST_LITTLE_ENDIAN or CCE_HOST_BIG_ENDIAN to force it),
+ * so conversions from host endianess are no-op and don't go through function pointers */
+#if !defined(CCE_HOST_LITTLE_ENDIAN) && !defined(CCE_HOST_BIG_ENDIAN)
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CCE_HOST_LITTLE_ENDIAN
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define CCE_HOST_BIG_ENDIAN
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64))
+#define CCE_HOST_LITTLE_ENDIAN
+#endif
+#endif // !CCE_HOST_LITTLE_ENDIAN && !CCE_HOST_BIG_ENDIAN
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CCE_BYTESWAP16(value) __builtin_bswap16(value)
+#define CCE_BYTESWAP32(value) __builtin_bswap32(value)
+#define CCE_BYTESWAP64(value) __builtin_bswap64(value)
+#elif defined(_MSC_VER)
+#include <stdlib.h>
+#define CCE_BYTESWAP16(value) _byteswap_ushort(value)
+#define CCE_BYTESWAP32(value) _byteswap_ulong(value)
+#define CCE_BYTESWAP64(value) _byteswap_uint64(value)
+#endif
+
 CCE_PUBLIC_OPTIONS extern const cce_endianess *const g_endianess;
 
 CCE_PUBLIC_OPTIONS extern uint16_t (*cceLittleEndianConversionInt16) (uint16_t);
@@ -47,61 +71,135 @@ CCE_PUBLIC_OPTIONS extern uint64_t (*cceBigEndianConversionInt64) (uint64_t);
 CCE_PUBLIC_OPTIONS extern void* (*cceBigEndianConversionArrayIntN)    (void*, size_t, size_t);
 CCE_PUBLIC_OPTIONS extern void* (*cceBigEndianConversionNewArrayIntN) (void*, const void*, size_t, size_t);
 
-#define cceBigEndianToHostEndianInt16(value) cceBigEndianConversionInt16(value)
-#define cceHostEndianToBigEndianInt16(value) cceBigEndianConversionInt16(value)
-#define cceBigEndianToHostEndianInt32(value) cceBigEndianConversionInt32(value)
-#define cceHostEndianToBigEndianInt32(value) cceBigEndianConversionInt32(value)
-#define cceBigEndianToHostEndianInt64(value) cceBigEndianConversionInt64(value)
-#define cceHostEndianToBigEndianInt64(value) cceBigEndianConversionInt64(value)
-
-#define cceBigEndianToHostEndianArrayInt16(array, size) (uint16_t*) cceBigEndianConversionArrayIntN(array, size, 2)
-#define cceHostEndianToBigEndianArrayInt16(array, size) (uint16_t*) cceBigEndianConversionArrayIntN(array, size, 2)
-#define cceBigEndianToHostEndianArrayInt32(array, size) (uint32_t*) cceBigEndianConversionArrayIntN(array, size, 4)
-#define cceHostEndianToBigEndianArrayInt32(array, size) (uint32_t*) cceBigEndianConversionArrayIntN(array, size, 4)
-#define cceBigEndianToHostEndianArrayInt64(array, size) (uint64_t*) cceBigEndianConversionArrayIntN(array, size, 8)
-#define cceHostEndianToBigEndianArrayInt64(array, size) (uint64_t*) cceBigEndianConversionArrayIntN(array, size, 8)
-#define cceBigEndianToHostEndianArrayIntN(array, size, n) cceBigEndianConversionArrayIntN(array, size, n)
-#define cceHostEndianToBigEndianArrayIntN(array, size, n) cceBigEndianConversionArrayIntN(array, size, n)
-
-#define cceBigEndianToHostEndianNewArrayInt16(dest, src, size) (uint16_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 2)
-#define cceHostEndianToBigEndianNewArrayInt16(dest, src, size) (uint16_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 2)
-#define cceBigEndianToHostEndianNewArrayInt32(dest, src, size) (uint32_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 4)
-#define cceHostEndianToBigEndianNewArrayInt32(dest, src, size) (uint32_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 4)
-#define cceBigEndianToHostEndianNewArrayInt64(dest, src, size) (uint64_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 8)
-#define cceHostEndianToBigEndianNewArrayInt64(dest, src, size) (uint64_t*) cceBigEndianConversionNewArrayIntN(dest, src, size, 8)
-#define cceBigEndianToHostEndianNewArrayIntN(dest, src, size, n) cceBigEndianConversionNewArrayIntN(dest, src, size, n)
-#define cceHostEndianToBigEndianNewArrayIntN(dest, src, size, n) cceBigEndianConversionNewArrayIntN(dest, src, size, n)
-
-#define cceLittleEndianToHostEndianInt16(value) cceLittleEndianConversionInt16(value)
-#define cceHostEndianToLittleEndianInt16(value) cceLittleEndianConversionInt16(value)
-#define cceLittleEndianToHostEndianInt32(value) cceLittleEndianConversionInt32(value)
-#define cceHostEndianToLittleEndianInt32(value) cceLittleEndianConversionInt32(value)
-#define cceLittleEndianToHostEndianInt64(value) cceLittleEndianConversionInt64(value)
-#define cceHostEndianToLittleEndianInt64(value) cceLittleEndianConversionInt64(value)
-
-#define cceHostEndianToLittleEndianArrayInt16(array, size) (uint16_t*) cceLittleEndianConversionArrayIntN(array, size, 2)
-#define cceLittleEndianToHostEndianArrayInt16(array, size) (uint16_t*) cceLittleEndianConversionArrayIntN(array, size, 2)
-#define cceHostEndianToLittleEndianArrayInt32(array, size) (uint32_t*) cceLittleEndianConversionArrayIntN(array, size, 4)
-#define cceLittleEndianToHostEndianArrayInt32(array, size) (uint32_t*) cceLittleEndianConversionArrayIntN(array, size, 4)
-#define cceHostEndianToLittleEndianArrayInt64(array, size) (uint64_t*) cceLittleEndianConversionArrayIntN(array, size, 8)
-#define cceLittleEndianToHostEndianArrayInt64(array, size) (uint64_t*) cceLittleEndianConversionArrayIntN(array, size, 8)
-#define cceHostEndianToLittleEndianArrayIntN(array, size, n) cceLittleEndianConversionArrayIntN(array, size, n)
-#define cceLittleEndianToHostEndianArrayIntN(array, size, n) cceLittleEndianConversionArrayIntN(array, size, n)
-
-#define cceHostEndianToLittleEndianNewArrayInt16(dest, src, size) (uint16_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 2)
-#define cceLittleEndianToHostEndianNewArrayInt16(dest, src, size) (uint16_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 2)
-#define cceHostEndianToLittleEndianNewArrayInt32(dest, src, size) (uint32_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 4)
-#define cceLittleEndianToHostEndianNewArrayInt32(dest, src, size) (uint32_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 4)
-#define cceHostEndianToLittleEndianNewArrayInt64(dest, src, size) (uint64_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 8)
-#define cceLittleEndianToHostEndianNewArrayInt64(dest, src, size) (uint64_t*) cceLittleEndianConversionNewArrayIntN(dest, src, size, 8)
-#define cceHostEndianToLittleEndianNewArrayIntN(dest, src, size, n) cceLittleEndianConversionNewArrayIntN(dest, src, size, n)
-#define cceLittleEndianToHostEndianNewArrayIntN(dest, src, size, n) cceLittleEndianConversionNewArrayIntN(dest, src, size, n)
+static inline uint16_t ccePreserveEndianInlineInt16 (uint16_t value)
+{
+   return value;
+}
+
+static inline uint32_t ccePreserveEndianInlineInt32 (uint32_t value)
+{
+   return value;
+}
+
+static inline uint64_t ccePreserveEndianInlineInt64 (uint64_t value)
+{
+   return value;
+}
+
+static inline void* ccePreserveEndianInlineArrayIntN (void *array, size_t arraySize, size_t n)
+{
+   (void) arraySize;
+   (void) n;
+   return array;
+}
+
+static inline void* ccePreserveEndianInlineNewArrayIntN (void *newArray, const void *array, size_t arraySize, size_t n)
+{
+   return memcpy(newArray, array, arraySize * n);
+}
+
+#if defined(CCE_HOST_LITTLE_ENDIAN)
+#define cceHostEndianess CCE_LITTLE_ENDIAN
+#define CCE_LE_CONVERSION_INT16(value) ccePreserveEndianInlineInt16(value)
+#define CCE_LE_CONVERSION_INT32(value) ccePreserveEndianInlineInt32(value)
+#define CCE_LE_CONVERSION_INT64(value) ccePreserveEndianInlineInt64(value)
+#define CCE_LE_CONVERSION_ARRAY(array, size, n) ccePreserveEndianInlineArrayIntN(array, size, n)
+#define CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, n) ccePreserveEndianInlineNewArrayIntN(dest, src, size, n)
+#define CCE_BE_CONVERSION_INT16(value) cceSwapEndianInt16(value)
+#define CCE_BE_CONVERSION_INT32(value) cceSwapEndianInt32(value)
+#define CCE_BE_CONVERSION_INT64(value) cceSwapEndianInt64(value)
+#define CCE_BE_CONVERSION_ARRAY(array, size, n) cceSwapEndianArrayIntN(array, size, n)
+#define CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, n) cceSwapEndianNewArrayIntN(dest, src, size, n)
+#elif defined(CCE_HOST_BIG_ENDIAN)
+#define cceHostEndianess CCE_BIG_ENDIAN
+#define CCE_LE_CONVERSION_INT16(value) cceSwapEndianInt16(value)
+#define CCE_LE_CONVERSION_INT32(value) cceSwapEndianInt32(value)
+#define CCE_LE_CONVERSION_INT64(value) cceSwapEndianInt64(value)
+#define CCE_LE_CONVERSION_ARRAY(array, size, n) cceSwapEndianArrayIntN(array, size, n)
+#define CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, n) cceSwapEndianNewArrayIntN(dest, src, size, n)
+#define CCE_BE_CONVERSION_INT16(value) ccePreserveEndianInlineInt16(value)
+#define CCE_BE_CONVERSION_INT32(value) ccePreserveEndianInlineInt32(value)
+#define CCE_BE_CONVERSION_INT64(value) ccePreserveEndianInlineInt64(value)
+#define CCE_BE_CONVERSION_ARRAY(array, size, n) ccePreserveEndianInlineArrayIntN(array, size, n)
+#define CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, n) ccePreserveEndianInlineNewArrayIntN(dest, src, size, n)
+#else
+#define cceHostEndianess (*g_endianess)
+#define CCE_LE_CONVERSION_INT16(value) cceLittleEndianConversionInt16(value)
+#define CCE_LE_CONVERSION_INT32(value) cceLittleEndianConversionInt32(value)
+#define CCE_LE_CONVERSION_INT64(value) cceLittleEndianConversionInt64(value)
+#define CCE_LE_CONVERSION_ARRAY(array, size, n) cceLittleEndianConversionArrayIntN(array, size, n)
+#define CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, n) cceLittleEndianConversionNewArrayIntN(dest, src, size, n)
+#define CCE_BE_CONVERSION_INT16(value) cceBigEndianConversionInt16(value)
+#define CCE_BE_CONVERSION_INT32(value) cceBigEndianConversionInt32(value)
+#define CCE_BE_CONVERSION_INT64(value) cceBigEndianConversionInt64(value)
+#define CCE_BE_CONVERSION_ARRAY(array, size, n) cceBigEndianConversionArrayIntN(array, size, n)
+#define CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, n) cceBigEndianConversionNewArrayIntN(dest, src, size, n)
+#endif // CCE_HOST_LITTLE_ENDIAN
+
+#define cceBigEndianToHostEndianInt16(value) CCE_BE_CONVERSION_INT16(value)
+#define cceHostEndianToBigEndianInt16(value) CCE_BE_CONVERSION_INT16(value)
+#define cceBigEndianToHostEndianInt32(value) CCE_BE_CONVERSION_INT32(value)
+#define cceHostEndianToBigEndianInt32(value) CCE_BE_CONVERSION_INT32(value)
+#define cceBigEndianToHostEndianInt64(value) CCE_BE_CONVERSION_INT64(value)
+#define cceHostEndianToBigEndianInt64(value) CCE_BE_CONVERSION_INT64(value)
+
+#define cceBigEndianToHostEndianArrayInt16(array, size) (uint16_t*) CCE_BE_CONVERSION_ARRAY(array, size, 2)
+#define cceHostEndianToBigEndianArrayInt16(array, size) (uint16_t*) CCE_BE_CONVERSION_ARRAY(array, size, 2)
+#define cceBigEndianToHostEndianArrayInt32(array, size) (uint32_t*) CCE_BE_CONVERSION_ARRAY(array, size, 4)
+#define cceHostEndianToBigEndianArrayInt32(array, size) (uint32_t*) CCE_BE_CONVERSION_ARRAY(array, size, 4)
+#define cceBigEndianToHostEndianArrayInt64(array, size) (uint64_t*) CCE_BE_CONVERSION_ARRAY(array, size, 8)
+#define cceHostEndianToBigEndianArrayInt64(array, size) (uint64_t*) CCE_BE_CONVERSION_ARRAY(array, size, 8)
+#define cceBigEndianToHostEndianArrayIntN(array, size, n) CCE_BE_CONVERSION_ARRAY(array, size, n)
+#define cceHostEndianToBigEndianArrayIntN(array, size, n) CCE_BE_CONVERSION_ARRAY(array, size, n)
+
+#define cceBigEndianToHostEndianNewArrayInt16(dest, src, size) (uint16_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 2)
+#define cceHostEndianToBigEndianNewArrayInt16(dest, src, size) (uint16_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 2)
+#define cceBigEndianToHostEndianNewArrayInt32(dest, src, size) (uint32_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 4)
+#define cceHostEndianToBigEndianNewArrayInt32(dest, src, size) (uint32_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 4)
+#define cceBigEndianToHostEndianNewArrayInt64(dest, src, size) (uint64_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 8)
+#define cceHostEndianToBigEndianNewArrayInt64(dest, src, size) (uint64_t*) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, 8)
+#define cceBigEndianToHostEndianNewArrayIntN(dest, src, size, n) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, n)
+#define cceHostEndianToBigEndianNewArrayIntN(dest, src, size, n) CCE_BE_CONVERSION_NEW_ARRAY(dest, src, size, n)
+
+#define cceLittleEndianToHostEndianInt16(value) CCE_LE_CONVERSION_INT16(value)
+#define cceHostEndianToLittleEndianInt16(value) CCE_LE_CONVERSION_INT16(value)
+#define cceLittleEndianToHostEndianInt32(value) CCE_LE_CONVERSION_INT32(value)
+#define cceHostEndianToLittleEndianInt32(value) CCE_LE_CONVERSION_INT32(value)
+#define cceLittleEndianToHostEndianInt64(value) CCE_LE_CONVERSION_INT64(value)
+#define cceHostEndianToLittleEndianInt64(value) CCE_LE_CONVERSION_INT64(value)
+
+#define cceHostEndianToLittleEndianArrayInt16(array, size) (uint16_t*) CCE_LE_CONVERSION_ARRAY(array, size, 2)
+#define cceLittleEndianToHostEndianArrayInt16(array, size) (uint16_t*) CCE_LE_CONVERSION_ARRAY(array, size, 2)
+#define cceHostEndianToLittleEndianArrayInt32(array, size) (uint32_t*) CCE_LE_CONVERSION_ARRAY(array, size, 4)
+#define cceLittleEndianToHostEndianArrayInt32(array, size) (uint32_t*) CCE_LE_CONVERSION_ARRAY(array, size, 4)
+#define cceHostEndianToLittleEndianArrayInt64(array, size) (uint64_t*) CCE_LE_CONVERSION_ARRAY(array, size, 8)
+#define cceLittleEndianToHostEndianArrayInt64(array, size) (uint64_t*) CCE_LE_CONVERSION_ARRAY(array, size, 8)
+#define cceHostEndianToLittleEndianArrayIntN(array, size, n) CCE_LE_CONVERSION_ARRAY(array, size, n)
+#define cceLittleEndianToHostEndianArrayIntN(array, size, n) CCE_LE_CONVERSION_ARRAY(array, size, n)
+
+#define cceHostEndianToLittleEndianNewArrayInt16(dest, src, size) (uint16_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 2)
+#define cceLittleEndianToHostEndianNewArrayInt16(dest, src, size) (uint16_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 2)
+#define cceHostEndianToLittleEndianNewArrayInt32(dest, src, size) (uint32_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 4)
+#define cceLittleEndianToHostEndianNewArrayInt32(dest, src, size) (uint32_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 4)
+#define cceHostEndianToLittleEndianNewArrayInt64(dest, src, size) (uint64_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 8)
+#define cceLittleEndianToHostEndianNewArrayInt64(dest, src, size) (uint64_t*) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, 8)
+#define cceHostEndianToLittleEndianNewArrayIntN(dest, src, size, n) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, n)
+#define cceLittleEndianToHostEndianNewArrayIntN(dest, src, size, n) CCE_LE_CONVERSION_NEW_ARRAY(dest, src, size, n)
 
 CCE_PUBLIC_OPTIONS uint16_t cceSwapEndianInt16 (uint16_t value);
 CCE_PUBLIC_OPTIONS uint32_t cceSwapEndianInt32 (uint32_t value);
 CCE_PUBLIC_OPTIONS uint64_t cceSwapEndianInt64 (uint64_t value);
 CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayIntN (void *array, size_t arraySize, size_t n);
 CCE_PUBLIC_OPTIONS void* cceSwapEndianNewArrayIntN (void *newArray, const void *array, size_t arraySize, size_t n);
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt16 (void *array, size_t arraySize);
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt32 (void *array, size_t arraySize);
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt64 (void *array, size_t arraySize);
+
+#ifdef CCE_BYTESWAP16
+#define cceSwapEndianInt16(value) CCE_BYTESWAP16(value)
+#define cceSwapEndianInt32(value) CCE_BYTESWAP32(value)
+#define cceSwapEndianInt64(value) CCE_BYTESWAP64(value)
+#endif // CCE_BYTESWAP16
 
 #define cceBigEndianToLittleEndianInt16(value) cceSwapEndianInt16(value)
 #define cceLittleEndianToBigEndianInt16(value) cceSwapEndianInt16(value)
@@ -110,12 +208,12 @@ CCE_PUBLIC_OPTIONS void* cceSwapEndianNewArrayIntN (void *newArray, const void *
 #define cceBigEndianToLittleEndianInt64(value) cceSwapEndianInt64(value)
 #define cceLittleEndianToBigEndianInt64(value) cceSwapEndianInt64(value)
 
-#define cceBigEndianToLittleEndianArrayInt16(array, size) (uint16_t*) cceSwapEndianArrayIntN(array, size, 2)
-#define cceLittleEndianToBigEndianArrayInt16(array, size) (uint16_t*) cceSwapEndianArrayIntN(array, size, 2)
-#define cceBigEndianToLittleEndianArrayInt32(array, size) (uint32_t*) cceSwapEndianArrayIntN(array, size, 4)
-#define cceLittleEndianToBigEndianArrayInt32(array, size) (uint32_t*) cceSwapEndianArrayIntN(array, size, 4)
-#define cceBigEndianToLittleEndianArrayInt64(array, size) (uint64_t*) cceSwapEndianArrayIntN(array, size, 8)
-#define cceLittleEndianToBigEndianArrayInt64(array, size) (uint64_t*) cceSwapEndianArrayIntN(array, size, 8)
+#define cceBigEndianToLittleEndianArrayInt16(array, size) (uint16_t*) cceSwapEndianArrayInt16(array, size)
+#define cceLittleEndianToBigEndianArrayInt16(array, size) (uint16_t*) cceSwapEndianArrayInt16(array, size)
+#define cceBigEndianToLittleEndianArrayInt32(array, size) (uint32_t*) cceSwapEndianArrayInt32(array, size)
+#define cceLittleEndianToBigEndianArrayInt32(array, size) (uint32_t*) cceSwapEndianArrayInt32(array, size)
+#define cceBigEndianToLittleEndianArrayInt64(array, size) (uint64_t*) cceSwapEndianArrayInt64(array, size)
+#define cceLittleEndianToBigEndianArrayInt64(array, size) (uint64_t*) cceSwapEndianArrayInt64(array, size)
 #define cceBigEndianToLittleEndianArrayIntN(array, size, n) cceSwapEndianArrayIntN(array, size, n)
 #define cceLittleEndianToBigEndianArrayIntN(array, size, n) cceSwapEndianArrayIntN(array, size, n)
 
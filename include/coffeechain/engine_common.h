@@ -147,6 +147,8 @@ CCE_PUBLIC_OPTIONS cce_ubyte cceCheckCollision (int32_t element1_x, int32_t elem
                                                 int32_t element2_x, int32_t element2_y, int32_t element2_width, int32_t element2_height);
 
 CCE_PUBLIC_OPTIONS extern void (*cceSetWindowParameters) (cce_enum parameter, uint32_t a, uint32_t b);
+CCE_PUBLIC_OPTIONS int cceSetShaderCache (const char *folderName);
+CCE_PUBLIC_OPTIONS void cceSetRenderThread (uint8_t isEnabled);
 
 #ifdef __cplusplus
 }
@@ -79,6 +79,42 @@ struct ExitMap2D
    uint8_t flags; // 0x1 - a is x (otherwise a is y), 0x2 - b is to the south/west from globalOffset 0
 };
 
+/* World coordinates are 64-bit when library is built with CoffeeChain_WORLD_COORDINATES_64, */
+/* maps, dynamic elements and GPU data stay 32-bit and relative to current map */
+#ifdef CCE_WORLD_COORDINATES_64
+typedef int64_t cce_world_coord;
+#else
+typedef int32_t cce_world_coord;
+#endif
+
+struct cce_worldvec2
+{
+   cce_world_coord x;
+   cce_world_coord y;
+};
+
+/* Map in world index (world_<n>.c2w), coordinates are world coordinates */
+struct WorldMap2Dmap
+{
+   uint32_t ID;
+   struct cce_worldvec2 origin;    // Position of map's (0, 0)
+   struct cce_worldvec2 boundsMin; // Rectangle covered by the map, maps are kept loaded while it is near the camera
+   struct cce_worldvec2 boundsMax;
+};
+
+/* Textures which weren't drawn for a while are evicted (least recently drawn first) while texture pages take more than budget,
+ * textures left in the last pages are moved down so these pages are freed */
+struct TextureResidencyStats
+{
+   size_t   budget;                  // SIZE_MAX if there's no budget
+   size_t   residentSize;            // Bytes of RGBA8 texels in texture array
+   size_t   allocatedSize;           // Bytes of texture pages, including free space, budget is compared with it
+   uint32_t residentTexturesQuantity;
+   uint32_t evictionsQuantity;      // Since cceInitEngine2D
+   size_t   evictedSize;
+   uint32_t reloadsQuantity;        // Evicted textures loaded again because their map became visible
+};
+
 struct Map2DCollider
 {
    int32_t x;
@@ -171,16 +207,27 @@ CCE_PUBLIC_OPTIONS struct Map2D* cceMap2DdevToMap2D (struct Map2Ddev *mapdev);
 CCE_PUBLIC_OPTIONS void cceFreeMap2Ddev (struct Map2Ddev *map);
 CCE_PUBLIC_OPTIONS struct Map2Ddev* cceLoadMap2Ddev (uint16_t number);
 CCE_PUBLIC_OPTIONS int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*));
+CCE_PUBLIC_OPTIONS int cceWriteWorldMap2D (uint16_t number, const struct WorldMap2Dmap *maps, uint32_t mapsQuantity, struct cce_u32vec2 cellSize);
+CCE_PUBLIC_OPTIONS int cceLoadWorldMap2D (uint16_t number);
+CCE_PUBLIC_OPTIONS void cceSetStreamingRadiusWorldMap2D (uint32_t radius, uint32_t hysteresis);
+CCE_PUBLIC_OPTIONS uint32_t cceGetMapsAtPointWorldMap2D (struct cce_worldvec2 point, uint32_t *mapIDs, uint32_t maxQuantity);
+CCE_PUBLIC_OPTIONS struct cce_worldvec2 cceGetCameraWorldMap2D (void);
+CCE_PUBLIC_OPTIONS int cceBakeMap2D (uint16_t number, const char *texturesPath, uint32_t textureMaxWidth, uint32_t textureMaxHeight);
 CCE_PUBLIC_OPTIONS int cceInitEngine2D (uint16_t globalBoolsQuantity, uint32_t textureMaxWidth, uint32_t textureMaxHeight,
                                         const char *windowLabel, const char *resourcePath, cce_flag flags);
 CCE_PUBLIC_OPTIONS uint8_t cceRegisterAction (uint32_t ID, void (*action)(void*), void (*endianSwap)(void*));
 CCE_PUBLIC_OPTIONS void cceSetTexturesPath (const char *path);
+CCE_PUBLIC_OPTIONS int cceSetTextureCache (const char *folderName);
+CCE_PUBLIC_OPTIONS void cceSetTexturesMemoryBudget (size_t budget);
+CCE_PUBLIC_OPTIONS void cceSetLogicTickRate (uint16_t ticksPerSecond);
+CCE_PUBLIC_OPTIONS struct TextureResidencyStats cceGetTextureResidencyStats (void);
 CCE_PUBLIC_OPTIONS int cceEngine2D (void);
 CCE_PUBLIC_OPTIONS void cceSetLoadedMap2D (uint16_t number, struct cce_i32vec2 globalPosition);
 CCE_PUBLIC_OPTIONS extern const uint16_t *const cceLoadedMap2Dnumber;
 CCE_PUBLIC_OPTIONS extern const struct cce_u32vec2 *cceTextureSize;
 CCE_PUBLIC_OPTIONS const char* cceGetResourcePath (void);
 CCE_PUBLIC_OPTIONS uint16_t cceLoadTexture (char *path);
+CCE_PUBLIC_OPTIONS uint16_t cceLoadPackedTexture (const char *name);
 
 // dynamicMap2D
 
@@ -0,0 +1,53 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#ifndef RESOURCE_PACK_H
+#define RESOURCE_PACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdio.h>
+#include <stdint.h>
+#include "engine_common.h"
+
+/* Resource types of pack index entries */
+#define CCE_RESOURCE_MAP2D       0x1 /* map_<ID>.c2m */
+#define CCE_RESOURCE_BAKED_MAP2D 0x2 /* map_<ID>.c2b */
+#define CCE_RESOURCE_IMAGE       0x3 /* img_<ID>.png */
+#define CCE_RESOURCE_FILE        0x4 /* Any other file, ID is cceResourceNameHash of path relative to pack root ("fonts/font.ini") */
+#define CCE_RESOURCE_WORLD_MAP2D 0x5 /* world_<ID>.c2w */
+
+#define CCE_RESOURCE_DUMMY_IMAGE UINT32_MAX /* ID of dummy.png among CCE_RESOURCE_IMAGE */
+
+CCE_PUBLIC_OPTIONS int   cceOpenResourcePack (const char *path);
+CCE_PUBLIC_OPTIONS void  cceCloseResourcePack (void);
+CCE_PUBLIC_OPTIONS const void* cceGetPackedResource (cce_enum type, uint32_t ID, size_t *size);
+CCE_PUBLIC_OPTIONS FILE* cceOpenPackedResource (cce_enum type, uint32_t ID, size_t *size);
+CCE_PUBLIC_OPTIONS uint32_t cceResourceNameHash (const char *name);
+CCE_PUBLIC_OPTIONS int   cceCreateResourcePack (const char *outputPath, const char *rootPath, const char *const *files, size_t filesQuantity);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // RESOURCE_PACK_H
@@ -87,6 +87,16 @@ struct UnicodeCharWithSize
    uint32_t size;
 };
 
+/* State of incremental cceHash64, fields are private */
+struct cce_hash64State
+{
+   uint64_t accumulators[4];
+   uint64_t seed;
+   uint64_t totalSize;
+   uint8_t  buffer[32];
+   size_t   bufferedSize;
+};
+
 CCE_PUBLIC_OPTIONS size_t cceBinarySearch (const void *const array, size_t arraySize, size_t typeSize, size_t step, size_t value);
 CCE_PUBLIC_OPTIONS char*  cceReverseMemory (char *memory, size_t size);
 CCE_PUBLIC_OPTIONS uint32_t cceGetCharSizeUTF8 (const unsigned char *ch);
@@ -94,4 +104,10 @@ CCE_PUBLIC_OPTIONS uint32_t cceGetCharUTF8 (const unsigned char *ch);
 CCE_PUBLIC_OPTIONS struct UnicodeCharWithSize cceGetCharWithSizeUTF8 (const unsigned char *ch);
 CCE_PUBLIC_OPTIONS uint32_t cceGetCharFromStringUTF8 (const char *string, size_t position);
 
+/* xxHash64-compatible hash of data, cceHash64Init/Update/Final hash data given in parts */
+CCE_PUBLIC_OPTIONS uint64_t cceHash64 (const void *data, size_t size, uint64_t seed);
+CCE_PUBLIC_OPTIONS void     cceHash64Init (struct cce_hash64State *state, uint64_t seed);
+CCE_PUBLIC_OPTIONS void     cceHash64Update (struct cce_hash64State *state, const void *data, size_t size);
+CCE_PUBLIC_OPTIONS uint64_t cceHash64Final (const struct cce_hash64State *state);
+
 #endif // UTILS_H
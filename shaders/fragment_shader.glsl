@@ -23,13 +23,31 @@ out vec4 FragColor;
 
 in vec4     Color;
 flat in int TextureID; // From 1
+flat in int TextureLayer;
+flat in int TexturePage;
 in vec2     TextureCoord;
+flat in vec4 TextureRectangle;
 
-uniform sampler2DArray Textures;
+uniform sampler2DArray Textures[8];
 const vec4 white = vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
 void main()
 {
    int isTexture = min(TextureID, 1);
-   FragColor = mix(white, texture(Textures, vec3(TextureCoord.xy, TextureID - isTexture)), isTexture) * mix(white, vec4(Color.xyz, 1.0f), Color.w);
+   // Images share layers of texture atlas, so texture offset repeats the image inside its own rectangle only
+   vec3 coords = vec3(TextureRectangle.xy + mod(TextureCoord, TextureRectangle.zw), TextureLayer);
+   vec4 textureColor;
+   // GLSL 3.30 can't index sampler arrays with a variable
+   switch (TexturePage)
+   {
+      case 0: textureColor = texture(Textures[0], coords); break;
+      case 1: textureColor = texture(Textures[1], coords); break;
+      case 2: textureColor = texture(Textures[2], coords); break;
+      case 3: textureColor = texture(Textures[3], coords); break;
+      case 4: textureColor = texture(Textures[4], coords); break;
+      case 5: textureColor = texture(Textures[5], coords); break;
+      case 6: textureColor = texture(Textures[6], coords); break;
+      default: textureColor = texture(Textures[7], coords); break;
+   }
+   FragColor = mix(white, textureColor, isTexture) * mix(white, vec4(Color.xyz, 1.0f), Color.w);
 }
@@ -18,22 +18,21 @@
     USA
 */
 
-// For gl version 3.2 core and above
-layout (location = 0) in ivec2 aCoords;
-layout (location = 1) in ivec2 aPosition;
-layout (location = 2) in vec2  aTexturePieceCoords;
-layout (location = 3) in ivec4 aMoveIDs;
-layout (location = 4) in ivec4 aExtendIDs;
-layout (location = 5) in ivec2 aTransform; // r - rotateID, g - isGlobalOffset
-layout (location = 6) in vec2  aTextureFragmentSize;
-layout (location = 7) in int   aTextureID;
+// For gl version 3.3 core and above
+// Everything is per instance (one element), corner of the quad is taken from gl_VertexID (triangle strip of 4 vertices)
+layout (location = 0) in ivec2 aPosition;
+layout (location = 1) in ivec2 aSize;
+layout (location = 2) in ivec2 aTextureOrigin; // Bottom left corner of the piece in the image, in pixels
+layout (location = 3) in ivec2 aTextureSize;
+layout (location = 4) in int   aTextureID;
+layout (location = 5) in ivec2 aTransform; // r - rotateID, g - flags: 1 - is global offset
+layout (location = 6) in ivec4 aMoveIDs;
+layout (location = 7) in ivec4 aExtendIDs;
 layout (location = 8) in ivec4 aTextureOffsetIDs;
 layout (location = 9) in ivec4 aColorIDs;
 
 layout (packed) uniform Variables
 {
-   ivec2 MoveCoords     [255];
-   ivec2 Extension      [255];
    vec4  Colors         [255];
    ivec2 TextureOffset  [255];
    ivec2 RotationOffset [255];
@@ -43,15 +42,38 @@ layout (packed) uniform Variables
 uniform vec2  InverseStep = vec2(0.125f, 0.125f);
 uniform ivec2 GlobalMoveCoords = ivec2(0, 0);
 uniform ivec2 MapOffset = ivec2(0, 0);
+uniform int   Pass = 0; // 1 - only opaque elements, 2 - only translucent ones, 0 - all
+uniform int   OrderOffset = 0; // Order of the first drawn instance among all elements of the frame
+uniform sampler2DArray Textures[8]; // Pages, all of the same size
+uniform usamplerBuffer TextureRectangles; // Texel 2 * (ID - 1): x, y - place of the image in its layer, z - layer, w - page (bit 15 - image is opaque)
+                                          // Next one: x, y - size of the image
+uniform isamplerBuffer GroupValues; // Texel 2 * (ID - 1) is move value of group ID, next one is its extension value
+uniform int   GroupValuesOffset = 0; // In texels, GroupValues has a copy for every segment of its stream buffer
+uniform int   GroupValuesQuantity = 0; // Groups past it have no values in GroupValues, they are neither moved nor extended
 
-out vec2 TextureCoord;
+
+out vec2 TextureCoord; // Relative to TextureRectangle, wrapped by fragment shader
+flat out vec4 TextureRectangle; // xy - origin of the image, zw - its size, in layer coordinates
 flat out int TextureID;
+flat out int TextureLayer;
+flat out int TexturePage;
 out vec4 Color;
 
 void main()
 {
+   ivec2 corner = ivec2(gl_VertexID >> 1, gl_VertexID & 1);
+   ivec2 vertexCoords = (corner * 2 - 1) * aSize;
    TextureID = aTextureID;
+   int isOpaque; // Elements without texture are opaque, textured ones are opaque only once their image is uploaded and has no translucent texels
    {
+      int isTexture = min(aTextureID, 1);
+      uvec4 rectangle = texelFetch(TextureRectangles, (aTextureID - isTexture) * 2);
+      vec2  layerSize = vec2(textureSize(Textures[0], 0).xy);
+      TextureRectangle = vec4(vec2(rectangle.xy), vec2(texelFetch(TextureRectangles, (aTextureID - isTexture) * 2 + 1).xy)) / layerSize.xyxy;
+      TextureRectangle.zw += float(1 - isTexture); // Never zero, mod() in fragment shader of untextured element doesn't give NaN
+      TextureLayer = int(rectangle.z);
+      TexturePage = int(rectangle.w & 0x7FFFu);
+      isOpaque = 1 - isTexture * (1 - int(rectangle.w >> 15u));
       ivec4 isTextureOffset = min(aTextureOffsetIDs, 1);
       ivec4 textureOffsetIDs = aTextureOffsetIDs - isTextureOffset;
       mat4x2 textureOffsets;
@@ -59,7 +81,7 @@ void main()
       textureOffsets[1] = TextureOffset[textureOffsetIDs.y];
       textureOffsets[2] = TextureOffset[textureOffsetIDs.z];
       textureOffsets[3] = TextureOffset[textureOffsetIDs.w];
-      TextureCoord = aTexturePieceCoords + ((textureOffsets * isTextureOffset) * aTextureFragmentSize);
+      TextureCoord = (vec2(aTextureOrigin + corner * aTextureSize) + (textureOffsets * isTextureOffset) * vec2(aTextureSize)) / layerSize;
    }
    {
       ivec4 isColor = min(aColorIDs, 1);
@@ -71,28 +93,25 @@ void main()
       colors[3] = Colors[colorIDs.w];
       Color = colors * isColor;
    }
-   vec2 offset;
+   ivec2 position;
    {
-      ivec4  isMoveGroup = min(aMoveIDs, 1);
-      ivec4  moveIDs = aMoveIDs - isMoveGroup;
-      mat4x2 moveOffsets;
-      moveOffsets[0] = MoveCoords[moveIDs.x];
-      moveOffsets[1] = MoveCoords[moveIDs.y];
-      moveOffsets[2] = MoveCoords[moveIDs.z];
-      moveOffsets[3] = MoveCoords[moveIDs.w];
-
-      offset = moveOffsets * isMoveGroup + GlobalMoveCoords * aTransform.g + MapOffset;
+      ivec4  isMoveGroup = min(aMoveIDs, 1) * ivec4(lessThanEqual(aMoveIDs, ivec4(GroupValuesQuantity)));
+      ivec4  moveTexels = GroupValuesOffset + (aMoveIDs - 1) * isMoveGroup * 2; // Ungrouped and out of range read the first texel
+      // Summed as integers, so only position relative to the screen gets to float and there's no jitter far from (0, 0)
+      position = aPosition + texelFetch(GroupValues, moveTexels.x).xy * isMoveGroup.x + texelFetch(GroupValues, moveTexels.y).xy * isMoveGroup.y +
+                 texelFetch(GroupValues, moveTexels.z).xy * isMoveGroup.z + texelFetch(GroupValues, moveTexels.w).xy * isMoveGroup.w +
+                 GlobalMoveCoords * (aTransform.g & 1) + MapOffset;
    }
    vec2 extension;
    {
-      ivec4 isExtensionGroup = min(aExtendIDs, 1);
-      ivec4 extendIDs = aExtendIDs - isExtensionGroup;
+      ivec4 isExtensionGroup = min(aExtendIDs, 1) * ivec4(lessThanEqual(aExtendIDs, ivec4(GroupValuesQuantity)));
+      ivec4 extendTexels = GroupValuesOffset + (aExtendIDs - 1) * isExtensionGroup * 2 + 1;
       mat4x2 extensions;
-      extensions[0] = Extension[extendIDs.x];
-      extensions[1] = Extension[extendIDs.y];
-      extensions[2] = Extension[extendIDs.z];
-      extensions[3] = Extension[extendIDs.w];
-      extension = extensions * isExtensionGroup * sign(aCoords) * 0.5f;
+      extensions[0] = vec2(texelFetch(GroupValues, extendTexels.x).xy);
+      extensions[1] = vec2(texelFetch(GroupValues, extendTexels.y).xy);
+      extensions[2] = vec2(texelFetch(GroupValues, extendTexels.z).xy);
+      extensions[3] = vec2(texelFetch(GroupValues, extendTexels.w).xy);
+      extension = extensions * isExtensionGroup * sign(vertexCoords) * 0.5f;
    }
    {
        int  isRotate = min(aTransform.r, 1);
@@ -102,10 +121,16 @@ void main()
        rotate[1] = rotate[0].yx;
        rotate[1].x *= -1;
        vec2  rotationOffset = (RotationOffset[aTransform.r - isRotate].xy * isRotate) * 0.5f * InverseStep;
-       vec2 coords = aCoords * 0.5f * InverseStep + rotationOffset;
+       vec2 coords = vertexCoords * 0.5f * InverseStep + rotationOffset;
        //coords = vec2(coords.x * RotateAngleCos - coords.y * RotateAngleSin, coords.y * RotateAngleCos + coords.x * RotateAngleSin) - rotationOffset;
-       vec2 position = (aPosition + offset + extension + abs(aCoords) * 0.5f) * InverseStep;
-       gl_Position = vec4(coords * rotate + position - rotationOffset, 0.0f, 1.0f);
+       vec2 screenPosition = (vec2(position) + extension + abs(vertexCoords) * 0.5f) * InverseStep;
+       gl_Position = vec4(coords * rotate + screenPosition - rotationOffset, 0.0f, 1.0f);
+   }
+   // Later elements are nearer, so the depth test keeps the painter's order
+   gl_Position.z = 1.0f - float(OrderOffset + gl_InstanceID + 1) * (1.0f / 1048576.0f);
+   {
+      if ((Pass == 1 && isOpaque == 0) || (Pass == 2 && isOpaque == 1))
+         gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f); // Outside of the clip volume, the element is drawn by the other pass
    }
 }
 
@@ -30,6 +30,7 @@
 #include "../include/coffeechain/utils.h"
 #include "../include/coffeechain/os_interaction.h"
 #include "../include/coffeechain/endianess.h"
+#include "../include/coffeechain/resource_pack.h"
 
 #include "engine_common_internal.h"
 #include "shader.h"
@@ -57,6 +58,11 @@ void (*cce__toFullscreen) (void);
 void (*cce__toWindow) (void);
 void (*cce__showWindow) (void);
 void (*cce__swapBuffers) (void);
+void (*cce__makeContextCurrent) (uint8_t isCurrent);
+void (*cce__glBufferStorage) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+void (*cce__glGetProgramBinary) (GLuint program, GLsizei bufferSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+void (*cce__glProgramBinary) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+void (*cce__glProgramParameteri) (GLuint program, GLenum name, GLint value);
 CCE_PUBLIC_OPTIONS void (*cceSetWindowParameters) (cce_enum parameter, uint32_t a, uint32_t b);
 
 void cce__callActions (void (**doAction)(void*), uint8_t actionsQuantity, uint32_t *actionIDs, uint32_t *actionArgOffsets, cce_void *actionArgs)
@@ -861,7 +867,9 @@ void cce__terminateEngine (void)
    }
    free(g_temporaryBools);
    cce__terminateEngine__api();
+   cce__terminateShaderCache();
    cceTerminateTemporaryDirectory();
+   cceCloseResourcePack();
 }
 
 void cce__doNothing (void)
@@ -63,7 +63,7 @@ void cce__writeGroups (uint16_t groupsQuantity, struct ElementGroup *groups, FIL
       if (!iterator->elementsQuantity)
          continue;
 
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          uint32_t elementID;
          for (uint32_t *jiterator = iterator->elements, *jend = iterator->elements + iterator->elementsQuantity; jiterator < jend; ++jiterator)
@@ -115,14 +115,14 @@ struct ElementLogic* cce__loadLogic (uint32_t logicQuantity, FILE *map_f, void (
       fread(&(iterator->actionsQuantity),       1u/*uint8_t*/,   1u,                                                        map_f);
       (iterator->actionIDs) = (uint32_t *) malloc((iterator->actionsQuantity) * sizeof(uint32_t));
       fread( (iterator->actionIDs),             4u/*uint32_t*/,  (iterator->actionsQuantity),                               map_f);
-      cceLittleEndianToBigEndianArrayInt32(iterator->actionIDs, iterator->actionsQuantity);
+      cceLittleEndianToHostEndianArrayInt32(iterator->actionIDs, iterator->actionsQuantity);
       (iterator->actionsArgOffsets) = (uint32_t *) malloc((iterator->actionsQuantity + 1u) * sizeof(uint32_t));
       *(iterator->actionsArgOffsets) = 0u;
       fread( (iterator->actionsArgOffsets + 1), 4u/*uint32_t*/,  (iterator->actionsQuantity),                               map_f);
-      cceLittleEndianToBigEndianArrayInt32((iterator->actionsArgOffsets + 1), iterator->actionsQuantity);
+      cceLittleEndianToHostEndianArrayInt32((iterator->actionsArgOffsets + 1), iterator->actionsQuantity);
       (iterator->actionsArg) = (cce_void *) malloc(*(iterator->actionsArgOffsets + iterator->actionsQuantity)/* sizeof(cce_void) */);
       fread( (iterator->actionsArg),            1u/*cce_void*/, *(iterator->actionsArgOffsets + iterator->actionsQuantity), map_f);
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          cce__callActions(endianConvertAction, iterator->actionsQuantity, iterator->actionIDs, iterator->actionsArgOffsets, iterator->actionsArg);
       }
@@ -143,7 +143,7 @@ void cce__writeLogic (uint32_t logicQuantity, struct ElementLogic *logic, FILE *
    for (struct ElementLogic *iterator = logic; iterator <= end; ++iterator)
    {
       fwrite(&(iterator->logicElementsQuantity), 1u/*uint8_t*/,   1u,                                                        map_f);
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          for (uint16_t *jiterator = iterator->logicElements, *jend = iterator->logicElements + iterator->logicElementsQuantity; jiterator < jend; ++jiterator)
          {
@@ -161,7 +161,7 @@ void cce__writeLogic (uint32_t logicQuantity, struct ElementLogic *logic, FILE *
       if (operationsQuantityInBytes > sizeof(uint_fast16_t))
       {
 
-         if (*g_endianess == CCE_BIG_ENDIAN)
+         if (cceHostEndianess == CCE_BIG_ENDIAN)
          {
             bufferfast16array = realloc(bufferfast16array, operationsQuantityInBytes);
             cceBigEndianToLittleEndianNewArrayIntN(bufferfast16array, iterator->operations, operationsQuantityInBytes >> SHIFT_OF_FAST_SIZE, sizeof(uint_fast16_t));
@@ -181,7 +181,7 @@ void cce__writeLogic (uint32_t logicQuantity, struct ElementLogic *logic, FILE *
       buffer64 = cceHostEndianToLittleEndianInt64(iterator->elementType);
       fwrite(&buffer64,                          8u/*uint64_t*/,  1u,                                                        map_f);
       fwrite(&(iterator->actionsQuantity),       1u/*uint8_t*/,   1u,                                                        map_f);
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          for (uint32_t *jiterator = iterator->actionIDs, *jend = iterator->actionIDs + iterator->actionsQuantity; jiterator < jend; ++jiterator)
          {
@@ -222,12 +222,12 @@ void cce__writeLogic (uint32_t logicQuantity, struct ElementLogic *logic, FILE *
          fwrite(iterator->actionsArgOffsets + 1, 4u/*uint32_t*/,  (iterator->actionsQuantity),                               map_f);
          fwrite( (iterator->actionsArg),         1u/*cce_void*/, *(iterator->actionsArgOffsets + iterator->actionsQuantity), map_f);
       }
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          cce__callActions(endianConvertAction, iterator->actionsQuantity, iterator->actionIDs, iterator->actionsArgOffsets, iterator->actionsArg);
       }
    }
-   if (*g_endianess == CCE_BIG_ENDIAN)
+   if (cceHostEndianess == CCE_BIG_ENDIAN)
    {
       free(bufferfast16array);
    }
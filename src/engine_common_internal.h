@@ -89,6 +89,7 @@ void cce__releaseTemporaryBools (uint16_t ID);
 void cce__releaseUnusedTemporaryBools (uint16_t ID);
 void cce__setCurrentTemporaryBools (uint16_t temporaryBoolsID);
 void cce__engineUpdate (void);
+void cce__setLogicTime (double currentTime, double deltaTime);
 void cce__doNothing (void);
 void cce__shortToString (char *str, const unsigned short number, const char *strEnd);
 
@@ -97,6 +98,19 @@ extern void (*cce__toWindow) (void);
 extern void (*cce__showWindow) (void);
 extern void (*cce__swapBuffers) (void);
 extern struct cce_u32vec2 (*cce__getCurrentStep) (void);
+/* Makes GL context current to the calling thread or releases it */
+extern void (*cce__makeContextCurrent) (uint8_t isCurrent);
+/* glad is generated for OpenGL 3.3 core, so ARB_buffer_storage is loaded by platform code. NULL if it isn't supported */
+extern void (*cce__glBufferStorage) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+/* ARB_get_program_binary, NULL if it isn't supported */
+extern void (*cce__glGetProgramBinary) (GLuint program, GLsizei bufferSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+extern void (*cce__glProgramBinary) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+extern void (*cce__glProgramParameteri) (GLuint program, GLenum name, GLint value);
+
+uint8_t cce__isRenderThreadEnabled (void);
+int  cce__startRenderThread (void);
+void cce__stopRenderThread (void);
+void cce__callOnRenderThread (void (*function) (void));
 
 #ifdef __cplusplus
 }
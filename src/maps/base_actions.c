@@ -46,7 +46,6 @@ static const GLint *g_uniformBufferSize;
 static GLuint g_shaderProgram;
 cce_void *g_currentMapBuffer = NULL;
 cce_void *g_dynamicMapBuffer = NULL;
-static void (*g_setUniformBufferToDefault)(GLuint, GLint);
 static uint32_t actionsQuantity;
 static GLint uniformOffset;
 static cce_flag *map2Dflags;
@@ -166,33 +165,33 @@ static void delayActionAction (void *data)
 static void moveActionSwapEndian (void *data)
 {
    struct moveActionStruct *params = (struct moveActionStruct*) data;
-   cceSwapEndianArrayIntN(&(params->coords), 2, 4);
+   cceSwapEndianArrayInt32(&(params->coords), 2);
    params->groupID = cceSwapEndianInt16(params->groupID);
 }
 
 static void extendActionSwapEndian (void *data)
 {
    struct extendActionStruct *params = (struct extendActionStruct*) data;
-   cceSwapEndianArrayIntN(&(params->change), 2, 4);
+   cceSwapEndianArrayInt32(&(params->change), 2);
    params->groupID = cceSwapEndianInt16(params->groupID);
 }
 
 static void rotateActionSwapEndian (void *data)
 {
    struct rotateActionStruct *params = (struct rotateActionStruct*) data;
-   cceSwapEndianArrayIntN(&(params->offset), 3, 4); // Assuming float endianess is the same as int's
+   cceSwapEndianArrayInt32(&(params->offset), 3); // Assuming float endianess is the same as int's
 }
 
 static void offsetTextureActionSwapEndian (void *data)
 {
    struct offsetTextureActionStruct *params = (struct offsetTextureActionStruct*) data;
-   cceSwapEndianArrayIntN(&(params->offset), 2, 4);
+   cceSwapEndianArrayInt32(&(params->offset), 2);
 }
 
 static void changeColorActionSwapEndian (void *data)
 {
    struct changeColorActionStruct *params = (struct changeColorActionStruct*) data;
-   cceSwapEndianArrayIntN(&(params->red), 4, 4); // Assuming float endianess is the same as int's
+   cceSwapEndianArrayInt32(&(params->red), 4); // Assuming float endianess is the same as int's
 }
 
 static void setBoolActionSwapEndian (void *data)
@@ -229,7 +228,7 @@ static void loadMap2DActionSwapEndian (void *data)
 {
    struct loadMap2DactionStruct *params = (struct loadMap2DactionStruct*) data;
    params->ID = cceSwapEndianInt16(params->ID);
-   cceSwapEndianArrayIntN((int32_t*) &(params->offset), 2, 4);
+   cceSwapEndianArrayInt32((int32_t*) &(params->offset), 2);
 }
 
 static void delayActionActionSwapEndian (void *data)
@@ -245,23 +244,18 @@ static void delayActionActionSwapEndian (void *data)
 void cce__beginBaseActions (struct Map2D *map)
 {
    currentMap = map;
-   if ((g_UBOs + currentMap->UBO_ID)->flags & 0x4)
+   struct UsedUBO *ubo = g_UBOs + currentMap->UBO_ID;
+   if (ubo->flags & 0x4)
    {
-      g_setUniformBufferToDefault((g_UBOs + currentMap->UBO_ID)->UBO, *(g_uniformsOffsets + 6));
-      (g_UBOs + currentMap->UBO_ID)->flags &= 0x1;
+      cce__setUBOtoDefault(ubo);
+      ubo->flags &= 0x1;
    }
-   glBindBuffer(GL_UNIFORM_BUFFER, (g_UBOs + currentMap->UBO_ID)->UBO);
-   GL_CHECK_ERRORS;
-   g_currentMapBuffer = glMapBufferRange(GL_UNIFORM_BUFFER, uniformOffset, *g_uniformBufferSize - uniformOffset, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
-   GL_CHECK_ERRORS;
+   /* Actions work on CPU copies, which are streamed to GPU once in endBaseActionsCommon */
+   g_currentMapBuffer = ubo->data + uniformOffset;
    if (g_dynamicMapBuffer == NULL)
    {
-      glBindBuffer(GL_UNIFORM_BUFFER, (g_UBOs + g_dynamicMap->UBO_ID)->UBO);
-      GL_CHECK_ERRORS;
-      g_dynamicMapBuffer = glMapBufferRange(GL_UNIFORM_BUFFER, uniformOffset, *g_uniformBufferSize - uniformOffset, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
-      GL_CHECK_ERRORS;
+      g_dynamicMapBuffer = (g_UBOs + g_dynamicMap->UBO_ID)->data + uniformOffset;
    }
-   glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 static void runDelayedActions (struct list *delayedActions)
@@ -296,28 +290,12 @@ CONTINUE:
    }
 }
 
+/* Only groups changed by actions are streamed */
 static void endBaseActionsCommon (uint16_t uboID)
 {
    struct UsedUBO *ubo = (g_UBOs + uboID);
-   glBindBuffer(GL_UNIFORM_BUFFER, ubo->UBO);
-   GL_CHECK_ERRORS;
-   glUnmapBuffer(GL_UNIFORM_BUFFER);
-   GL_CHECK_ERRORS;
-   if (ubo->moveGroupValuesQuantity == 0 && ubo->extensionGroupValuesQuantity == 0)
-      return;
-   struct cce_i32vec2 *buffer = glMapBufferRange(GL_UNIFORM_BUFFER, *(g_uniformsOffsets + CCE_MOVEGROUP_OFFSET), 2 * sizeof(struct cce_i32vec2) * 255,
-                                               GL_MAP_WRITE_BIT | (GL_MAP_INVALIDATE_RANGE_BIT * (((ubo->moveGroupValuesQuantity)      >= 255) &&
-                                                                                                  ((ubo->extensionGroupValuesQuantity) >= 255))));
-   GL_CHECK_ERRORS;
-   memcpy(buffer, ubo->moveGroupValues, MIN(ubo->moveGroupValuesQuantity, 255) * sizeof(struct cce_i32vec2));
-   buffer += 255;
-   struct cce_i16vec2 *extensionValues = ubo->extensionGroupValues;
-   for (struct cce_i32vec2 *end = buffer + MIN(ubo->extensionGroupValuesQuantity, 255); buffer < end; ++buffer, ++extensionValues)
-   {
-      *buffer = (struct cce_i32vec2) {extensionValues->x, extensionValues->y};
-   }
-   glUnmapBuffer(GL_UNIFORM_BUFFER);
-   GL_CHECK_ERRORS;
+   cce__uploadChangedGroupValuesUBO(ubo);
+   cce__uploadChangedUBO(ubo);
 }
 
 void cce__endBaseActions (void)
@@ -347,8 +325,7 @@ void cce__setCurrentArrayOfMaps (const struct Map2Darray *maps)
 }
 
 void cce__baseActionsInit (struct DynamicMap2D *dynamic_map, struct UsedUBO *UBOs, const GLint *bufferUniformsOffsets, 
-                           const GLint *uniformLocations, GLuint shaderProgram, void (*setUniformBufferToDefault)(GLuint, GLint),
-                           const GLint *uniformBufferSize, cce_flag *flags)
+                           const GLint *uniformLocations, GLuint shaderProgram, const GLint *uniformBufferSize, cce_flag *flags)
 {
    map2Dflags = flags;
    g_dynamicMap = dynamic_map;
@@ -356,7 +333,6 @@ void cce__baseActionsInit (struct DynamicMap2D *dynamic_map, struct UsedUBO *UBO
    g_uniformsOffsets = bufferUniformsOffsets;
    g_uniformLocations = uniformLocations;
    g_shaderProgram = shaderProgram;
-   g_setUniformBufferToDefault = setUniformBufferToDefault;
    g_uniformBufferSize = uniformBufferSize;
    uniformOffset = *(g_uniformsOffsets + CCE_COLORGROUP_OFFSET);
    actionsQuantity = CCE_BASIC_ACTIONS_QUANTITY + CCE_ALLOCATION_STEP;
@@ -427,7 +403,7 @@ CCE_PUBLIC_OPTIONS void cceMoveGlobalOffsetGroupMap2D (int32_t x, int32_t y, cce
    struct Map2D *map = allMaps->main;
    if (map->moveGroupsQuantity > 0)
       moveElements(&(map->colliders->x), &(map->colliders->y), sizeof(struct Map2DCollider), map->moveGroups, -x, -y);
-   for (struct Map2D **iterator = allMaps->dependies, **end = allMaps->dependies + allMaps->main->exitMapsQuantity; iterator < end; ++iterator)
+   for (struct Map2D **iterator = allMaps->dependies, **end = allMaps->dependies + allMaps->dependiesQuantity; iterator < end; ++iterator)
    {
       if ((*iterator)->moveGroupsQuantity > 0)
          moveElements(&((*iterator)->colliders->x), &((*iterator)->colliders->y), sizeof(struct Map2DCollider), (*iterator)->moveGroups, -x, -y);
@@ -495,6 +471,7 @@ CCE_PUBLIC_OPTIONS void cceMoveGroupMap2D (uint16_t groupID, int32_t x, int32_t
       }
       default: return;
    }
+   cce__setGroupValueChangedUBO(ubo, CCE_GROUPVALUES_MOVE, groupID - 1u);
    if (group != NULL)
       moveElements(firstElementX, firstElementY, elementSize, group, x, y);
 }
@@ -554,6 +531,7 @@ CCE_PUBLIC_OPTIONS void cceExtendGroupMap2D (uint16_t groupID, int32_t x, int32_
          break;
       }
    }
+   cce__setGroupValueChangedUBO(ubo, CCE_GROUPVALUES_EXTENSION, groupID - 1u);
    if (group == NULL)
       return;
    for (uint32_t *iterator = (group + groupID - 1u)->elements, *end = (group + groupID - 1u)->elements + (group + groupID - 1u)->elementsQuantity; iterator < end; ++iterator)
@@ -606,6 +584,8 @@ CCE_PUBLIC_OPTIONS void cceRotateGroupMap2D (uint8_t groupID, float normalizedAn
    (((struct cce_f32vec2*)  (glBuffer + *(g_uniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET) - uniformOffset)) + (groupID - 1u))->y = cos;
    (((struct cce_i32vec2*) (glBuffer + *(g_uniformsOffsets + CCE_ROTATIONOFFSET_OFFSET)    - uniformOffset)) + (groupID - 1u))->x = xOffset;
    (((struct cce_i32vec2*) (glBuffer + *(g_uniformsOffsets + CCE_ROTATIONOFFSET_OFFSET)    - uniformOffset)) + (groupID - 1u))->y = yOffset;
+   cce__setGroupChangedUBO(ubo, CCE_ROTATEANGLESINCOS_OFFSET, groupID - 1u);
+   cce__setGroupChangedUBO(ubo, CCE_ROTATIONOFFSET_OFFSET, groupID - 1u);
 }
 
 /* Group iteration is from 1, not 0 */
@@ -614,12 +594,15 @@ CCE_PUBLIC_OPTIONS void cceChangeColorGroupMap2D (uint8_t groupID, float r, floa
    if (groupID == 0u) return;
 
    cce_void *glBuffer;
+   struct UsedUBO *ubo;
    switch (mapType)
    {
       case CCE_CURRENT_MAP2D:
+         ubo = (g_UBOs + currentMap->UBO_ID);
          glBuffer = g_currentMapBuffer;
          break;
       case CCE_DYNAMIC_MAP2D:
+         ubo = (g_UBOs + g_dynamicMap->UBO_ID);
          glBuffer = g_dynamicMapBuffer;
          break;
       default: return;
@@ -629,6 +612,7 @@ CCE_PUBLIC_OPTIONS void cceChangeColorGroupMap2D (uint8_t groupID, float r, floa
    *(((float*) (glBuffer + *(g_uniformsOffsets + CCE_COLORGROUP_OFFSET) - uniformOffset)) + (groupID - 1u) * 4u + 1u) = g;
    *(((float*) (glBuffer + *(g_uniformsOffsets + CCE_COLORGROUP_OFFSET) - uniformOffset)) + (groupID - 1u) * 4u + 2u) = b;
    *(((float*) (glBuffer + *(g_uniformsOffsets + CCE_COLORGROUP_OFFSET) - uniformOffset)) + (groupID - 1u) * 4u + 3u) = a;
+   cce__setGroupChangedUBO(ubo, CCE_COLORGROUP_OFFSET, groupID - 1u);
 }
 
 CCE_PUBLIC_OPTIONS void cceOffsetTextureGroupMap2D (uint8_t groupID, int32_t offsetX, int32_t offsetY, cce_enum mapType)
@@ -636,12 +620,15 @@ CCE_PUBLIC_OPTIONS void cceOffsetTextureGroupMap2D (uint8_t groupID, int32_t off
    if (groupID == 0u) return;
 
    cce_void *glBuffer;
+   struct UsedUBO *ubo;
    switch (mapType)
    {
       case CCE_CURRENT_MAP2D:
+         ubo = (g_UBOs + currentMap->UBO_ID);
          glBuffer = g_currentMapBuffer;
          break;
       case CCE_DYNAMIC_MAP2D:
+         ubo = (g_UBOs + g_dynamicMap->UBO_ID);
          glBuffer = g_dynamicMapBuffer;
          break;
       default: return;
@@ -649,6 +636,7 @@ CCE_PUBLIC_OPTIONS void cceOffsetTextureGroupMap2D (uint8_t groupID, int32_t off
 
    (((struct cce_i32vec2*) (glBuffer + *(g_uniformsOffsets + CCE_TEXTUREOFFSET_OFFSET) - uniformOffset)) + (groupID - 1u))->x = offsetX;
    (((struct cce_i32vec2*) (glBuffer + *(g_uniformsOffsets + CCE_TEXTUREOFFSET_OFFSET) - uniformOffset)) + (groupID - 1u))->y = offsetY;
+   cce__setGroupChangedUBO(ubo, CCE_TEXTUREOFFSET_OFFSET, groupID - 1u);
 }
 
 CCE_PUBLIC_OPTIONS void cceDelayActionMap2D (uint32_t actionID, uint32_t actionStructSize, void *actionStruct,
@@ -45,14 +45,44 @@ void cce__setToBeProcessedDynamicMap2D (void)
    g_flags |= CCE_DYNAMIC_MAP2D_TO_BE_PROCESSED;
 }
 
-static inline void bindVBOtoVAO (GLuint VBO, GLuint VAO)
+/* Element's instance will be rebuilt and uploaded by cce__processDynamicMap2DElements, it doesn't look at other elements */
+static void setElementChangedDynamicMap2D (uint32_t ID)
+{
+   struct DynamicMap2DElement *element = g_dynamicMap->elements + ID;
+   g_flags |= CCE_DYNAMIC_MAP2D_TO_BE_PROCESSED;
+   if (element->flags & 0x4)
+      return;
+   
+   element->flags |= 0x4;
+   if (g_dynamicMap->dirtyElementsQuantity >= g_dynamicMap->dirtyElementsQuantityAllocated)
+   {
+      CCE_REALLOC_ARRAY(g_dynamicMap->dirtyElements, g_dynamicMap->dirtyElementsQuantity + 1u);
+   }
+   *(g_dynamicMap->dirtyElements + g_dynamicMap->dirtyElementsQuantity) = ID;
+   ++(g_dynamicMap->dirtyElementsQuantity);
+}
+
+/* Moves dynamic map's origin into elements, only global offset elements have to be uploaded again */
+void cce__rebaseDynamicMap2D (void)
+{
+   for (struct DynamicMap2DElement *iterator = g_dynamicMap->elements, *end = g_dynamicMap->elements + g_dynamicMap->elementsQuantity; iterator < end; ++iterator)
+   {
+      iterator->x += g_dynamicMap->origin.x;
+      iterator->y += g_dynamicMap->origin.y;
+      if (iterator->flags & CCE_GLOBAL_OFFSET_MASK)
+         setElementChangedDynamicMap2D((uint32_t) (iterator - g_dynamicMap->elements));
+   }
+   g_dynamicMap->origin = (struct cce_i32vec2) {0, 0};
+}
+
+static inline void bindVBOtoVAO (GLuint VBO, GLuint VAO, GLintptr offset)
 {
    glBindVertexArray(VAO);
    GL_CHECK_ERRORS;
    glBindBuffer(GL_ARRAY_BUFFER, VBO);
    GL_CHECK_ERRORS;
    
-   cce__setAttribPointerVAO();
+   cce__setAttribPointerVAO(offset);
    
    glBindBuffer(GL_ARRAY_BUFFER, 0);
    GL_CHECK_ERRORS;
@@ -60,7 +90,7 @@ static inline void bindVBOtoVAO (GLuint VBO, GLuint VAO)
    GL_CHECK_ERRORS;
 }
 
-struct DynamicMap2D* cce__initDynamicMap2D (GLuint EBO)
+struct DynamicMap2D* cce__initDynamicMap2D (void)
 {
    g_dynamicMap = (struct DynamicMap2D*) malloc(sizeof(struct DynamicMap2D));
    g_dynamicMap->elementsQuantity = 0u;
@@ -70,19 +100,16 @@ struct DynamicMap2D* cce__initDynamicMap2D (GLuint EBO)
       iterator->flags = 0x0;
    }
    g_dynamicMap->objectBufferAllocatedSpace = g_dynamicMap->elementsQuantityAllocated;
+   g_dynamicMap->instances = calloc(g_dynamicMap->objectBufferAllocatedSpace, sizeof(struct Map2DElementInstance));
+   g_dynamicMap->dirtyElementsQuantity = 0u;
+   CCE_ALLOC_ARRAY(g_dynamicMap->dirtyElements);
+   g_dynamicMap->origin = (struct cce_i32vec2) {0, 0};
    glGenVertexArrays(1, &g_dynamicMap->VAO);
    GL_CHECK_ERRORS;
-   glGenBuffers(1, &g_dynamicMap->VBO);
-   GL_CHECK_ERRORS;
    glBindVertexArray(g_dynamicMap->VAO);
    GL_CHECK_ERRORS;
-   glBindBuffer(GL_ARRAY_BUFFER, g_dynamicMap->VBO);
-   GL_CHECK_ERRORS;
-   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-   GL_CHECK_ERRORS;
-   glBufferData(GL_ARRAY_BUFFER, (sizeof(struct Map2DElementVertices) * 4 * g_dynamicMap->objectBufferAllocatedSpace), NULL, GL_DYNAMIC_DRAW);
-   GL_CHECK_ERRORS;
-   cce__setAttribPointerVAO();
+   cce__createStreamBuffer(&g_dynamicMap->buffer, GL_ARRAY_BUFFER, sizeof(struct Map2DElementInstance) * g_dynamicMap->objectBufferAllocatedSpace);
+   cce__setAttribPointerVAO(0);
    glBindBuffer(GL_ARRAY_BUFFER, 0);
    GL_CHECK_ERRORS;
    glBindVertexArray(0);
@@ -110,6 +137,7 @@ struct DynamicMap2D* cce__initDynamicMap2D (GLuint EBO)
    usedUBO->moveGroupValuesQuantity = CCE_ALLOCATION_STEP;
    usedUBO->extensionGroupValues = calloc(CCE_ALLOCATION_STEP, sizeof(*(usedUBO->extensionGroupValues)));
    usedUBO->extensionGroupValuesQuantity = CCE_ALLOCATION_STEP;
+   cce__resizeGroupValuesUBO(usedUBO);
    return g_dynamicMap;
 }
 
@@ -139,14 +167,14 @@ CCE_PUBLIC_OPTIONS uint8_t cceGetGroupValueDynamicMap2D (cce_enum group_type, ui
    return 0u;
 }
 
-static inline uint8_t* getElementGroupVisiblePointersDynamicMap2D (cce_enum group_type, struct DynamicMap2DElement *element)
+static inline uint16_t* getElementGroupVisiblePointersDynamicMap2D (cce_enum group_type, struct DynamicMap2DElement *element)
 {
    switch (group_type)
    {
       case CCE_MOVE_GROUP:
-         return (uint8_t*) &(element->visibleMoveGroups);
+         return element->visibleMoveGroups;
       case CCE_EXTENSION_GROUP:
-         return (uint8_t*) &(element->visibleExtensionGroups);
+         return element->visibleExtensionGroups;
       default:
          return NULL;
    }
@@ -260,6 +288,8 @@ static struct DynamicElementGroup* getGroupDynamicMap2D (cce_enum group_type, ui
             break;
          }
       }
+      if (group_type == CCE_MOVE_GROUP || group_type == CCE_EXTENSION_GROUP)
+         cce__resizeGroupValuesUBO(usedUBO);
    }
    if ((*groupsQuantity) <= ID)
    {
@@ -304,7 +334,8 @@ CCE_PUBLIC_OPTIONS struct Map2DCollider cceGetColliderDataDynamicMap2D (uint32_t
          sizeOffset.y += tmp.y;
       }
    }
-   return (struct Map2DCollider) {element->x - coordOffset.x, element->y - coordOffset.y, element->width - sizeOffset.x, element->height - sizeOffset.y};
+   return (struct Map2DCollider) {element->x - coordOffset.x + g_dynamicMap->origin.x, element->y - coordOffset.y + g_dynamicMap->origin.y,
+                                  element->width - sizeOffset.x, element->height - sizeOffset.y};
 }
 
 uint8_t cce__getDynamicElementFlags (uint16_t ID)
@@ -402,8 +433,8 @@ CCE_PUBLIC_OPTIONS uint8_t cceAddElementInGroupVisibleDynamicMap2D (cce_enum gro
       return 1;
    cceAddElementInGroupDynamicMap2D(group_type, ID, elementID);
 
-   uint8_t *groups = getElementGroupVisiblePointersDynamicMap2D(group_type, g_dynamicMap->elements + elementID);
-   for (uint8_t *end = groups + 4; groups < end; ++groups)
+   uint16_t *groups = getElementGroupVisiblePointersDynamicMap2D(group_type, g_dynamicMap->elements + elementID);
+   for (uint16_t *end = groups + 4; groups < end; ++groups)
    {
       if (*groups == 0)
       {
@@ -420,8 +451,9 @@ CCE_PUBLIC_OPTIONS uint8_t cceAddElementInGroupVisibleDynamicMap2D (cce_enum gro
 static void updateMap2DElementDynamicMap2D (struct Map2DElementDev *element, uint32_t ID, cce_enum elementType, uint8_t flags)
 {
    struct DynamicMap2DElement *dynamicElement = g_dynamicMap->elements + ID;
-   dynamicElement->x = element->x;
-   dynamicElement->y = element->y;
+   setElementChangedDynamicMap2D(ID);
+   dynamicElement->x = element->x - g_dynamicMap->origin.x;
+   dynamicElement->y = element->y - g_dynamicMap->origin.y;
    dynamicElement->width = element->width;
    dynamicElement->height = element->height;
    dynamicElement->textureInfo = element->textureInfo;
@@ -452,14 +484,15 @@ static void updateMap2DElementDynamicMap2D (struct Map2DElementDev *element, uin
    }
    else
    {
-      memcpy(dynamicElement->visibleMoveGroups, element->moveGroups, 4 * sizeof(uint8_t));
-      memcpy(dynamicElement->visibleExtensionGroups, element->extensionGroups, 4 * sizeof(uint8_t));
+      for (uint8_t i = 0u; i < 4u; ++i)
+      {
+         dynamicElement->visibleMoveGroups[i] = element->moveGroups[i];
+         dynamicElement->visibleExtensionGroups[i] = element->extensionGroups[i];
+      }
    }
    // elementType is a bitfield, not just enum (intentional)
    dynamicElement->flags = 0x1 | (((elementType & CCE_COLLIDER) > 0) << 1) | 0x4 | (((elementType & CCE_ELEMENT_WITHOUT_COLLIDER) > 0) << 3) | 
                            ((element->isGlobalOffset) << 4) | (!(flags & CCE_POSITION_IS_NOT_CURRENT) << 5);
-   
-   g_flags |= CCE_DYNAMIC_MAP2D_TO_BE_PROCESSED;
 }
 
 #define SET_MAP2DELEMENTGROUPS_TO_NULL_DYNAMICMAP2D(element) \
@@ -548,10 +581,10 @@ CCE_PUBLIC_OPTIONS uint32_t* cceCreateMap2DElementsDynamicMap2D (struct Map2DEle
 
 CCE_PUBLIC_OPTIONS uint8_t cceDeleteGroupVisibilityFromElementDynamicMap2D (cce_enum group_type, uint16_t ID, uint32_t elementID)
 {
-   uint8_t *groups = getElementGroupVisiblePointersDynamicMap2D(group_type, g_dynamicMap->elements + elementID);
+   uint16_t *groups = getElementGroupVisiblePointersDynamicMap2D(group_type, g_dynamicMap->elements + elementID);
    if (groups == NULL)
       return CCE_INCORRECT_ENUM;
-   for (uint8_t *end = groups + 4; groups < end; ++groups)
+   for (uint16_t *end = groups + 4; groups < end; ++groups)
    {
       if (*groups == ID)
       {
@@ -664,9 +697,9 @@ CCE_PUBLIC_OPTIONS void cceDeleteMap2DElementDynamicMap2D (uint32_t ID)
 {
    deleteGroupsFromElementDynamicMap2D((g_dynamicMap->elements + ID));
    cce__releaseTexture((g_dynamicMap->elements + ID)->textureElementReliesOn);
+   setElementChangedDynamicMap2D(ID);
    memcpy((g_dynamicMap->elements + ID), &nullElement, sizeof(struct DynamicMap2DElement));
    (g_dynamicMap->elements + ID)->flags = 0x4;
-   g_flags |= CCE_DYNAMIC_MAP2D_TO_BE_PROCESSED;
    return;
 }
 
@@ -702,91 +735,83 @@ void cce__processDynamicMap2DElements (void)
    {
       return;
    }
-   glBindVertexArray(g_dynamicMap->VAO);
-   GL_CHECK_ERRORS;
-   
+   g_flags &= ~CCE_DYNAMIC_MAP2D_TO_BE_PROCESSED;
+   GLintptr offset = g_dynamicMap->buffer.offset;
+   uint8_t isBufferRecreated = 0u;
+   /* Instances live in CPU memory, so growing needs no GPU-side copy: elements, which are already there, are uploaded to the new buffer instead */
    if (g_dynamicMap->objectBufferAllocatedSpace < g_dynamicMap->elementsQuantityAllocated)
    {
-      uint32_t newBuffer;
-      glGenBuffers(1, &newBuffer);
-      GL_CHECK_ERRORS;
-      glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
-      GL_CHECK_ERRORS;
-      glBufferData(GL_COPY_WRITE_BUFFER, g_dynamicMap->elementsQuantityAllocated * sizeof(struct Map2DElementVertices) * 4, NULL, GL_DYNAMIC_DRAW);
-      GL_CHECK_ERRORS;
-      glBindBuffer(GL_COPY_READ_BUFFER, g_dynamicMap->VBO);
-      GL_CHECK_ERRORS;
-      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0u, 0u, (g_dynamicMap->objectBufferAllocatedSpace) * sizeof(struct Map2DElementVertices) * 4);
-      GL_CHECK_ERRORS;
-      glDeleteBuffers(1u, &g_dynamicMap->VBO);
-      GL_CHECK_ERRORS;
-      g_dynamicMap->VBO = newBuffer;
-      bindVBOtoVAO(g_dynamicMap->VBO, g_dynamicMap->VAO);
+      g_dynamicMap->instances = realloc(g_dynamicMap->instances, g_dynamicMap->elementsQuantityAllocated * sizeof(struct Map2DElementInstance));
+      cce__deleteStreamBuffer(&g_dynamicMap->buffer);
+      cce__createStreamBuffer(&g_dynamicMap->buffer, GL_ARRAY_BUFFER, g_dynamicMap->elementsQuantityAllocated * sizeof(struct Map2DElementInstance));
+      cce__invalidateStreamBufferRange(&g_dynamicMap->buffer, 0, MIN(g_dynamicMap->objectBufferAllocatedSpace, g_dynamicMap->elementsQuantity) * sizeof(struct Map2DElementInstance));
       g_dynamicMap->objectBufferAllocatedSpace = g_dynamicMap->elementsQuantityAllocated;
-      cce__extendElementBufferIfNecessary(g_dynamicMap->elementsQuantityAllocated);
+      isBufferRecreated = 1u;
    }
-   glBindBuffer(GL_ARRAY_BUFFER, g_dynamicMap->VBO);
-   GL_CHECK_ERRORS;
-   struct Map2DElementVertices *bufferPtr = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-   GL_CHECK_ERRORS;
+   struct Map2DElementInstance *bufferPtr = g_dynamicMap->instances;
    
-   for (struct DynamicMap2DElement *iterator = g_dynamicMap->elements, *end = (g_dynamicMap->elements) + (g_dynamicMap->elementsQuantity); iterator < end; ++iterator)
+   for (uint32_t *IDiterator = g_dynamicMap->dirtyElements, *IDend = g_dynamicMap->dirtyElements + g_dynamicMap->dirtyElementsQuantity; IDiterator < IDend; ++IDiterator)
    {
-      if (iterator->flags & 0x4u)
+      struct DynamicMap2DElement *iterator = g_dynamicMap->elements + *IDiterator;
+      struct cce_i32vec2 moveGroupOffset = {0, 0}, extensionGroupOffset = {0, 0};
+      if (iterator->flags & 0x22)
       {
-         struct cce_i32vec2 moveGroupOffset = {0, 0}, extensionGroupOffset = {0, 0};
-         if (iterator->flags & 0x22)
-         {
-            struct cce_i32vec2 tmp;
-            for (uint16_t *jiterator = iterator->moveGroups, *jend = iterator->moveGroups + iterator->moveGroupsQuantity;
-            jiterator < jend; ++jiterator)
-            {
-               cceGetGroupValueDynamicMap2D(CCE_MOVE_GROUP, (iterator->moveGroups - jiterator), &tmp);
-               moveGroupOffset.x += tmp.x;
-               moveGroupOffset.y += tmp.y;
-            }
-            for (uint16_t *jiterator = iterator->extensionGroups, *jend = iterator->extensionGroups + iterator->extensionGroupsQuantity;
-            jiterator < jend; ++jiterator)
-            {
-               cceGetGroupValueDynamicMap2D(CCE_EXTENSION_GROUP, (iterator->extensionGroups - jiterator), &tmp);
-               extensionGroupOffset.x += tmp.x;
-               extensionGroupOffset.y += tmp.y;
-            }
-         }
-         if (iterator->textureElementReliesOn == 0)
-         {
-            iterator->textureElementReliesOn = cce__loadTexture(iterator->textureInfo.ID);
-         }
-         if (iterator->flags & 0x20)
-         {
-            iterator->x -= moveGroupOffset.x;
-            iterator->y -= moveGroupOffset.y;
-            iterator->width  -= extensionGroupOffset.x;
-            iterator->height -= extensionGroupOffset.y;
-         }
-         if (iterator->flags & 0x8)
-            cce__dynamicMap2DElementToMap2DElementVertices(bufferPtr + (iterator - g_dynamicMap->elements) * 4, iterator);
-         else
-            cce__dynamicMap2DElementToMap2DElementVertices(bufferPtr + (iterator - g_dynamicMap->elements) * 4, &nullElement);
-         
-         iterator->flags &= ~0x4u;
-         if (iterator->flags & 0x2)
+         struct cce_i32vec2 tmp;
+         for (uint16_t *jiterator = iterator->moveGroups, *jend = iterator->moveGroups + iterator->moveGroupsQuantity;
+         jiterator < jend; ++jiterator)
          {
-            iterator->x += moveGroupOffset.x;
-            iterator->y += moveGroupOffset.y;
-            iterator->width  += extensionGroupOffset.x;
-            iterator->height += extensionGroupOffset.y;
-            iterator->flags |= 0x20;
+            cceGetGroupValueDynamicMap2D(CCE_MOVE_GROUP, (iterator->moveGroups - jiterator), &tmp);
+            moveGroupOffset.x += tmp.x;
+            moveGroupOffset.y += tmp.y;
          }
-         else
+         for (uint16_t *jiterator = iterator->extensionGroups, *jend = iterator->extensionGroups + iterator->extensionGroupsQuantity;
+         jiterator < jend; ++jiterator)
          {
-            iterator->flags &= ~0x20;
+            cceGetGroupValueDynamicMap2D(CCE_EXTENSION_GROUP, (iterator->extensionGroups - jiterator), &tmp);
+            extensionGroupOffset.x += tmp.x;
+            extensionGroupOffset.y += tmp.y;
          }
       }
+      if (iterator->textureElementReliesOn == 0)
+      {
+         iterator->textureElementReliesOn = cce__loadTexture(iterator->textureInfo.ID);
+      }
+      if (iterator->flags & 0x20)
+      {
+         iterator->x -= moveGroupOffset.x;
+         iterator->y -= moveGroupOffset.y;
+         iterator->width  -= extensionGroupOffset.x;
+         iterator->height -= extensionGroupOffset.y;
+      }
+      /* Global offset elements get dynamic map's origin through GlobalMoveCoords uniform, other ones are screen-fixed and need it baked in */
+      struct cce_i32vec2 origin = (iterator->flags & CCE_GLOBAL_OFFSET_MASK) ? (struct cce_i32vec2) {0, 0} : g_dynamicMap->origin;
+      iterator->x += origin.x;
+      iterator->y += origin.y;
+      if (iterator->flags & 0x8)
+         cce__dynamicMap2DElementToMap2DElementInstance(bufferPtr + (iterator - g_dynamicMap->elements), iterator);
+      else
+         cce__dynamicMap2DElementToMap2DElementInstance(bufferPtr + (iterator - g_dynamicMap->elements), &nullElement);
+      cce__invalidateStreamBufferRange(&g_dynamicMap->buffer, *IDiterator * sizeof(struct Map2DElementInstance), (*IDiterator + 1u) * sizeof(struct Map2DElementInstance));
+      iterator->x -= origin.x;
+      iterator->y -= origin.y;
+      
+      iterator->flags &= ~0x4u;
+      if (iterator->flags & 0x2)
+      {
+         iterator->x += moveGroupOffset.x;
+         iterator->y += moveGroupOffset.y;
+         iterator->width  += extensionGroupOffset.x;
+         iterator->height += extensionGroupOffset.y;
+         iterator->flags |= 0x20;
+      }
+      else
+      {
+         iterator->flags &= ~0x20;
+      }
    }
-   glUnmapBuffer(GL_ARRAY_BUFFER);
-   glBindBuffer(GL_ARRAY_BUFFER, 0);
-   glBindVertexArray(0);
+   g_dynamicMap->dirtyElementsQuantity = 0u;
+   if (cce__flushStreamBuffer(&g_dynamicMap->buffer, GL_ARRAY_BUFFER, g_dynamicMap->instances) != offset || isBufferRecreated)
+      bindVBOtoVAO(g_dynamicMap->buffer.buffer, g_dynamicMap->VAO, g_dynamicMap->buffer.offset);
 }
 
 /*
@@ -836,8 +861,8 @@ CCE_PUBLIC_OPTIONS void cceReplaceColliderDynamicMap2D (struct Map2DCollider *co
       cceDeleteElementFromGroupDynamicMap2D(CCE_MOVE_GROUP, 0u, ID);
       (g_dynamicMap->elements + ID)->flags ^= CCE_GLOBAL_OFFSET_MASK;
    }
-   (g_dynamicMap->elements + ID)->x = collider->x;
-   (g_dynamicMap->elements + ID)->y = collider->y;
+   (g_dynamicMap->elements + ID)->x = collider->x - g_dynamicMap->origin.x;
+   (g_dynamicMap->elements + ID)->y = collider->y - g_dynamicMap->origin.y;
    (g_dynamicMap->elements + ID)->width = collider->width;
    (g_dynamicMap->elements + ID)->height = collider->height;
 }
@@ -885,7 +910,10 @@ cce_ubyte cce__fourthLogicTypeFuncDynamicMap2D (uint16_t ID, va_list argp)
       elements2 = (cce_void*) g_dynamicMap->elements;
       element2Size = sizeof(struct DynamicMap2DElement);
    }
-   return cce__checkCollision(group1firstID, groups1Quantity, group2firstID, groups2Quantity, elements1, element1Size, elements2, element2Size);
+   struct cce_i32vec2 zero = {0, 0};
+   return cce__checkCollisionWithOffset(group1firstID, groups1Quantity, group2firstID, groups2Quantity,
+                                        elements1, element1Size, ((g_dynamicMap->collision + ID)->flags & 0x2) ? &zero : &(g_dynamicMap->origin),
+                                        elements2, element2Size, ((g_dynamicMap->collision + ID)->flags & 0x4) ? &zero : &(g_dynamicMap->origin));
 }
 
 #define cce__checkCollisionBetweenMaps(collision, collisionGroups1, collisionGroups2, elements1, elements2) \
@@ -908,20 +936,20 @@ cce_ubyte cce__checkCollisionDynamicMap2DmultipleMaps (uint16_t ID, struct Map2D
       case 0x0:
          return cce__checkCollisionBetweenMaps(collision, g_dynamicMap->collisionGroups, g_dynamicMap->collisionGroups, g_dynamicMap->elements, g_dynamicMap->elements);
       case 0x2:
-         if (cce__checkCollisionBetweenMaps(collision, map->collisionGroups, g_dynamicMap->collisionGroups, map->colliders, g_dynamicMap->elements))
+         if (cce__checkCollisionBetweenMapsWithOffset(collision, map->collisionGroups, g_dynamicMap->collisionGroups, map->colliders, g_dynamicMap->elements, &zero, &(g_dynamicMap->origin)))
             return 1;
          for (struct Map2D **iterator = maps, **end = maps + mapsQuantity; iterator < end; ++iterator, offsets = (const struct cce_i32vec2*) (((cce_void*) offsets) + mapOffsetsSize))
          {
-            if (cce__checkCollisionBetweenMapsWithOffset(collision, (*iterator)->collisionGroups, g_dynamicMap->collisionGroups, (*iterator)->colliders, g_dynamicMap->elements, offsets, &zero))
+            if (cce__checkCollisionBetweenMapsWithOffset(collision, (*iterator)->collisionGroups, g_dynamicMap->collisionGroups, (*iterator)->colliders, g_dynamicMap->elements, offsets, &(g_dynamicMap->origin)))
                return 1;
          }
          break;
       case 0x4:
-         if (cce__checkCollisionBetweenMaps(collision, g_dynamicMap->collisionGroups, map->collisionGroups, g_dynamicMap->elements, map->colliders))
+         if (cce__checkCollisionBetweenMapsWithOffset(collision, g_dynamicMap->collisionGroups, map->collisionGroups, g_dynamicMap->elements, map->colliders, &(g_dynamicMap->origin), &zero))
             return 1;
          for (struct Map2D **iterator = maps, **end = maps + mapsQuantity; iterator < end; ++iterator, offsets = (const struct cce_i32vec2*) (((cce_void*) offsets) + mapOffsetsSize))
          {
-            if (cce__checkCollisionBetweenMapsWithOffset(collision, g_dynamicMap->collisionGroups, (*iterator)->collisionGroups, g_dynamicMap->elements, (*iterator)->colliders, &zero, offsets))
+            if (cce__checkCollisionBetweenMapsWithOffset(collision, g_dynamicMap->collisionGroups, (*iterator)->collisionGroups, g_dynamicMap->elements, (*iterator)->colliders, &(g_dynamicMap->origin), offsets))
                return 1;
          }
          break;
@@ -1158,7 +1186,9 @@ void cce__terminateDynamicMap2D (void)
    
    cce__releaseUBO(g_dynamicMap->UBO_ID);
    cce__releaseTemporaryBools(g_dynamicMap->temporaryBools);
-   glDeleteBuffers(1, &(g_dynamicMap->VBO));
+   cce__deleteStreamBuffer(&(g_dynamicMap->buffer));
+   free(g_dynamicMap->instances);
+   free(g_dynamicMap->dirtyElements);
    glDeleteVertexArrays(1, &(g_dynamicMap->VAO));
 
    for (struct DynamicMap2DElement *iterator = g_dynamicMap->elements, *end = g_dynamicMap->elements + g_dynamicMap->elementsQuantity; iterator < end; ++iterator)
@@ -0,0 +1,207 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../../include/coffeechain/engine_common.h"
+#include "../../include/coffeechain/utils.h"
+#include "map2D_internal.h"
+
+/* Instances of all static maps live in one buffer with one VAO, so drawing maps doesn't switch VAOs and buffers.
+ * Maps get ranges of it from the list of free ranges (first fit), buffer grows twice when no range is big enough */
+#define CCE_INSTANCE_ARENA_INITIAL_SIZE 16384u /* In instances */
+
+struct FreeRange
+{
+   uint32_t first;
+   uint32_t quantity;
+};
+
+static GLuint   g_arenaVAO = 0u;
+static GLuint   g_arenaBuffer = 0u;
+static uint32_t g_arenaSize;
+static uint32_t g_pointedInstance;
+static uint32_t g_freeRangesQuantity;
+static uint32_t g_freeRangesQuantityAllocated;
+static struct FreeRange *g_freeRanges; /* Sorted by first, neighbouring ranges are merged */
+
+static void pointInstanceArenaForced (uint32_t first)
+{
+   glBindBuffer(GL_ARRAY_BUFFER, g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   cce__setAttribPointerVAO((GLintptr) first * sizeof(struct Map2DElementInstance));
+   g_pointedInstance = first;
+}
+
+void cce__initInstanceArena (void)
+{
+   g_arenaSize = CCE_INSTANCE_ARENA_INITIAL_SIZE;
+   glGenVertexArrays(1, &g_arenaVAO);
+   GL_CHECK_ERRORS;
+   glGenBuffers(1, &g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   glBindVertexArray(g_arenaVAO);
+   GL_CHECK_ERRORS;
+   glBindBuffer(GL_ARRAY_BUFFER, g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   glBufferData(GL_ARRAY_BUFFER, g_arenaSize * sizeof(struct Map2DElementInstance), NULL, GL_STATIC_DRAW);
+   GL_CHECK_ERRORS;
+   pointInstanceArenaForced(0u);
+   glBindVertexArray(0);
+   GL_CHECK_ERRORS;
+   CCE_ALLOC_ARRAY(g_freeRanges);
+   g_freeRanges->first = 0u;
+   g_freeRanges->quantity = g_arenaSize;
+   g_freeRangesQuantity = 1u;
+}
+
+void cce__terminateInstanceArena (void)
+{
+   glDeleteVertexArrays(1, &g_arenaVAO);
+   glDeleteBuffers(1, &g_arenaBuffer);
+   g_arenaVAO = 0u;
+   g_arenaBuffer = 0u;
+   free(g_freeRanges);
+   g_freeRanges = NULL;
+}
+
+static void insertFreeRange (uint32_t first, uint32_t quantity)
+{
+   struct FreeRange *iterator = g_freeRanges, *end = g_freeRanges + g_freeRangesQuantity;
+   while (iterator < end && iterator->first < first)
+      ++iterator;
+   
+   uint8_t isMergedWithPrevious = 0u;
+   if (iterator > g_freeRanges && (iterator - 1)->first + (iterator - 1)->quantity == first)
+   {
+      (iterator - 1)->quantity += quantity;
+      isMergedWithPrevious = 1u;
+   }
+   if (iterator < end && first + quantity == iterator->first)
+   {
+      if (isMergedWithPrevious)
+      {
+         (iterator - 1)->quantity += iterator->quantity;
+         memmove(iterator, iterator + 1, (end - iterator - 1) * sizeof(struct FreeRange));
+         --g_freeRangesQuantity;
+      }
+      else
+      {
+         iterator->first = first;
+         iterator->quantity += quantity;
+      }
+      return;
+   }
+   if (isMergedWithPrevious)
+      return;
+   
+   uint32_t position = (uint32_t) (iterator - g_freeRanges);
+   if (g_freeRangesQuantity >= g_freeRangesQuantityAllocated)
+   {
+      CCE_REALLOC_ARRAY(g_freeRanges, g_freeRangesQuantity + 1u);
+   }
+   iterator = g_freeRanges + position;
+   memmove(iterator + 1, iterator, (g_freeRangesQuantity - position) * sizeof(struct FreeRange));
+   iterator->first = first;
+   iterator->quantity = quantity;
+   ++g_freeRangesQuantity;
+}
+
+/* Old contents are copied on GPU, VAO is pointed to the new buffer */
+static void growInstanceArena (uint32_t quantity)
+{
+   uint32_t oldSize = g_arenaSize;
+   while (g_arenaSize - oldSize < quantity)
+      g_arenaSize *= 2u;
+   
+   GLuint newBuffer;
+   glGenBuffers(1, &newBuffer);
+   GL_CHECK_ERRORS;
+   glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+   GL_CHECK_ERRORS;
+   glBufferData(GL_COPY_WRITE_BUFFER, g_arenaSize * sizeof(struct Map2DElementInstance), NULL, GL_STATIC_DRAW);
+   GL_CHECK_ERRORS;
+   glBindBuffer(GL_COPY_READ_BUFFER, g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize * sizeof(struct Map2DElementInstance));
+   GL_CHECK_ERRORS;
+   glDeleteBuffers(1, &g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   g_arenaBuffer = newBuffer;
+   
+   glBindVertexArray(g_arenaVAO);
+   GL_CHECK_ERRORS;
+   pointInstanceArenaForced(g_pointedInstance);
+   glBindVertexArray(0);
+   GL_CHECK_ERRORS;
+   insertFreeRange(oldSize, g_arenaSize - oldSize);
+}
+
+/* Returns position of the first instance in the arena */
+uint32_t cce__allocateInstanceArena (const struct Map2DElementInstance *instances, uint32_t quantity)
+{
+   struct FreeRange *iterator = g_freeRanges, *end = g_freeRanges + g_freeRangesQuantity;
+   while (iterator < end && iterator->quantity < quantity)
+      ++iterator;
+   
+   if (iterator >= end)
+   {
+      growInstanceArena(quantity);
+      iterator = g_freeRanges + g_freeRangesQuantity - 1u; // Grown part is merged into the last range
+   }
+   uint32_t first = iterator->first;
+   iterator->first += quantity;
+   iterator->quantity -= quantity;
+   if (iterator->quantity == 0u)
+   {
+      memmove(iterator, iterator + 1, (g_freeRanges + g_freeRangesQuantity - iterator - 1) * sizeof(struct FreeRange));
+      --g_freeRangesQuantity;
+   }
+   
+   glBindBuffer(GL_ARRAY_BUFFER, g_arenaBuffer);
+   GL_CHECK_ERRORS;
+   glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) first * sizeof(struct Map2DElementInstance), quantity * sizeof(struct Map2DElementInstance), instances);
+   GL_CHECK_ERRORS;
+   return first;
+}
+
+void cce__freeInstanceArena (uint32_t first, uint32_t quantity)
+{
+   if (!g_arenaBuffer || quantity == 0u) // Maps can be freed after engine terminated
+      return;
+   
+   insertFreeRange(first, quantity);
+}
+
+void cce__bindInstanceArena (void)
+{
+   glBindVertexArray(g_arenaVAO);
+   GL_CHECK_ERRORS;
+}
+
+/* Without base instance (OpenGL 4.2) instances are skipped by moving attribute pointers, arena's VAO has to be bound */
+void cce__pointInstanceArena (uint32_t first)
+{
+   if (g_pointedInstance != first)
+      pointInstanceArenaForced(first);
+}
@@ -29,6 +29,7 @@
 #include "../../include/coffeechain/utils.h"
 #include "../../include/coffeechain/endianess.h"
 #include "../../include/coffeechain/os_interaction.h"
+#include "../../include/coffeechain/resource_pack.h"
 
 #include "../engine_common_internal.h"
 #include "../shader.h"
@@ -41,23 +42,55 @@ static float                                 g_stepMultiplier;
 uint16_t                                     cce__loadedMap2Dnumber;
 static char                                 *cce__resourcePath;
 CCE_PUBLIC_OPTIONS const uint16_t     *const cceLoadedMap2Dnumber = &cce__loadedMap2Dnumber;
-static uint8_t                               g_nearestMapsQuantity;
-static uint8_t                               g_nearestMaps[16];
+static uint16_t                              g_nearestMapsQuantity;
+static uint16_t                              g_nearestMapsQuantityAllocated;
+static struct Map2D                        **g_nearestMaps;
+static struct cce_i32vec2                   *g_nearestMapsOffsets;
+static struct WorldMap2D                    *g_world;
+static uint32_t                              g_worldRadius = 1u;
+static uint32_t                              g_worldHysteresis = 1u;
+static struct cce_u32vec2                    g_worldCell;
 static struct cce_u32vec2                    g_textureSize;
 CCE_PUBLIC_OPTIONS const struct cce_u32vec2 *cceTextureSize = &g_textureSize;
 CCE_ARRAY(g_textures, static struct LoadedTextures, static uint16_t);
+static struct TextureSlotsTableEntry        *g_textureSlots; /* Image ID -> texture slot, open addressing */
+static uint32_t                              g_textureSlotsQuantity;
+static uint8_t                               g_textureSlotsSizeLog2;
+static uint16_t                              g_freeTextureSlotHint; /* There are no free texture slots before it */
+static size_t                                g_texturesMemoryBudget = SIZE_MAX;
+static struct TextureResidencyStats          g_residencyStats;
+static uint32_t                              g_frame = 1u; /* Maps never drawn have lastDrawnFrame 0 */
+static uint32_t                              g_textureResidencyRetryFrame; /* Eviction isn't tried before it if budget couldn't be met */
 static GLint                                 g_uniformBufferSize;
+static double                                g_logicTickLength; /* 0 - logic is processed once per frame */
+static double                                g_logicTimeAccumulated;
+static float                                 g_tickInterpolation = 1.0f;
+static struct cce_i32vec2                    g_globalOffsetTickShift; /* Change of global offset made by the last tick */
+static struct cce_i32vec2                    g_drawnGlobalOffset;
 CCE_ARRAY(g_UBOs, static struct UsedUBO, static uint16_t);
 static GLuint                                g_cleanUBO;
-static uint16_t                              glTexturesArraySize;
-static GLuint                                glTexturesArray;
-static GLuint                                g_EBO;
-static uint32_t                              g_elementBufferSize = 0;
+static GLuint                                g_cleanGroupValuesBuffer;
+static GLuint                                g_cleanGroupValues;
+static uint16_t                              g_groupValuesQuantityMax; /* Limited by GL_MAX_TEXTURE_BUFFER_SIZE */
+static uint8_t                               g_texturePagesQuantity;
+static GLuint                                g_texturePages[CCE_TEXTURE_PAGES_MAX];
+static uint16_t                              g_texturePagesFirstLayer[CCE_TEXTURE_PAGES_MAX + 1u]; /* Last one is quantity of layers */
+static GLuint                                g_PBOs[2];
+static GLuint                                g_copyFramebuffer; /* Reads layers of pages when textures are moved to other pages */
+static GLuint                                g_textureRectanglesBuffer; /* {x, y, layer, page}, {width, height, 0, 0} of every texture slot, read by vertex shader */
+static GLuint                                g_textureRectangles;
+static uint8_t                               g_PBOsPosition;
+static struct
+{
+   uint8_t *data;
+   int width;
+   int height;
+   struct LoadedTextures rectangle; /* Drawn by slots without rectangle of their own */
+}                                            g_dummyTexture;
 
 static struct DynamicMap2D *g_dynamicMap;
 
-static void (*cce_setUniformBufferToDefault)(GLuint, GLint);
-static void (*drawMap2Ddependant)(struct Map2D*);
+static void (*drawMap2Ddependant)(struct Map2D*, struct cce_i32vec2, uint32_t, uint8_t);
 static GLint *bufferUniformsOffsets;
 static GLint *uniformLocations;
 static GLuint shaderProgram;
@@ -67,81 +100,467 @@ static size_t texturesPathLength;
 
 static cce_flag map2Dflags;
 
-/* CBO - clear buffer object. Requires function glClearBufferSubData to present in openGL */
-static void setUniformBufferToDefault_withCBOext (GLuint UBO, GLint RotateAngleSinCosOffset)
+/* Everything is 0, except cosines of rotation angles */
+static void setUniformBlockToDefault (uint8_t *data)
 {
-   glBindBuffer(GL_UNIFORM_BUFFER, UBO);
-   GL_CHECK_ERRORS;
-   glClearBufferSubData(GL_UNIFORM_BUFFER, GL_R32F, 0u, g_uniformBufferSize, GL_RED, GL_FLOAT, NULL);
-   GL_CHECK_ERRORS;
-   struct cce_f32vec2 zeroOne = {0.0f, 1.0f};
-   glClearBufferSubData(GL_UNIFORM_BUFFER, GL_RG32F, RotateAngleSinCosOffset, 255 * sizeof(struct cce_f32vec2) , GL_RG, GL_FLOAT, &zeroOne);
-   GL_CHECK_ERRORS;
+   memset(data, 0, g_uniformBufferSize);
+   struct cce_f32vec2 *sinCos = (struct cce_f32vec2*) (data + *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
+   for (struct cce_f32vec2 *end = sinCos + 255; sinCos < end; ++sinCos)
+   {
+      sinCos->y = 1.0f;
+   }
 }
 
-static void setUniformBufferToDefault_withoutCBOext (GLuint UBO, GLint RotateAngleSinCosOffset)
+/* UBOs are never mapped or read back: values are kept in ubo->data, this streams the whole block */
+void cce__uploadUBO (struct UsedUBO *ubo)
 {
-   glBindBuffer(GL_UNIFORM_BUFFER, UBO);
-   GL_CHECK_ERRORS;
-   void *uboData = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-   GL_CHECK_ERRORS;
-   memset(uboData, 0, g_uniformBufferSize);
-   struct cce_f32vec2 *sinCos = (struct cce_f32vec2*) (((cce_void*) uboData) + RotateAngleSinCosOffset);
-   for (struct cce_f32vec2 *end = sinCos + 255; sinCos < end; ++sinCos)
+   cce__invalidateStreamBufferRange(&(ubo->buffer), 0, g_uniformBufferSize);
+   cce__flushStreamBuffer(&(ubo->buffer), GL_UNIFORM_BUFFER, ubo->data);
+}
+
+static void uploadGroupValuesUBO (struct UsedUBO *ubo)
+{
+   ubo->changedGroupValuesBegin = ubo->changedGroupValuesEnd = 0u;
+   ubo->movedGroupsBegin = ubo->movedGroupsEnd = 0u;
+   ubo->changedGroupValues = 0u;
+   if (!ubo->groupValuesCapacity)
+      return;
+   cce__invalidateStreamBufferRange(&(ubo->groupValuesBuffer), 0, ubo->groupValuesCapacity * 2 * sizeof(struct cce_i32vec2));
+   cce__flushStreamBuffer(&(ubo->groupValuesBuffer), GL_TEXTURE_BUFFER, ubo->groupValues);
+}
+
+void cce__setUBOtoDefault (struct UsedUBO *ubo)
+{
+   setUniformBlockToDefault(ubo->data);
+   memset(ubo->changedGroups, 0, sizeof(ubo->changedGroups));
+   ubo->changedUniforms = 0u;
+   cce__uploadUBO(ubo);
+   if (ubo->groupValuesCapacity)
    {
-      sinCos->y = 1.0f;
+      memset(ubo->groupValues, 0, ubo->groupValuesCapacity * 2 * sizeof(struct cce_i32vec2));
+      memset(ubo->previousMoveGroupValues, 0, ubo->groupValuesCapacity * sizeof(struct cce_i32vec2));
    }
-   glUnmapBuffer(GL_UNIFORM_BUFFER);
-   GL_CHECK_ERRORS;
+   uploadGroupValuesUBO(ubo);
 }
 
-static void drawMap2D (struct Map2D *map)
+/* Groups past 255th aren't in the uniform block */
+void cce__setGroupChangedUBO (struct UsedUBO *ubo, uint8_t uniform, uint16_t groupIndex)
 {
-   glBindVertexArray(map->VAO);
-   GL_CHECK_ERRORS;
-   glBindBufferRange(GL_UNIFORM_BUFFER, 1u, (g_UBOs + map->UBO_ID)->UBO, 0u, g_uniformBufferSize);
-   GL_CHECK_ERRORS;
-   glDrawElements(GL_TRIANGLES, map->elementsQuantity * 6, GL_UNSIGNED_INT, (void*) 0);
+   if (groupIndex >= 255u)
+      return;
+   ubo->changedGroups[uniform][groupIndex >> 5u] |= 1u << (groupIndex & 31u);
+   ubo->changedUniforms |= 1u << uniform;
+}
+
+uint8_t cce__isGroupChangedUBO (const struct UsedUBO *ubo, uint8_t uniform, uint16_t groupIndex)
+{
+   return (ubo->changedGroups[uniform][groupIndex >> 5u] >> (groupIndex & 31u)) & 1u;
+}
+
+/* Every uniform array gets one range from its first to its last changed group, stream buffer coalesces them anyway.
+ * UBOs without changes aren't touched */
+void cce__uploadChangedUBO (struct UsedUBO *ubo)
+{
+   if (!ubo->changedUniforms)
+      return;
+   
+   for (uint8_t uniform = 0u; uniform < CCE_UNIFORM_ARRAYS_QUANTITY; ++uniform)
+   {
+      if (!(ubo->changedUniforms & (1u << uniform)))
+         continue;
+      
+      uint16_t first = UINT16_MAX, last = 0u;
+      for (uint16_t word = 0u; word < 8u; ++word)
+      {
+         uint32_t bits = ubo->changedGroups[uniform][word];
+         for (uint16_t i = word << 5u; bits; bits >>= 1u, ++i)
+         {
+            if (!(bits & 1u))
+               continue;
+            if (first == UINT16_MAX)
+               first = i;
+            last = i;
+         }
+      }
+      const GLintptr stride = (uniform == CCE_COLORGROUP_OFFSET) ? 4 * sizeof(GLfloat) : 2 * sizeof(GLint);
+      const GLintptr begin = *(bufferUniformsOffsets + uniform);
+      cce__invalidateStreamBufferRange(&(ubo->buffer), begin + first * stride, begin + (last + 1) * stride);
+   }
+   memset(ubo->changedGroups, 0, sizeof(ubo->changedGroups));
+   ubo->changedUniforms = 0u;
+   cce__flushStreamBuffer(&(ubo->buffer), GL_UNIFORM_BUFFER, ubo->data);
+}
+
+/* GroupValues grows to hold every move and extension group of UBO's map and is refilled from CPU caches.
+ * It never shrinks, so UBOs reused by other maps don't recreate it */
+void cce__resizeGroupValuesUBO (struct UsedUBO *ubo)
+{
+   uint16_t capacity = MAX(ubo->moveGroupValuesQuantity, ubo->extensionGroupValuesQuantity);
+   if (capacity > g_groupValuesQuantityMax)
+   {
+      cce__errorPrint("ENGINE::MAP2D::TOO_MANY_GROUPS:\nmap has %u move or extension groups, but GL_MAX_TEXTURE_BUFFER_SIZE fits only %u. "
+                      "Groups past it are neither moved nor extended", capacity, g_groupValuesQuantityMax);
+      capacity = g_groupValuesQuantityMax;
+   }
+   if (capacity > ubo->groupValuesCapacity)
+   {
+      if (ubo->groupValuesCapacity)
+         cce__deleteStreamBuffer(&(ubo->groupValuesBuffer));
+      cce__createStreamBuffer(&(ubo->groupValuesBuffer), GL_TEXTURE_BUFFER, capacity * 2 * sizeof(struct cce_i32vec2));
+      glActiveTexture(GL_TEXTURE0 + CCE_GROUPVALUES_TEXTURE_UNIT);
+      glBindTexture(GL_TEXTURE_BUFFER, ubo->groupValuesTexture);
+      glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, ubo->groupValuesBuffer.buffer);
+      GL_CHECK_ERRORS;
+      glActiveTexture(GL_TEXTURE0);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
+      ubo->groupValues = realloc(ubo->groupValues, capacity * 2 * sizeof(struct cce_i32vec2));
+      ubo->previousMoveGroupValues = realloc(ubo->previousMoveGroupValues, capacity * sizeof(struct cce_i32vec2));
+      ubo->groupValuesCapacity = capacity;
+   }
+   struct cce_i32vec2 *values = ubo->groupValues;
+   for (uint16_t i = 0u; i < ubo->groupValuesCapacity; ++i, values += 2)
+   {
+      *values = (i < ubo->moveGroupValuesQuantity) ? *(ubo->moveGroupValues + i) : (struct cce_i32vec2) {0, 0};
+      *(values + 1) = (i < ubo->extensionGroupValuesQuantity) ?
+                      (struct cce_i32vec2) {(ubo->extensionGroupValues + i)->x, (ubo->extensionGroupValues + i)->y} : (struct cce_i32vec2) {0, 0};
+      *(ubo->previousMoveGroupValues + i) = *values;
+   }
+   uploadGroupValuesUBO(ubo);
+}
+
+/* kind is CCE_GROUPVALUES_MOVE or CCE_GROUPVALUES_EXTENSION, changed groups are kept as one range */
+void cce__setGroupValueChangedUBO (struct UsedUBO *ubo, uint8_t kind, uint16_t groupIndex)
+{
+   if (groupIndex >= ubo->groupValuesCapacity)
+      return;
+   if (ubo->changedGroupValuesBegin >= ubo->changedGroupValuesEnd)
+   {
+      ubo->changedGroupValuesBegin = groupIndex;
+      ubo->changedGroupValuesEnd   = groupIndex + 1u;
+   }
+   else
+   {
+      ubo->changedGroupValuesBegin = MIN(ubo->changedGroupValuesBegin, groupIndex);
+      ubo->changedGroupValuesEnd   = MAX(ubo->changedGroupValuesEnd, groupIndex + 1u);
+   }
+   ubo->changedGroupValues |= kind;
+}
+
+/* Copies changed range from CPU caches to GroupValues and streams it. Values moved by this tick are remembered
+ * in previousMoveGroupValues first; it is kept in sync lazily, only over the groups moved by the tick before */
+void cce__uploadChangedGroupValuesUBO (struct UsedUBO *ubo)
+{
+   if (!ubo->changedGroupValues)
+      return;
+   
+   const uint16_t begin = ubo->changedGroupValuesBegin, end = ubo->changedGroupValuesEnd;
+   if (ubo->changedGroupValues & CCE_GROUPVALUES_MOVE)
+   {
+      for (uint16_t i = ubo->movedGroupsBegin; i < ubo->movedGroupsEnd; ++i)
+         *(ubo->previousMoveGroupValues + i) = *(ubo->groupValues + i * 2u);
+      ubo->movedGroupsBegin = begin;
+      ubo->movedGroupsEnd   = end;
+      ubo->flags |= 0x10;
+   }
+   struct cce_i32vec2 *values = ubo->groupValues + begin * 2u;
+   for (uint16_t i = begin; i < end; ++i, values += 2)
+   {
+      if (i < ubo->moveGroupValuesQuantity)
+         *values = *(ubo->moveGroupValues + i);
+      if (i < ubo->extensionGroupValuesQuantity)
+         *(values + 1) = (struct cce_i32vec2) {(ubo->extensionGroupValues + i)->x, (ubo->extensionGroupValues + i)->y};
+   }
+   cce__invalidateStreamBufferRange(&(ubo->groupValuesBuffer), begin * 2 * sizeof(struct cce_i32vec2), end * 2 * sizeof(struct cce_i32vec2));
+   cce__flushStreamBuffer(&(ubo->groupValuesBuffer), GL_TEXTURE_BUFFER, ubo->groupValues);
+   ubo->changedGroupValuesBegin = ubo->changedGroupValuesEnd = 0u;
+   ubo->changedGroupValues = 0u;
+}
+
+static void createUBO (struct UsedUBO *ubo)
+{
+   ubo->data = malloc(g_uniformBufferSize);
+   cce__createStreamBuffer(&(ubo->buffer), GL_UNIFORM_BUFFER, g_uniformBufferSize);
+   ubo->flags = 0u;
+   ubo->groupValues = NULL;
+   ubo->previousMoveGroupValues = NULL;
+   ubo->groupValuesCapacity = 0u;
+   glGenTextures(1, &(ubo->groupValuesTexture));
    GL_CHECK_ERRORS;
+   cce__setUBOtoDefault(ubo);
+   ubo->moveGroupValues = NULL;
+   ubo->moveGroupValuesQuantity = 0u;
+   ubo->extensionGroupValues = NULL;
+   ubo->extensionGroupValuesQuantity = 0u;
+}
+
+static void deleteUBO (struct UsedUBO *ubo)
+{
+   cce__deleteStreamBuffer(&(ubo->buffer));
+   if (ubo->groupValuesCapacity)
+      cce__deleteStreamBuffer(&(ubo->groupValuesBuffer));
+   glDeleteTextures(1, &(ubo->groupValuesTexture));
+   free(ubo->data);
+   free(ubo->groupValues);
+   free(ubo->moveGroupValues);
+   free(ubo->previousMoveGroupValues);
+   free(ubo->extensionGroupValues);
 }
 
-static void drawMap2DcleanUBO (struct Map2D *map)
+/* Texture is bound to its own unit, GroupValuesOffset points to the segment written last. Groups past quantity are read as zeroes by shader */
+static void bindGroupValuesMap2D (GLuint texture, GLintptr offset, uint16_t quantity)
 {
-   glBindVertexArray(map->VAO);
+   glActiveTexture(GL_TEXTURE0 + CCE_GROUPVALUES_TEXTURE_UNIT);
+   glBindTexture(GL_TEXTURE_BUFFER, texture);
+   glActiveTexture(GL_TEXTURE0);
+   glUniform1i(*(uniformLocations + CCE_GROUPVALUESOFFSET_OFFSET), (GLint) (offset / (2 * sizeof(GLint))));
+   glUniform1i(*(uniformLocations + CCE_GROUPVALUESQUANTITY_OFFSET), quantity);
    GL_CHECK_ERRORS;
-   glBindBufferRange(GL_UNIFORM_BUFFER, 1u, g_cleanUBO, 0u, g_uniformBufferSize);
+}
+
+/* Uniform block range, group values and MapOffset bound last, maps sharing them (dependant maps drawn with the clean UBO,
+ * maps of one UBO) don't bind them again. Forgotten at the start of every frame, since buffers may be recreated between frames */
+static struct
+{
+   GLuint   buffer;
+   GLintptr offset;
+   GLuint   groupValuesTexture;
+   GLintptr groupValuesOffset;
+   uint16_t groupValuesQuantity;
+   struct cce_i32vec2 mapOffset;
+}                                            g_boundUniforms;
+
+static void forgetBoundUniformsMap2D (void)
+{
+   memset(&g_boundUniforms, 0, sizeof(g_boundUniforms));
+   g_boundUniforms.mapOffset = (struct cce_i32vec2) {INT32_MIN, INT32_MIN};
+}
+
+static void bindUniformsMap2D (GLuint buffer, GLintptr offset, GLuint groupValuesTexture, GLintptr groupValuesOffset, uint16_t groupValuesQuantity)
+{
+   if (buffer != g_boundUniforms.buffer || offset != g_boundUniforms.offset)
+   {
+      glBindBufferRange(GL_UNIFORM_BUFFER, 1u, buffer, offset, g_uniformBufferSize);
+      GL_CHECK_ERRORS;
+      g_boundUniforms.buffer = buffer;
+      g_boundUniforms.offset = offset;
+   }
+   if (groupValuesTexture != g_boundUniforms.groupValuesTexture || groupValuesOffset != g_boundUniforms.groupValuesOffset ||
+       groupValuesQuantity != g_boundUniforms.groupValuesQuantity)
+   {
+      bindGroupValuesMap2D(groupValuesTexture, groupValuesOffset, groupValuesQuantity);
+      g_boundUniforms.groupValuesTexture = groupValuesTexture;
+      g_boundUniforms.groupValuesOffset = groupValuesOffset;
+      g_boundUniforms.groupValuesQuantity = groupValuesQuantity;
+   }
+}
+
+static void setMapOffsetMap2D (struct cce_i32vec2 mapOffset)
+{
+   if (mapOffset.x == g_boundUniforms.mapOffset.x && mapOffset.y == g_boundUniforms.mapOffset.y)
+      return;
+   glUniform2i(*(uniformLocations + CCE_MAPOFFSET_OFFSET), mapOffset.x, mapOffset.y);
    GL_CHECK_ERRORS;
-   glDrawElements(GL_TRIANGLES, map->elementsQuantity * 6, GL_UNSIGNED_INT, (void*) 0);
+   g_boundUniforms.mapOffset = mapOffset;
+}
+
+static void reloadEvictedTexturesMap2D (struct Map2D *map);
+
+static void drawInstancesRangeMap2D (struct Map2D *map, uint32_t first, uint32_t quantity, uint32_t orderBase)
+{
+   glUniform1i(*(uniformLocations + CCE_ORDEROFFSET_OFFSET), (GLint) (orderBase + first));
+   cce__pointInstanceArena(map->instancesFirst + first);
+   cce__drawInstancesMap2D(quantity);
    GL_CHECK_ERRORS;
 }
 
-static void drawMap2Dmain (struct Map2Darray *maps)
+/* Every element may be in 4 groups with the extreme value, extension widens each side by a half */
+static void getGroupsSpreadMap2D (const struct UsedUBO *ubo, struct cce_i32vec2 *moveMin, struct cce_i32vec2 *moveMax, struct cce_i32vec2 *extension)
+{
+   *moveMin = *moveMax = *extension = (struct cce_i32vec2) {0, 0};
+   if (!ubo)
+      return;
+   
+   for (const struct cce_i32vec2 *iterator = ubo->moveGroupValues, *end = ubo->moveGroupValues + ubo->moveGroupValuesQuantity; iterator < end; ++iterator)
+   {
+      moveMin->x = MIN(moveMin->x, iterator->x);
+      moveMin->y = MIN(moveMin->y, iterator->y);
+      moveMax->x = MAX(moveMax->x, iterator->x);
+      moveMax->y = MAX(moveMax->y, iterator->y);
+   }
+   if (ubo->flags & 0x10) // Groups may be drawn between values of the last two ticks
+   {
+      for (const struct cce_i32vec2 *iterator = ubo->previousMoveGroupValues, *end = ubo->previousMoveGroupValues + MIN(ubo->moveGroupValuesQuantity, ubo->groupValuesCapacity);
+           iterator < end; ++iterator)
+      {
+         moveMin->x = MIN(moveMin->x, iterator->x);
+         moveMin->y = MIN(moveMin->y, iterator->y);
+         moveMax->x = MAX(moveMax->x, iterator->x);
+         moveMax->y = MAX(moveMax->y, iterator->y);
+      }
+   }
+   for (const struct cce_i16vec2 *iterator = ubo->extensionGroupValues, *end = ubo->extensionGroupValues + ubo->extensionGroupValuesQuantity; iterator < end; ++iterator)
+   {
+      extension->x = MAX(extension->x, abs(iterator->x));
+      extension->y = MAX(extension->y, abs(iterator->y));
+   }
+   moveMin->x *= 4, moveMin->y *= 4;
+   moveMax->x *= 4, moveMax->y *= 4;
+   extension->x *= 2, extension->y *= 2;
+}
+
+struct TilesView
+{
+   const struct UsedUBO *ubo;
+   /* Screen in map's coordinates: InverseStep maps [-step, step] to the screen, GlobalMoveCoords is added only to global offset elements */
+   int64_t screenFixedView[4];
+   int64_t globalView[4];
+   struct cce_i32vec2 moveMin, moveMax, extension;
+   uint8_t isSpreadKnown;
+};
+
+static void initTilesViewMap2D (struct TilesView *view, const struct UsedUBO *ubo, struct cce_i32vec2 mapOffset)
+{
+   struct cce_u32vec2 step = cce__getCurrentStep();
+   int64_t stepX = step.x * g_stepMultiplier, stepY = step.y * g_stepMultiplier;
+   view->ubo = ubo;
+   view->screenFixedView[0] = -stepX - mapOffset.x;
+   view->screenFixedView[1] = -stepY - mapOffset.y;
+   view->screenFixedView[2] = stepX - mapOffset.x;
+   view->screenFixedView[3] = stepY - mapOffset.y;
+   view->globalView[0] = view->screenFixedView[0] - g_drawnGlobalOffset.x;
+   view->globalView[1] = view->screenFixedView[1] - g_drawnGlobalOffset.y;
+   view->globalView[2] = view->screenFixedView[2] - g_drawnGlobalOffset.x;
+   view->globalView[3] = view->screenFixedView[3] - g_drawnGlobalOffset.y;
+   view->isSpreadKnown = 0u;
+}
+
+static uint8_t isTileVisibleMap2D (const struct Map2DTile *tile, struct TilesView *view)
 {
-   drawMap2D(maps->main);
+   if (tile->flags & CCE_MAP2D_TILE_ALWAYS_VISIBLE)
+      return 1u;
+   
+   int64_t bounds[4] = {tile->min.x, tile->min.y, tile->max.x, tile->max.y};
+   if (tile->flags & (CCE_MAP2D_TILE_MOVED | CCE_MAP2D_TILE_EXTENDED))
+   {
+      if (!view->isSpreadKnown)
+      {
+         getGroupsSpreadMap2D(view->ubo, &view->moveMin, &view->moveMax, &view->extension);
+         view->isSpreadKnown = 1u;
+      }
+      if (tile->flags & CCE_MAP2D_TILE_MOVED)
+      {
+         bounds[0] += view->moveMin.x, bounds[1] += view->moveMin.y;
+         bounds[2] += view->moveMax.x, bounds[3] += view->moveMax.y;
+      }
+      if (tile->flags & CCE_MAP2D_TILE_EXTENDED)
+      {
+         bounds[0] -= view->extension.x, bounds[1] -= view->extension.y;
+         bounds[2] += view->extension.x, bounds[3] += view->extension.y;
+      }
+   }
+   const int64_t *screen = (tile->flags & CCE_MAP2D_TILE_GLOBAL_OFFSET) ? view->globalView : view->screenFixedView;
+   return !(bounds[2] < screen[0] || bounds[3] < screen[1] || bounds[0] > screen[2] || bounds[1] > screen[3]);
 }
 
-static void drawMap2Dnearest (struct Map2Darray *maps)
+/* Draws tiles intersecting the screen. Opaque pass goes front to back tile by tile so the depth test rejects
+ * covered fragments early, other passes keep the painter's order and draw visible neighbouring tiles by one call */
+static void drawVisibleTilesMap2D (struct Map2D *map, const struct UsedUBO *ubo, struct cce_i32vec2 mapOffset, uint32_t orderBase, uint8_t pass)
 {
-   drawMap2D(maps->main);
-   for (uint8_t *iterator = g_nearestMaps, *end = g_nearestMaps + g_nearestMapsQuantity; iterator < end; ++iterator)
+   struct TilesView view;
+   initTilesViewMap2D(&view, ubo, mapOffset);
+   if (pass == CCE_DRAW_OPAQUE)
    {
-      struct ExitMap2D *exitMap = maps->main->exitMaps + *iterator;
-      glUniform2i(*(uniformLocations + 2), exitMap->xOffset, exitMap->yOffset);
-      drawMap2Ddependant(*(maps->dependies + *iterator));
+      for (const struct Map2DTile *iterator = map->tiles + map->tilesQuantity; iterator > map->tiles;)
+      {
+         --iterator;
+         if ((iterator->flags & CCE_MAP2D_TILE_OPAQUE) && isTileVisibleMap2D(iterator, &view))
+            drawInstancesRangeMap2D(map, iterator->first, iterator->quantity, orderBase);
+      }
+      return;
+   }
+   
+   uint32_t runFirst = 0u, runQuantity = 0u;
+   for (const struct Map2DTile *iterator = map->tiles, *end = map->tiles + map->tilesQuantity; iterator < end; ++iterator)
+   {
+      if ((pass == CCE_DRAW_TRANSLUCENT && !(iterator->flags & CCE_MAP2D_TILE_TRANSLUCENT)) || !isTileVisibleMap2D(iterator, &view))
+         continue;
+      
+      if (runQuantity && iterator->first == runFirst + runQuantity)
+      {
+         runQuantity += iterator->quantity;
+         continue;
+      }
+      if (runQuantity)
+         drawInstancesRangeMap2D(map, runFirst, runQuantity, orderBase);
+      runFirst = iterator->first;
+      runQuantity = iterator->quantity;
    }
-   glUniform2i(*(uniformLocations + 2), 0, 0);
+   if (runQuantity)
+      drawInstancesRangeMap2D(map, runFirst, runQuantity, orderBase);
+}
+
+static void drawMap2D (struct Map2D *map, struct cce_i32vec2 mapOffset, uint32_t orderBase, uint8_t pass)
+{
+   map->lastDrawnFrame = g_frame;
+   if (map->isTextureEvicted)
+      reloadEvictedTexturesMap2D(map);
+   const struct UsedUBO *ubo = g_UBOs + map->UBO_ID;
+   bindUniformsMap2D(ubo->buffer.buffer, ubo->buffer.offset, ubo->groupValuesTexture, ubo->groupValuesBuffer.offset, ubo->groupValuesCapacity);
+   setMapOffsetMap2D(mapOffset);
+   drawVisibleTilesMap2D(map, g_UBOs + map->UBO_ID, mapOffset, orderBase, pass);
+}
+
+static void drawMap2DcleanUBO (struct Map2D *map, struct cce_i32vec2 mapOffset, uint32_t orderBase, uint8_t pass)
+{
+   map->lastDrawnFrame = g_frame;
+   if (map->isTextureEvicted)
+      reloadEvictedTexturesMap2D(map);
+   bindUniformsMap2D(g_cleanUBO, 0, g_cleanGroupValues, 0, g_groupValuesQuantityMax);
+   setMapOffsetMap2D(mapOffset);
+   drawVisibleTilesMap2D(map, NULL, mapOffset, orderBase, pass);
 }
 
-static void drawMap2Dall (struct Map2Darray *maps)
+/* Maps are ordered main first, then dependies; the order base gives every element of them its own depth.
+ * Opaque pass walks the maps backwards to stay front to back */
+static void drawMapsMap2D (struct Map2D *main, struct Map2D **dependies, struct cce_i32vec2 *offsets, size_t quantity, uint8_t pass)
 {
-   drawMap2D(maps->main);
-   struct ExitMap2D *exitMap = maps->main->exitMaps;
-   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->main->exitMapsQuantity; iterator < end; ++iterator, ++exitMap)
+   uint32_t orderBase = main->elementsQuantity;
+   if (pass == CCE_DRAW_OPAQUE)
+   {
+      for (size_t i = 0u; i < quantity; ++i)
+         orderBase += (*(dependies + i))->elementsQuantity;
+      
+      for (size_t i = quantity; i > 0u;)
+      {
+         --i;
+         orderBase -= (*(dependies + i))->elementsQuantity;
+         drawMap2Ddependant(*(dependies + i), *(offsets + i), orderBase, pass);
+      }
+      drawMap2D(main, (struct cce_i32vec2) {0, 0}, 0u, pass);
+      return;
+   }
+   
+   drawMap2D(main, (struct cce_i32vec2) {0, 0}, 0u, pass);
+   for (size_t i = 0u; i < quantity; ++i)
    {
-      glUniform2i(*(uniformLocations + 2), exitMap->xOffset, exitMap->yOffset);
-      drawMap2Ddependant(*iterator);
+      drawMap2Ddependant(*(dependies + i), *(offsets + i), orderBase, pass);
+      orderBase += (*(dependies + i))->elementsQuantity;
    }
-   glUniform2i(*(uniformLocations + 2), 0, 0);
+}
+
+static void drawMap2Dmain (struct Map2Darray *maps, uint8_t pass)
+{
+   drawMapsMap2D(maps->main, NULL, NULL, 0u, pass);
+}
+
+static void drawMap2Dnearest (struct Map2Darray *maps, uint8_t pass)
+{
+   drawMapsMap2D(maps->main, g_nearestMaps, g_nearestMapsOffsets, g_nearestMapsQuantity, pass);
+}
+
+static void drawMap2Dall (struct Map2Darray *maps, uint8_t pass)
+{
+   drawMapsMap2D(maps->main, maps->dependies, maps->dependiesOffsets, maps->dependiesQuantity, pass);
 }
 
 static cce_ubyte cce__fourthLogicTypeFuncDynamicMap2Dnearest (uint16_t ID, va_list argp)
@@ -157,7 +576,7 @@ static cce_ubyte cce__fourthLogicTypeFuncDynamicMap2Dnearest (uint16_t ID, va_li
 static cce_ubyte cce__fourthLogicTypeFuncDynamicMap2Dall (uint16_t ID, va_list argp)
 {
    struct Map2Darray *maps = va_arg(argp, struct Map2Darray*);
-   return cce__checkCollisionDynamicMap2DmultipleMaps(ID, maps->main, maps->dependies, maps->main->exitMapsQuantity, (struct cce_i32vec2*) &(maps->main->exitMaps->xOffset), sizeof(struct ExitMap2D));
+   return cce__checkCollisionDynamicMap2DmultipleMaps(ID, maps->main, maps->dependies, maps->dependiesQuantity, maps->dependiesOffsets, sizeof(struct cce_i32vec2));
 }
 
 static void dontProcessLogicMap2D (struct Map2Darray *maps)
@@ -182,34 +601,36 @@ static void processLogicMap2Dmain (struct Map2Darray *maps)
 static void processLogicMap2Dnearest (struct Map2Darray *maps)
 {
    cce__processLogicMap2D(maps->main);
-   struct cce_i32vec2 offsets[16];
-   struct Map2D *nearestMaps[16];
+   for (struct Map2D **iterator = g_nearestMaps, **end = g_nearestMaps + g_nearestMapsQuantity; iterator < end; ++iterator)
    {
-      uint8_t *iterator = g_nearestMaps, *end = g_nearestMaps + g_nearestMapsQuantity;
-      struct cce_i32vec2 *jiterator = offsets;
-      struct Map2D **kiterator = nearestMaps;
-      while (iterator < end)
-      {
-         *jiterator = (struct cce_i32vec2) {(maps->main->exitMaps + *iterator)->xOffset, (maps->main->exitMaps + *iterator)->yOffset};
-         *kiterator = *(maps->dependies + *iterator);
-         cce__processLogicMap2D(*kiterator);
-          ++iterator, ++jiterator, ++kiterator;
-      }
+      cce__processLogicMap2D(*iterator);
    }
-   cce__processLogicDynamicMap2D(g_dynamicMap, maps->main, cce__fourthLogicTypeFuncDynamicMap2Dnearest, maps->main, nearestMaps, g_nearestMapsQuantity, offsets);
+   cce__processLogicDynamicMap2D(g_dynamicMap, maps->main, cce__fourthLogicTypeFuncDynamicMap2Dnearest, maps->main, g_nearestMaps, (size_t) g_nearestMapsQuantity, g_nearestMapsOffsets);
 }
 
 static void processLogicMap2Dall (struct Map2Darray *maps)
 {
    cce__processLogicMap2D(maps->main);
-   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->main->exitMapsQuantity; iterator < end; ++iterator)
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator)
    {
       cce__processLogicMap2D((*iterator));
    }
    cce__processLogicDynamicMap2D(g_dynamicMap, maps->main, cce__fourthLogicTypeFuncDynamicMap2Dall, maps);
 }
 
-static void (*drawMap2Dcommon) (struct Map2Darray*);
+static void (*drawMap2Dcommon) (struct Map2Darray*, uint8_t);
+
+static void drawFrameMapsMap2D (struct Map2Darray *maps, uint8_t pass)
+{
+   if (maps->dependiesQuantity > 0)
+   {
+      drawMap2Dcommon(maps, pass);
+   }
+   else
+   {
+      drawMap2D(maps->main, (struct cce_i32vec2) {0, 0}, 0u, pass);
+   }
+}
 static void (*processLogicMap2Dcommon) (struct Map2Darray*);
 
 #define CCE_RENDER_MAP_FLAGS (CCE_RENDER_ONLY_CURRENT_MAP | CCE_RENDER_VISIBLE_MAPS | CCE_RENDER_ALL_LOADED_MAPS)
@@ -277,12 +698,28 @@ static void cceSetFlags2D (cce_flag flags)
         ((flags & CCE_PROCESS_LOGIC_FLAGS) == CCE_DONT_PROCESS_LOGIC)) &&
         ((flags & CCE_FORCE_INITIALIZE_MAP_ONLOAD) == 0))
    {
+      uint8_t *data = malloc(g_uniformBufferSize);
+      setUniformBlockToDefault(data);
       glGenBuffers(1, &g_cleanUBO);
       glBindBuffer(GL_UNIFORM_BUFFER, g_cleanUBO);
       GL_CHECK_ERRORS;
-      glBufferData(GL_UNIFORM_BUFFER, g_uniformBufferSize, NULL, GL_DYNAMIC_DRAW);
+      glBufferData(GL_UNIFORM_BUFFER, g_uniformBufferSize, data, GL_STATIC_DRAW);
+      GL_CHECK_ERRORS;
+      free(data);
+      /* Zeroes for every group dependant maps may have */
+      data = calloc(g_groupValuesQuantityMax, 2 * sizeof(struct cce_i32vec2));
+      glGenBuffers(1, &g_cleanGroupValuesBuffer);
+      glBindBuffer(GL_TEXTURE_BUFFER, g_cleanGroupValuesBuffer);
+      glBufferData(GL_TEXTURE_BUFFER, g_groupValuesQuantityMax * 2 * sizeof(struct cce_i32vec2), data, GL_STATIC_DRAW);
       GL_CHECK_ERRORS;
-      cce_setUniformBufferToDefault(g_cleanUBO, *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
+      free(data);
+      glGenTextures(1, &g_cleanGroupValues);
+      glActiveTexture(GL_TEXTURE0 + CCE_GROUPVALUES_TEXTURE_UNIT);
+      glBindTexture(GL_TEXTURE_BUFFER, g_cleanGroupValues);
+      glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, g_cleanGroupValuesBuffer);
+      GL_CHECK_ERRORS;
+      glActiveTexture(GL_TEXTURE0);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
       drawMap2Ddependant = drawMap2DcleanUBO;
    }
    else
@@ -292,12 +729,13 @@ static void cceSetFlags2D (cce_flag flags)
    map2Dflags |= flags;
 }
 
-static GLuint createTextureArray (uint16_t newSize)
+static GLuint createTexturePage (uint8_t page)
 {
    GLuint texture;
    glGenTextures(1, &texture);
    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
-   glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, g_textureSize.x, g_textureSize.y, newSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+   glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, g_textureSize.x, g_textureSize.y, g_texturePagesFirstLayer[page + 1u] - g_texturePagesFirstLayer[page],
+                0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
    GL_CHECK_ERRORS;   
    
    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -363,20 +801,28 @@ CCE_PUBLIC_OPTIONS int cceInitEngine2D (uint16_t globalBoolsQuantity, uint32_t t
       return -1;
    }
    
-   uniformLocations = malloc(3 * sizeof(GLint));
+   uniformLocations = malloc(7 * sizeof(GLint));
    *uniformLocations = glGetUniformLocation(shaderProgram, "InverseStep");
    GL_CHECK_ERRORS;
    *(uniformLocations + 1) = glGetUniformLocation(shaderProgram, "GlobalMoveCoords");
    GL_CHECK_ERRORS;
    *(uniformLocations + 2) = glGetUniformLocation(shaderProgram, "MapOffset");
    GL_CHECK_ERRORS;
+   *(uniformLocations + CCE_PASS_OFFSET) = glGetUniformLocation(shaderProgram, "Pass");
+   GL_CHECK_ERRORS;
+   *(uniformLocations + CCE_ORDEROFFSET_OFFSET) = glGetUniformLocation(shaderProgram, "OrderOffset");
+   GL_CHECK_ERRORS;
+   *(uniformLocations + CCE_GROUPVALUESOFFSET_OFFSET) = glGetUniformLocation(shaderProgram, "GroupValuesOffset");
+   GL_CHECK_ERRORS;
+   *(uniformLocations + CCE_GROUPVALUESQUANTITY_OFFSET) = glGetUniformLocation(shaderProgram, "GroupValuesQuantity");
+   GL_CHECK_ERRORS;
    {
-      const GLchar *uniformNames[] = {"Colors", "MoveCoords", "Extension", "TextureOffset", "RotationOffset", "RotateAngleSinCos"};
-      GLuint indices[6];
-      glGetUniformIndices(shaderProgram, 6, uniformNames, indices);
+      const GLchar *uniformNames[] = {"Colors", "TextureOffset", "RotationOffset", "RotateAngleSinCos"};
+      GLuint indices[CCE_UNIFORM_ARRAYS_QUANTITY];
+      glGetUniformIndices(shaderProgram, CCE_UNIFORM_ARRAYS_QUANTITY, uniformNames, indices);
       GL_CHECK_ERRORS;
-      bufferUniformsOffsets = (GLint*) malloc(6 * sizeof(GLint));
-      glGetActiveUniformsiv(shaderProgram, 6, indices, GL_UNIFORM_OFFSET, bufferUniformsOffsets);
+      bufferUniformsOffsets = (GLint*) malloc(CCE_UNIFORM_ARRAYS_QUANTITY * sizeof(GLint));
+      glGetActiveUniformsiv(shaderProgram, CCE_UNIFORM_ARRAYS_QUANTITY, indices, GL_UNIFORM_OFFSET, bufferUniformsOffsets);
       GL_CHECK_ERRORS;
       glUniformBlockBinding(shaderProgram, glGetUniformBlockIndex(shaderProgram, "Variables"), 1u);
       GL_CHECK_ERRORS;
@@ -385,7 +831,7 @@ CCE_PUBLIC_OPTIONS int cceInitEngine2D (uint16_t globalBoolsQuantity, uint32_t t
    {
       GLint maxUniformOffset = 0;
       uint8_t i = 0, maxI;
-      for (GLint *iterator = bufferUniformsOffsets, *end = bufferUniformsOffsets + 6; iterator < end; ++iterator, ++i)
+      for (GLint *iterator = bufferUniformsOffsets, *end = bufferUniformsOffsets + CCE_UNIFORM_ARRAYS_QUANTITY; iterator < end; ++iterator, ++i)
       {
          if (maxUniformOffset < (*iterator))
          {
@@ -403,60 +849,93 @@ CCE_PUBLIC_OPTIONS int cceInitEngine2D (uint16_t globalBoolsQuantity, uint32_t t
          case 1:
          case 2:
          case 3:
-         case 4:
-         case 5:
          {
             g_uniformBufferSize = maxUniformOffset + (4/*GLint and GLfloat*/ * 2/*vec2*/ * 255/*array*/);
             break;
          }
       }
    }
-   if (GLAD_GL_ARB_clear_buffer_object)
-   {
-      cce_setUniformBufferToDefault = setUniformBufferToDefault_withCBOext;
-   }
-   else
    {
-      cce_setUniformBufferToDefault = setUniformBufferToDefault_withoutCBOext;
+      /* Every stream buffer segment has its own copy of GroupValues, segments are aligned by up to 32 texels */
+      GLint maxTexels;
+      glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+      GL_CHECK_ERRORS;
+      g_groupValuesQuantityMax = MIN(UINT16_MAX, maxTexels / (2 * (GLint) CCE_STREAM_BUFFER_SEGMENTS) - 32);
    }
-   
+   cce__initStreamBuffers();
    for (struct UsedUBO *iterator = g_UBOs, *end = g_UBOs + g_UBOsQuantityAllocated; iterator < end; ++iterator)
    {
-      glGenBuffers(1u, &(iterator->UBO));
-      GL_CHECK_ERRORS;
-      glBindBuffer(GL_UNIFORM_BUFFER, iterator->UBO);
-      GL_CHECK_ERRORS;
-      glBufferData(GL_UNIFORM_BUFFER, (g_uniformBufferSize), NULL, GL_DYNAMIC_DRAW);
-      GL_CHECK_ERRORS;
-      iterator->flags = 0u;
-      cce_setUniformBufferToDefault(iterator->UBO, *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
-      iterator->moveGroupValues = NULL;
-      iterator->extensionGroupValues = NULL;
+      createUBO(iterator);
    }
    glEnable(GL_BLEND);
    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-   glGenBuffers(1, &g_EBO);
-   cce__initMap2DLoaders(&g_EBO, &map2Dflags);
+   glDepthFunc(GL_LESS);
+   GL_CHECK_ERRORS;
+   cce__initMap2DLoaders(&map2Dflags);
    cceAppendPath(cce__resourcePath, pathLength + 11, "maps");
    cceSetMap2Dpath(cce__resourcePath);
    *(cce__resourcePath + pathLength) = '\0';
    
-   cce__globalOffset = (struct cce_i32vec2) {0, 0};
+   cce__globalOffset = g_drawnGlobalOffset = (struct cce_i32vec2) {0, 0};
    g_textureSize.x = textureMaxWidth;
    g_textureSize.y = textureMaxHeight;
    CCE_ALLOC_ARRAY_ZEROED(g_textures);
-   glTexturesArray = createTextureArray(CCE_ALLOCATION_STEP);
-   glTexturesArraySize = CCE_ALLOCATION_STEP;
-   g_elementBufferSize = 0;
+   g_textureSlotsSizeLog2 = 4u;
+   g_textureSlots = calloc(1u << g_textureSlotsSizeLog2, sizeof(struct TextureSlotsTableEntry));
+   g_textureSlotsQuantity = 0u;
+   g_freeTextureSlotHint = 0u;
+   memset(&g_residencyStats, 0, sizeof(struct TextureResidencyStats));
+   g_textureResidencyRetryFrame = 0u;
+   {
+      GLint maxLayers;
+      glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+      GL_CHECK_ERRORS;
+      *g_texturePagesFirstLayer = 0u;
+      for (uint8_t i = 0u; i < CCE_TEXTURE_PAGES_MAX; ++i)
+         g_texturePagesFirstLayer[i + 1u] = g_texturePagesFirstLayer[i] + MIN((GLint) CCE_TEXTURE_FIRST_PAGE_LAYERS << i, maxLayers);
+   }
+   *g_texturePages = createTexturePage(0u);
+   g_texturePagesQuantity = 1u;
+   cce__initTextureAtlas(g_textureSize, g_texturePagesFirstLayer[CCE_TEXTURE_PAGES_MAX]);
+   glGenBuffers(1, &g_textureRectanglesBuffer);
+   glBindBuffer(GL_TEXTURE_BUFFER, g_textureRectanglesBuffer);
+   glBufferData(GL_TEXTURE_BUFFER, g_texturesQuantityAllocated * 8u * sizeof(uint16_t), NULL, GL_DYNAMIC_DRAW);
+   GL_CHECK_ERRORS;
+   glGenTextures(1, &g_textureRectangles);
+   glActiveTexture(GL_TEXTURE0 + CCE_TEXTURE_PAGES_MAX);
+   glBindTexture(GL_TEXTURE_BUFFER, g_textureRectangles);
+   glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA16UI, g_textureRectanglesBuffer);
+   GL_CHECK_ERRORS;
+   glActiveTexture(GL_TEXTURE0);
+   glBindBuffer(GL_TEXTURE_BUFFER, 0);
+   glGenBuffers(2, g_PBOs);
+   glGenFramebuffers(1, &g_copyFramebuffer);
+   GL_CHECK_ERRORS;
+   g_PBOsPosition = 0u;
    stbi_set_flip_vertically_on_load(1);
+   cce__initTextureLoader();
    cceAppendPath(cce__resourcePath, pathLength + 11, "textures");
    cceSetTexturesPath(resourcePath);
    *(cce__resourcePath + pathLength) = '\0';
-   g_dynamicMap = cce__initDynamicMap2D(g_EBO);
-   cce__baseActionsInit(g_dynamicMap, g_UBOs, bufferUniformsOffsets, uniformLocations, shaderProgram, cce_setUniformBufferToDefault, &g_uniformBufferSize, &map2Dflags);
+   cce__initInstanceArena();
+   g_dynamicMap = cce__initDynamicMap2D();
+   cce__baseActionsInit(g_dynamicMap, g_UBOs, bufferUniformsOffsets, uniformLocations, shaderProgram, &g_uniformBufferSize, &map2Dflags);
    cceSetFlags2D(flags);
    map2Dflags &= ~CCE_INIT;
    glUseProgram(shaderProgram);
+   {
+      GLint units[CCE_TEXTURE_PAGES_MAX];
+      for (GLint i = 0; i < (GLint) CCE_TEXTURE_PAGES_MAX; ++i)
+         units[i] = i;
+      glUniform1iv(glGetUniformLocation(shaderProgram, "Textures"), CCE_TEXTURE_PAGES_MAX, units);
+      glUniform1i(glGetUniformLocation(shaderProgram, "TextureRectangles"), CCE_TEXTURE_PAGES_MAX);
+      glUniform1i(glGetUniformLocation(shaderProgram, "GroupValues"), CCE_GROUPVALUES_TEXTURE_UNIT);
+      GL_CHECK_ERRORS;
+   }
+   if (cce__isRenderThreadEnabled() && cce__startRenderThread() != 0)
+   {
+      fputs("ENGINE::INIT::RENDER_THREAD_CANNOT_BE_STARTED:\nOpenGL is called by the main thread\n", stderr);
+   }
    cceSetGridMultiplierMap2D(1.0f);
    return 0;
 }
@@ -473,28 +952,29 @@ CCE_PUBLIC_OPTIONS void cceSetTexturesPath (const char *path)
    texturesPathLength = strlen(texturesPath);
 }
 
-void cce__setAttribPointerVAO (void)
+/* Every attribute is per instance, quad itself has no vertex data */
+void cce__setAttribPointerVAO (GLintptr offset)
 {
    /* Pointers */
-   glVertexAttribIPointer(0, 2, GL_INT,             sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, vertexCoords)));
+   glVertexAttribIPointer(0, 2, GL_INT,            sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, position)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(1, 2, GL_INT,             sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, position)));
+   glVertexAttribIPointer(1, 2, GL_UNSIGNED_SHORT, sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, size)));
    GL_CHECK_ERRORS;
-   glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, textureCoords)));
+   glVertexAttribIPointer(2, 2, GL_SHORT,          sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, textureOrigin)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE,   sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, moveIDs)));
+   glVertexAttribIPointer(3, 2, GL_UNSIGNED_SHORT, sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, textureSize)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(4, 4, GL_UNSIGNED_BYTE,   sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, extendIDs)));
+   glVertexAttribIPointer(4, 1, GL_UNSIGNED_SHORT, sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, textureID)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(5, 2, GL_UNSIGNED_BYTE,   sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, transformGroups)));
+   glVertexAttribIPointer(5, 2, GL_UNSIGNED_BYTE,  sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, transformGroups)));
    GL_CHECK_ERRORS;
-   glVertexAttribPointer( 6, 2, GL_FLOAT, GL_FALSE, sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, textureFragmentSize)));
+   glVertexAttribIPointer(6, 4, GL_UNSIGNED_SHORT, sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, moveIDs)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(7, 1, GL_UNSIGNED_SHORT,  sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, textureID)));
+   glVertexAttribIPointer(7, 4, GL_UNSIGNED_SHORT, sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, extendIDs)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(8, 4, GL_UNSIGNED_BYTE,   sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, textureOffsetIDs)));
+   glVertexAttribIPointer(8, 4, GL_UNSIGNED_BYTE,  sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, textureOffsetIDs)));
    GL_CHECK_ERRORS;
-   glVertexAttribIPointer(9, 4, GL_UNSIGNED_BYTE,   sizeof(struct Map2DElementVertices), (void*)(offsetof(struct Map2DElementVertices, colorIDs)));
+   glVertexAttribIPointer(9, 4, GL_UNSIGNED_BYTE,  sizeof(struct Map2DElementInstance), (void*)(offset + offsetof(struct Map2DElementInstance, colorIDs)));
    GL_CHECK_ERRORS;
    
    /* I'm lazy */
@@ -502,187 +982,527 @@ void cce__setAttribPointerVAO (void)
    {
       glEnableVertexAttribArray(i);
       GL_CHECK_ERRORS;
+      glVertexAttribDivisor(i, 1);
+      GL_CHECK_ERRORS;
    }
 }
 
-void cce__extendElementBufferIfNecessary (uint32_t minimalSize)
+void cce__elementToMap2DElementInstance (struct Map2DElementInstance *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
+                                         uint16_t *moveGroups, uint8_t moveGroupsQuantity, uint16_t *extensionGroups, uint8_t extensionGroupsQuantity,
+                                         uint8_t globalOffset, uint8_t rotationGroup, struct Texture *textureInfo, uint16_t textureID,
+                                         uint8_t *textureOffsetGroups, uint8_t textureOffsetGroupsQuantity, uint8_t *colorGroups, uint8_t colorGroupsQuantity)
 {
-   if (g_elementBufferSize >= minimalSize)
-      return;
-
-   g_elementBufferSize = (minimalSize & ~(CCE_ALLOCATION_STEP - 1u)) + CCE_ALLOCATION_STEP;
-   glBindBuffer(GL_COPY_WRITE_BUFFER, g_EBO);
-   GL_CHECK_ERRORS;
-   glBufferData(GL_COPY_WRITE_BUFFER, g_elementBufferSize * 6 * sizeof(uint32_t), NULL, GL_STATIC_DRAW); // There are 6 indexes per one rectangle
-   GL_CHECK_ERRORS;
-   
-   uint32_t values[6] = {0, 1, 2, 1, 3, 2};
-   uint32_t *buffer = glMapBuffer(GL_COPY_WRITE_BUFFER, GL_WRITE_ONLY);
-   GL_CHECK_ERRORS;
-   memcpy(buffer, values, 6 * sizeof(uint32_t));
-   uint32_t *bufferend = buffer + (g_elementBufferSize * 6);
-   buffer += 6;
-   while (buffer < bufferend)
-   {
-      for (uint32_t *iterator = values, *end = values + 6; iterator < end; ++iterator)
-      {
-         *iterator += 4; // One rectangle has 4 vertices
-      }
-      memcpy(buffer, values, 6 * sizeof(uint32_t));
-      buffer += 6;
-   }
-   glUnmapBuffer(GL_COPY_WRITE_BUFFER);
-   GL_CHECK_ERRORS;
+   cce__elementToMap2DElementInstanceSized(buffer, x, y, width, height, moveGroups, moveGroupsQuantity, extensionGroups, extensionGroupsQuantity,
+                                           globalOffset, rotationGroup, textureInfo, textureID, g_textures[textureID - (textureID > 0)].size,
+                                           textureOffsetGroups, textureOffsetGroupsQuantity, colorGroups, colorGroupsQuantity);
 }
 
-#define GET_SIGN_FROM_BIT(n, bit)(1-((((n)&(1<<(bit)))>>(bit))*2))
+/* Doesn't touch any engine state, so can be used without OpenGL context (by map baker, for example).
+ * Texture piece is in pixels of the image, vertex shader adds place of the image in texture array and divides by its size */
+void cce__elementToMap2DElementInstanceSized (struct Map2DElementInstance *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
+                                              uint16_t *moveGroups, uint8_t moveGroupsQuantity, uint16_t *extensionGroups, uint8_t extensionGroupsQuantity,
+                                              uint8_t globalOffset, uint8_t rotationGroup, struct Texture *textureInfo, uint16_t textureID,
+                                              struct cce_u16vec2 textureSize,
+                                              uint8_t *textureOffsetGroups, uint8_t textureOffsetGroupsQuantity, uint8_t *colorGroups, uint8_t colorGroupsQuantity)
+{
+   buffer->position.x      = x;
+   buffer->position.y      = y;
+   buffer->size.x          = width;
+   buffer->size.y          = height;
+   buffer->textureOrigin.x = textureInfo->position.x;
+   buffer->textureOrigin.y = ((int) textureSize.y) - ((int) textureInfo->position.y) - ((int) textureInfo->size.y);
+   buffer->textureSize     = textureInfo->size;
+   buffer->textureID       = textureID;
+   buffer->transformGroups.rotateGroupID  = rotationGroup;
+   buffer->transformGroups.flags          = globalOffset ? CCE_INSTANCE_GLOBAL_OFFSET : 0u;
+   memcpy(buffer->moveIDs, moveGroups, MIN(moveGroupsQuantity, 4) * sizeof(uint16_t));
+   memset(buffer->moveIDs + moveGroupsQuantity, 0, (4 - MIN(moveGroupsQuantity, 4)) * sizeof(uint16_t));
+   memcpy(buffer->extendIDs, extensionGroups, MIN(extensionGroupsQuantity, 4) * sizeof(uint16_t));
+   memset(buffer->extendIDs + extensionGroupsQuantity, 0, (4 - MIN(extensionGroupsQuantity, 4)) * sizeof(uint16_t));
+   memcpy(buffer->textureOffsetIDs, textureOffsetGroups, MIN(textureOffsetGroupsQuantity, 4));
+   memset(buffer->textureOffsetIDs + textureOffsetGroupsQuantity, 0, 4 - MIN(textureOffsetGroupsQuantity, 4));
+   memcpy(buffer->colorIDs, colorGroups, MIN(colorGroupsQuantity, 4));
+   memset(buffer->colorIDs + colorGroupsQuantity, 0, 4 - MIN(colorGroupsQuantity, 4));
+}
 
-void cce__elementToMap2DElementVertices (struct Map2DElementVertices *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
-                                         uint8_t *moveGroups, uint8_t moveGroupsQuantity, uint8_t *extensionGroups, uint8_t extensionGroupsQuantity,
-                                         uint8_t globalOffset, uint8_t rotationGroup, struct Texture *textureInfo, uint16_t textureID,
-                                         uint8_t *textureOffsetGroups, uint8_t textureOffsetGroupsQuantity, uint8_t *colorGroups, uint8_t colorGroupsQuantity)
+/* Image IDs of texture slots are kept in hash table with linear probing, so textures are found by ID in O(1).
+ * Keys are image ID + 1, so image 0 is stored too. UINT32_MAX (free slots and textures loaded by cceLoadTexture) isn't put there */
+static inline uint32_t getTextureSlotsTablePosition (uint32_t key)
 {
-   uint8_t i = 0;
-   float textureInfoX[2] ;//= {0, 1};
-   struct cce_u16vec2 textureSize = g_textures[textureID - (textureID > 0)].size;
-   textureInfoX[0] = ((float)(textureInfo->position.x + (g_textureSize.x - textureSize.x)))/g_textureSize.x;
-   textureInfoX[1] = ((float)(textureInfo->position.x + textureInfo->size.x + (g_textureSize.x - textureSize.x)))/g_textureSize.x;
-   float textureInfoY[2] ;//= {0, 1};
-   textureInfoY[1] = ((float)(g_textureSize.y - textureInfo->position.y - (g_textureSize.y - textureSize.y)))/g_textureSize.y;
-   textureInfoY[0] = ((float)(((int)g_textureSize.y) - ((int)textureInfo->position.y) - ((int)textureInfo->size.y) - ((int)(g_textureSize.y - textureSize.y))))/g_textureSize.y;
-   struct cce_f32vec2 textureFragmentSize = {(float) textureInfo->size.x / g_textureSize.x, (float) textureInfo->size.y / g_textureSize.y};
-   for (struct Map2DElementVertices *vend = buffer + 4; buffer < vend; ++buffer, ++i)
-   {
-      buffer->vertexCoords.x  = width  * -GET_SIGN_FROM_BIT(i, 1);
-      buffer->vertexCoords.y  = height * -GET_SIGN_FROM_BIT(i, 0);
-      buffer->textureCoords.x = textureInfoX[(i & 2) >> 1];
-      buffer->textureCoords.y = textureInfoY[i & 1];
-      buffer->position.x      = x;
-      buffer->position.y      = y;
-      buffer->transformGroups.rotateGroupID  = rotationGroup;
-      buffer->transformGroups.isGlobalOffset = globalOffset;
-      memcpy(buffer->moveIDs, moveGroups, MIN(moveGroupsQuantity, 4));
-      memset(buffer->moveIDs + moveGroupsQuantity, 0, 4 - MIN(moveGroupsQuantity, 4));
-      memcpy(buffer->extendIDs, extensionGroups, MIN(extensionGroupsQuantity, 4));
-      memset(buffer->extendIDs + extensionGroupsQuantity, 0, 4 - MIN(extensionGroupsQuantity, 4));
-      buffer->textureFragmentSize = textureFragmentSize;
-      buffer->textureID           = textureID;
-      memcpy(buffer->textureOffsetIDs, textureOffsetGroups, MIN(textureOffsetGroupsQuantity, 4));
-      memset(buffer->textureOffsetIDs + textureOffsetGroupsQuantity, 0, 4 - MIN(textureOffsetGroupsQuantity, 4));
-      memcpy(buffer->colorIDs, colorGroups, MIN(colorGroupsQuantity, 4));
-      memset(buffer->colorIDs + colorGroupsQuantity, 0, 4 - MIN(colorGroupsQuantity, 4));
-   }
-}
-
-static int loadTexture (char *path, uint16_t position)
+   return (key * 0x9E3779B1u) >> (32u - g_textureSlotsSizeLog2);
+}
+
+static uint16_t findTextureSlot (uint32_t ID)
 {
-   unsigned int width, height;
-   void *data;
-   data = stbi_load(path, (int*) &width, (int*) &height, NULL, 4);
-   if (!data)
-   {
-      fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\n%s\n", stbi_failure_reason());
-      return -1;
-   }
-   if (width > g_textureSize.x || height > g_textureSize.y)
+   if (ID == UINT32_MAX)
+      return UINT16_MAX;
+   const uint32_t key = ID + 1u, mask = (1u << g_textureSlotsSizeLog2) - 1u;
+   for (uint32_t i = getTextureSlotsTablePosition(key); (g_textureSlots + i)->key != 0u; i = (i + 1u) & mask)
    {
-      fprintf(stderr, "ENGINE::TEXTURE::APPLYING_ERROR:\n%s is bigger than texture buffer allocated for it. Increase textureMaxWidth and textureMaxHeight to fix this error\n", path);
-      return -1;
+      if ((g_textureSlots + i)->key == key)
+         return (g_textureSlots + i)->slot;
    }
-   glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, g_textureSize.x - width, 0, position, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
-   GL_CHECK_ERRORS;
-   stbi_image_free(data);
-   (g_textures + position)->size.x = width;
-   (g_textures + position)->size.y = height;
-   return 0;
+   return UINT16_MAX;
 }
 
-static int setTextureAttributes (uint16_t ID)
+static void insertTextureSlot (uint32_t key, uint16_t slot)
 {
-   if (g_textures[ID].size.x != 0 && g_textures[ID].size.y != 0)
-      return 0;
-   int width = 0, height = 0, channels, result;
-   cce__shortToString(texturesPath, g_textures[ID].ID, ".png");
-   result = stbi_info(texturesPath, &width, &height, &channels);
-   *(texturesPath + texturesPathLength) = '\0';
-   g_textures[ID].size = (struct cce_u16vec2){width, height};
-   return result;
+   uint32_t mask = (1u << g_textureSlotsSizeLog2) - 1u;
+   uint32_t i = getTextureSlotsTablePosition(key);
+   while ((g_textureSlots + i)->key != 0u)
+      i = (i + 1u) & mask;
+   *(g_textureSlots + i) = (struct TextureSlotsTableEntry) {key, slot};
+   ++g_textureSlotsQuantity;
 }
 
-void cce__updateTexturesArray (void)
+static void removeTextureSlot (uint32_t ID)
 {
-   GLuint freeTexturesQuantityFromEnd = 0;
-   for (struct LoadedTextures *iterator = g_textures + g_texturesQuantity - 1;
-        (iterator >= g_textures) && (iterator->dependantMapsQuantity == 0u); --iterator, ++freeTexturesQuantityFromEnd);
-
-   g_texturesQuantity -= freeTexturesQuantityFromEnd;
-   CCE_FIT_ARRAY_TO_SIZE(g_textures);
-   uint8_t arrayResized = 0u;
-   GLuint textureArray;
-
-   if (glTexturesArraySize != g_texturesQuantityAllocated)
-   {
-      textureArray = createTextureArray(g_texturesQuantityAllocated);
-      glBindBuffer(GL_READ_BUFFER, glTexturesArray);
-      GL_CHECK_ERRORS;
-      arrayResized = 1u;
-      glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
-      GL_CHECK_ERRORS;
-   }
-   else
+   const uint32_t key = ID + 1u, mask = (1u << g_textureSlotsSizeLog2) - 1u;
+   uint32_t i = getTextureSlotsTablePosition(key);
+   while ((g_textureSlots + i)->key != key)
    {
-      textureArray = glTexturesArray;
+      if ((g_textureSlots + i)->key == 0u)
+         return;
+      i = (i + 1u) & mask;
    }
-   for (struct LoadedTextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   // Entries after the removed one are moved back, so no entry is separated from its position by an empty one
+   for (uint32_t j = (i + 1u) & mask; (g_textureSlots + j)->key != 0u; j = (j + 1u) & mask)
    {
-      if (iterator->dependantMapsQuantity > 0u)
+      uint32_t position = getTextureSlotsTablePosition((g_textureSlots + j)->key);
+      if (((j - position) & mask) >= ((j - i) & mask))
       {
-         if ((iterator->flags & CCE_LOADEDTEXTURES_TOBELOADED))
-         {
-            cce__shortToString(texturesPath, iterator->ID, ".png");
-            if (loadTexture(texturesPath, iterator - g_textures) != 0)
-            {
-               memcpy((texturesPath + texturesPathLength), "dummy.png", 10u);
-               if (loadTexture(texturesPath, iterator - g_textures) != 0)
-               {
-                  *(texturesPath + texturesPathLength) = '\0';
-                  cce__shortToString(texturesPath, iterator->ID, ".png");
-                  cce__criticalErrorPrint("ENGINE::TEXTURE::DUMMY::FAILED_TO_LOAD:\nFailed to load dummy texture requested because %s was not found.", texturesPath);
-               }
-            }
-            *(texturesPath + texturesPathLength) = '\0';
-            iterator->flags &= ~CCE_LOADEDTEXTURES_TOBELOADED;
-         }
-         else if (arrayResized)
-         {
-            glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 0, 0, g_textureSize.x, g_textureSize.y);
-            GL_CHECK_ERRORS;
-         }
+         *(g_textureSlots + i) = *(g_textureSlots + j);
+         i = j;
       }
-      else 
-      {
-         iterator->ID = 0u;
-      }
-   }
-   if (arrayResized)
-   {
-      glDeleteTextures(1, &glTexturesArray);
-      GL_CHECK_ERRORS;
-      glTexturesArray = textureArray;
    }
-   return;
+   (g_textureSlots + i)->key = 0u;
+   --g_textureSlotsQuantity;
 }
 
-static void updateUBOarray (void)
+/* Replaces image of texture slot in the table, table is kept at most half full. Slot set to UINT32_MAX is left out of the table */
+static void setTextureID (uint16_t position, uint32_t ID)
 {
-   uint16_t freeUBOsQuantityFromEnd = 0;
-   struct UsedUBO *end = g_UBOs + g_UBOsQuantity;
-   for (struct UsedUBO *iterator = g_UBOs; iterator < end; ++iterator)
+   struct LoadedTextures *texture = g_textures + position;
+   if (findTextureSlot(texture->ID) == position)
+      removeTextureSlot(texture->ID);
+   texture->ID = ID;
+   if (ID == UINT32_MAX)
+      return;
+   if ((g_textureSlotsQuantity + 1u) * 2u > (1u << g_textureSlotsSizeLog2))
    {
-      if ((iterator->flags & 0x3) == 0x3)
+      struct TextureSlotsTableEntry *oldTable = g_textureSlots;
+      uint32_t oldSize = 1u << g_textureSlotsSizeLog2;
+      ++g_textureSlotsSizeLog2;
+      g_textureSlots = calloc(1u << g_textureSlotsSizeLog2, sizeof(struct TextureSlotsTableEntry));
+      g_textureSlotsQuantity = 0u;
+      for (struct TextureSlotsTableEntry *iterator = oldTable, *end = oldTable + oldSize; iterator < end; ++iterator)
+      {
+         if (iterator->key != 0u)
+            insertTextureSlot(iterator->key, iterator->slot);
+      }
+      free(oldTable);
+   }
+   insertTextureSlot(ID + 1u, position);
+}
+
+#define CCE_TEXTURE_UPLOAD_BUDGET 0x1000000u /* Bytes of decoded images uploaded per frame, at least one image is uploaded */
+
+/* Page N holds atlas layers from g_texturePagesFirstLayer[N] up to the first layer of the next page */
+static uint8_t getTexturePage (uint16_t layer)
+{
+   uint8_t page = 0u;
+   while (layer >= g_texturePagesFirstLayer[page + 1u])
+      ++page;
+   return page;
+}
+
+/* Goes through pixel unpack buffer, so glTexSubImage3D doesn't wait for the copy. Buffers alternate to not stall on the previous upload.
+ * Only width x height part of data (which rows are rowLength pixels long) is written to the rectangle of texture */
+static void uploadTextureData (const void *data, unsigned int width, unsigned int height, unsigned int rowLength, const struct LoadedTextures *texture)
+{
+   GLsizeiptr size = (GLsizeiptr) rowLength * height * 4;
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g_PBOs[g_PBOsPosition]);
+   GL_CHECK_ERRORS;
+   g_PBOsPosition ^= 1u;
+   glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+   GL_CHECK_ERRORS;
+   void *buffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+   GL_CHECK_ERRORS;
+   memcpy(buffer, data, size);
+   glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+   GL_CHECK_ERRORS;
+   const uint8_t page = getTexturePage(texture->layer);
+   glBindTexture(GL_TEXTURE_2D_ARRAY, g_texturePages[page]);
+   GL_CHECK_ERRORS;
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+   glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, texture->atlasPosition.x, texture->atlasPosition.y, texture->layer - g_texturePagesFirstLayer[page],
+                   width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*) 0);
+   GL_CHECK_ERRORS;
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   GL_CHECK_ERRORS;
+}
+
+/* Opaque pass draws without blending, so image is opaque only if alpha of every texel is 255 */
+static uint8_t isImageOpaque (const uint8_t *data, size_t texelsQuantity)
+{
+   for (const uint8_t *iterator = data + 3, *end = data + texelsQuantity * 4u; iterator < end; iterator += 4)
+   {
+      if (*iterator != 255u)
+         return 0u;
+   }
+   return 1u;
+}
+
+/* Size of texture mustn't change while it is placed, resident size is counted by it */
+static void releaseTextureRectangle (struct LoadedTextures *texture)
+{
+   if (!(texture->flags & CCE_LOADEDTEXTURES_PLACED))
+      return;
+   cce__releaseTextureAtlasRectangle(texture->layer);
+   texture->flags &= ~CCE_LOADEDTEXTURES_PLACED;
+   g_residencyStats.residentSize -= (size_t) texture->size.x * texture->size.y * 4u;
+   --(g_residencyStats.residentTexturesQuantity);
+   map2Dflags |= CCE_PROCESS_TEXTURES;
+}
+
+/* Returns -1 if texture doesn't fit into a layer or all pages are full */
+static int allocateTextureRectangle (struct LoadedTextures *texture)
+{
+   releaseTextureRectangle(texture);
+   if (cce__allocateTextureAtlasRectangle(texture->size, &(texture->atlasPosition), &(texture->layer)) != 0)
+      return -1;
+   texture->flags |= CCE_LOADEDTEXTURES_PLACED;
+   g_residencyStats.residentSize += (size_t) texture->size.x * texture->size.y * 4u;
+   ++(g_residencyStats.residentTexturesQuantity);
+   map2Dflags |= CCE_PROCESS_TEXTURES;
+   return 0;
+}
+
+static void updateTexturePages (void);
+static void placeDummyTexture (void);
+
+static int uploadTexture (void *data, unsigned int width, unsigned int height, const char *name, uint16_t position)
+{
+   struct LoadedTextures *texture = g_textures + position;
+   releaseTextureRectangle(texture);
+   texture->size = (struct cce_u16vec2) {width, height};
+   texture->isOpaque = 0u;
+   if (width > g_textureSize.x || height > g_textureSize.y || allocateTextureRectangle(texture) != 0)
+   {
+      cce__errorPrint("ENGINE::TEXTURE::APPLYING_ERROR:\n%s doesn't fit into texture array or texture pages are full, dummy is drawn instead. "
+                      "Increase textureMaxWidth and textureMaxHeight if it is too big", name);
+      placeDummyTexture();
+      texture->size = (struct cce_u16vec2) {g_dummyTexture.width, g_dummyTexture.height};
+      stbi_image_free(data);
+      return -1;
+   }
+   texture->flags = CCE_LOADEDTEXTURES_PLACED;
+   texture->isOpaque = isImageOpaque(data, (size_t) width * height);
+   updateTexturePages();
+   uploadTextureData(data, width, height, width, texture);
+   stbi_image_free(data);
+   return 0;
+}
+
+static int loadTexture (const char *path, uint16_t position)
+{
+   unsigned int width, height;
+   void *data;
+   data = stbi_load(path, (int*) &width, (int*) &height, NULL, 4);
+   if (!data)
+   {
+      fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\n%s\n", stbi_failure_reason());
+      return -1;
+   }
+   return uploadTexture(data, width, height, path, position);
+}
+
+static int loadTextureFromMemory (const void *file, size_t fileSize, const char *name, uint16_t position)
+{
+   unsigned int width, height;
+   void *data;
+   data = stbi_load_from_memory(file, fileSize, (int*) &width, (int*) &height, NULL, 4);
+   if (!data)
+   {
+      fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\n%s: %s\n", name, stbi_failure_reason());
+      return -1;
+   }
+   return uploadTexture(data, width, height, name, position);
+}
+
+/* ID is image ID or CCE_RESOURCE_DUMMY_IMAGE. Resource pack is checked first, otherwise path is written to texturesPath (caller has to reset it) */
+static const void* findImageTexture (uint32_t ID, size_t *imageSize)
+{
+   const void *image = cceGetPackedResource(CCE_RESOURCE_IMAGE, ID, imageSize);
+   if (image)
+      return image;
+   
+   if (ID == CCE_RESOURCE_DUMMY_IMAGE)
+      memcpy((texturesPath + texturesPathLength), "dummy.png", 10u);
+   else
+      cce__shortToString(texturesPath, ID, ".png");
+   return NULL;
+}
+
+/* Decoded once and kept, it is drawn instead of textures being decoded and textures failed to decode */
+static void loadDummyTexture (void)
+{
+   if (g_dummyTexture.data)
+      return;
+   size_t imageSize;
+   const void *image = findImageTexture(CCE_RESOURCE_DUMMY_IMAGE, &imageSize);
+   if (image)
+      g_dummyTexture.data = stbi_load_from_memory(image, imageSize, &(g_dummyTexture.width), &(g_dummyTexture.height), NULL, 4);
+   else
+      g_dummyTexture.data = stbi_load(texturesPath, &(g_dummyTexture.width), &(g_dummyTexture.height), NULL, 4);
+   *(texturesPath + texturesPathLength) = '\0';
+   if (!g_dummyTexture.data || (unsigned int) g_dummyTexture.width > g_textureSize.x || (unsigned int) g_dummyTexture.height > g_textureSize.y)
+   {
+      cce__criticalErrorPrint("ENGINE::TEXTURE::DUMMY::FAILED_TO_LOAD:\nFailed to load dummy texture, which is drawn while textures are loading: %s",
+                              g_dummyTexture.data ? "it is bigger than textureMaxWidth and textureMaxHeight" : stbi_failure_reason());
+   }
+}
+
+/* Dummy keeps its own rectangle from the first requested texture on, slots without rectangle are pointed at it.
+ * It is the first rectangle of the atlas, so it always fits, and it is uploaded on next cce__updateTexturesArray */
+static void placeDummyTexture (void)
+{
+   if (g_dummyTexture.rectangle.flags & CCE_LOADEDTEXTURES_PLACED)
+      return;
+   loadDummyTexture();
+   g_dummyTexture.rectangle.size = (struct cce_u16vec2) {g_dummyTexture.width, g_dummyTexture.height};
+   if (cce__allocateTextureAtlasRectangle(g_dummyTexture.rectangle.size, &(g_dummyTexture.rectangle.atlasPosition), &(g_dummyTexture.rectangle.layer)) != 0)
+      return;
+   g_dummyTexture.rectangle.flags = CCE_LOADEDTEXTURES_PLACED | CCE_LOADEDTEXTURES_TOBELOADED;
+   map2Dflags |= CCE_PROCESS_TEXTURES;
+}
+
+/* Dummy is cropped if texture is smaller. Rest of bigger rectangle is cleared, so texels of texture placed there before aren't drawn */
+static void uploadDummyTexture (const struct LoadedTextures *texture)
+{
+   loadDummyTexture();
+   const unsigned int width = MIN((unsigned int) g_dummyTexture.width, texture->size.x), height = MIN((unsigned int) g_dummyTexture.height, texture->size.y);
+   if (width == texture->size.x && height == texture->size.y)
+   {
+      uploadTextureData(g_dummyTexture.data, width, height, g_dummyTexture.width, texture);
+      return;
+   }
+   uint8_t *data = calloc((size_t) texture->size.x * texture->size.y, 4u);
+   for (unsigned int row = 0u; row < height; ++row)
+   {
+      memcpy(data + (size_t) row * texture->size.x * 4u, g_dummyTexture.data + (size_t) row * g_dummyTexture.width * 4u, width * 4u);
+   }
+   uploadTextureData(data, texture->size.x, texture->size.y, texture->size.x, texture);
+   free(data);
+}
+
+static void requestImageTexture (uint32_t ID, uint16_t position)
+{
+   size_t imageSize = 0u;
+   const void *image = findImageTexture(ID, &imageSize);
+   cce__requestTextureDecoding(ID, position, image, imageSize, texturesPath);
+   *(texturesPath + texturesPathLength) = '\0';
+}
+
+static int setTextureAttributes (uint16_t ID)
+{
+   int width = 0, height = 0, channels, result;
+   size_t imageSize;
+   const void *image = cceGetPackedResource(CCE_RESOURCE_IMAGE, g_textures[ID].ID, &imageSize);
+   if (image)
+   {
+      result = stbi_info_from_memory(image, imageSize, &width, &height, &channels);
+   }
+   else
+   {
+      cce__shortToString(texturesPath, g_textures[ID].ID, ".png");
+      result = cce__getImageInfo(g_textures[ID].ID, texturesPath, &width, &height, &channels);
+      *(texturesPath + texturesPathLength) = '\0';
+   }
+   g_textures[ID].size = (struct cce_u16vec2){width, height};
+   return result;
+}
+
+/* Image starts decoding as soon as map referencing it is loaded, its rectangle gets placeholder on next cce__updateTexturesArray.
+ * Images which can't be read or don't fit into a layer take size of the dummy, so they are drawn as it */
+static void setTextureToBeLoaded (uint16_t position)
+{
+   struct LoadedTextures *texture = g_textures + position;
+   releaseTextureRectangle(texture);
+   texture->flags = CCE_LOADEDTEXTURES_TOBELOADED;
+   texture->isOpaque = 0u; // Dummy and partly uploaded images are drawn by translucent pass
+   uint8_t isDecoded = 1u;
+   placeDummyTexture();
+   if (!setTextureAttributes(position))
+   {
+      texture->size = (struct cce_u16vec2) {g_dummyTexture.width, g_dummyTexture.height};
+   }
+   if (allocateTextureRectangle(texture) != 0)
+   {
+      cce__errorPrint("ENGINE::TEXTURE::APPLYING_ERROR:\nimage %u doesn't fit into texture array or texture pages are full, dummy is drawn instead. "
+                      "Increase textureMaxWidth and textureMaxHeight if it is too big", texture->ID);
+      texture->size = (struct cce_u16vec2) {g_dummyTexture.width, g_dummyTexture.height};
+      texture->isOpaque = 0u;
+      isDecoded = 0u; // Slot without rectangle draws the dummy rectangle
+   }
+   if (isDecoded)
+   {
+      texture->flags |= CCE_LOADEDTEXTURES_DECODING;
+      requestImageTexture(texture->ID, position);
+   }
+}
+
+/* Pages are added and freed as whole, so existing textures are never copied. Trailing empty layers are already trimmed by atlas */
+static uint8_t getTexturePagesQuantity (uint16_t layersQuantity)
+{
+   uint8_t pagesQuantity = 1u;
+   while (g_texturePagesFirstLayer[pagesQuantity] < layersQuantity)
+      ++pagesQuantity;
+   return pagesQuantity;
+}
+
+/* Bytes of pages which are needed for layers of texture atlas */
+static inline size_t getTexturePagesSize (void)
+{
+   return (size_t) g_texturePagesFirstLayer[getTexturePagesQuantity(cce__getTextureAtlasLayersQuantity())] * g_textureSize.x * g_textureSize.y * 4u;
+}
+
+static void updateTexturePages (void)
+{
+   uint8_t pagesQuantity = getTexturePagesQuantity(cce__getTextureAtlasLayersQuantity());
+   for (; g_texturePagesQuantity < pagesQuantity; ++g_texturePagesQuantity)
+   {
+      g_texturePages[g_texturePagesQuantity] = createTexturePage(g_texturePagesQuantity);
+   }
+   if (g_texturePagesQuantity > pagesQuantity)
+   {
+      glDeleteTextures(g_texturePagesQuantity - pagesQuantity, g_texturePages + pagesQuantity);
+      GL_CHECK_ERRORS;
+      g_texturePagesQuantity = pagesQuantity;
+   }
+}
+
+static void bindTexturePages (void)
+{
+   for (uint8_t i = 0u; i < g_texturePagesQuantity; ++i)
+   {
+      glActiveTexture(GL_TEXTURE0 + i);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, g_texturePages[i]);
+   }
+   glActiveTexture(GL_TEXTURE0);
+   GL_CHECK_ERRORS;
+}
+
+static void updateTextureRectangles (void)
+{
+   uint16_t *rectangles = calloc(g_texturesQuantityAllocated + 1u, 8u * sizeof(uint16_t));
+   for (struct LoadedTextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   {
+      const struct LoadedTextures *placed = (iterator->flags & CCE_LOADEDTEXTURES_PLACED) ? iterator : &(g_dummyTexture.rectangle);
+      const uint8_t page = getTexturePage(placed->layer);
+      uint16_t *rectangle = rectangles + (iterator - g_textures) * 8u;
+      *rectangle       = placed->atlasPosition.x;
+      *(rectangle + 1) = placed->atlasPosition.y;
+      *(rectangle + 2) = placed->layer - g_texturePagesFirstLayer[page];
+      *(rectangle + 3) = page | ((placed == iterator && iterator->isOpaque) << 15);
+      *(rectangle + 4) = placed->size.x;
+      *(rectangle + 5) = placed->size.y;
+   }
+   glBindBuffer(GL_TEXTURE_BUFFER, g_textureRectanglesBuffer);
+   GL_CHECK_ERRORS;
+   glBufferData(GL_TEXTURE_BUFFER, (g_texturesQuantityAllocated + 1u) * 8u * sizeof(uint16_t), rectangles, GL_DYNAMIC_DRAW);
+   GL_CHECK_ERRORS;
+   glBindBuffer(GL_TEXTURE_BUFFER, 0);
+   free(rectangles);
+}
+
+void cce__updateTexturesArray (void)
+{
+   GLuint freeTexturesQuantityFromEnd = 0;
+   for (struct LoadedTextures *iterator = g_textures + g_texturesQuantity - 1;
+        (iterator >= g_textures) && (iterator->dependantMapsQuantity == 0u); --iterator, ++freeTexturesQuantityFromEnd)
+   {
+      releaseTextureRectangle(iterator);
+      setTextureID(iterator - g_textures, UINT32_MAX);
+   }
+
+   g_texturesQuantity -= freeTexturesQuantityFromEnd;
+   g_freeTextureSlotHint = MIN(g_freeTextureSlotHint, g_texturesQuantity);
+   CCE_FIT_ARRAY_TO_SIZE(g_textures);
+   for (struct LoadedTextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->dependantMapsQuantity == 0u)
+      {
+         setTextureID(iterator - g_textures, UINT32_MAX);
+         releaseTextureRectangle(iterator);
+      }
+   }
+   
+   updateTexturePages();
+   if (g_dummyTexture.rectangle.flags & CCE_LOADEDTEXTURES_TOBELOADED)
+   {
+      uploadDummyTexture(&(g_dummyTexture.rectangle));
+      g_dummyTexture.rectangle.flags &= ~CCE_LOADEDTEXTURES_TOBELOADED;
+   }
+   for (struct LoadedTextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->flags & CCE_LOADEDTEXTURES_TOBELOADED)
+      {
+         if (iterator->flags & CCE_LOADEDTEXTURES_PLACED)
+            uploadDummyTexture(iterator);
+         iterator->flags &= ~CCE_LOADEDTEXTURES_TOBELOADED;
+      }
+   }
+   updateTextureRectangles();
+   return;
+}
+
+/* Takes decoded images until upload budget of the frame is spent, called right after cce__updateTexturesArray, so rectangles of results already exist */
+static void uploadDecodedTextures (void)
+{
+   size_t uploadedSize = 0u;
+   struct TextureDecodingJob *job;
+   while (uploadedSize < CCE_TEXTURE_UPLOAD_BUDGET && (job = cce__getDecodedTexture()) != NULL)
+   {
+      struct LoadedTextures *texture = g_textures + job->position;
+      if (job->position < g_texturesQuantity && texture->ID == job->ID && texture->dependantMapsQuantity > 0u && (texture->flags & CCE_LOADEDTEXTURES_DECODING))
+      {
+         texture->flags &= ~CCE_LOADEDTEXTURES_DECODING;
+         if (!job->data)
+         {
+            if (job->path)
+               fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\n%s: %s\n", job->path, job->failureReason);
+            else
+               fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\npacked image %u: %s\n", job->ID, job->failureReason);
+         }
+         else
+         {
+            // Image could be replaced after its size was read, then it is cropped to the rectangle
+            if (job->width != texture->size.x || job->height != texture->size.y)
+               cce__forgetImageInfo(job->ID);
+            uploadTextureData(job->data, MIN((unsigned int) job->width, texture->size.x), MIN((unsigned int) job->height, texture->size.y), job->width, texture);
+            uploadedSize += (size_t) job->width * job->height * 4u;
+            // Rectangle of a smaller image keeps cleared texels, rectangles are updated on next cce__updateTexturesArray
+            texture->isOpaque = (unsigned int) job->width >= texture->size.x && (unsigned int) job->height >= texture->size.y && isImageOpaque(job->data, (size_t) job->width * job->height);
+            if (texture->isOpaque)
+               map2Dflags |= CCE_PROCESS_TEXTURES;
+         }
+      }
+      cce__freeDecodedTexture(job);
+   }
+}
+
+static void updateUBOarray (void)
+{
+   uint16_t freeUBOsQuantityFromEnd = 0;
+   struct UsedUBO *end = g_UBOs + g_UBOsQuantity;
+   for (struct UsedUBO *iterator = g_UBOs; iterator < end; ++iterator)
+   {
+      if ((iterator->flags & 0x3) == 0x3)
       {
          iterator->flags &= 0x1;
-         cce_setUniformBufferToDefault(iterator->UBO, *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
+         cce__setUBOtoDefault(iterator);
       }
       if (iterator->flags & 0x1)
          freeUBOsQuantityFromEnd = 0;
@@ -693,13 +1513,11 @@ static void updateUBOarray (void)
    uint16_t size = CCE_CEIL_SIZE_TO_ALLOCATION_STEP(g_UBOsQuantity);
    if (size < g_UBOsQuantityAllocated)
    {
-      for (struct UsedUBO *iterator = end - freeUBOsQuantityFromEnd; iterator < end; ++iterator)
+      for (struct UsedUBO *iterator = g_UBOs + size; iterator < g_UBOs + g_UBOsQuantityAllocated; ++iterator)
       {
-         glDeleteBuffers(1, &(iterator->UBO));
-         free(iterator->moveGroupValues);
-         free(iterator->extensionGroupValues);
+         deleteUBO(iterator);
       }
-      g_UBOs = realloc(g_UBOs, size);
+      g_UBOs = realloc(g_UBOs, size * sizeof(struct UsedUBO));
       g_UBOsQuantityAllocated = size;
    }
 }
@@ -720,16 +1538,7 @@ uint16_t cce__getFreeUBO (void)
       g_UBOs = realloc(g_UBOs, g_UBOsQuantityAllocated * sizeof(struct UsedUBO));
       for (struct UsedUBO *iterator = g_UBOs + g_UBOsQuantityAllocated - CCE_ALLOCATION_STEP, *end = g_UBOs + g_UBOsQuantityAllocated; iterator < end; ++iterator)
       {
-         glGenBuffers(1u, &(iterator->UBO));
-         GL_CHECK_ERRORS;
-         glBindBuffer(GL_UNIFORM_BUFFER, iterator->UBO);
-         GL_CHECK_ERRORS;
-         glBufferData(GL_UNIFORM_BUFFER, (g_uniformBufferSize), NULL, GL_DYNAMIC_DRAW);
-         GL_CHECK_ERRORS;
-         iterator->flags = 0u;
-         cce_setUniformBufferToDefault(iterator->UBO, *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
-         iterator->moveGroupValues=NULL;
-         iterator->extensionGroupValues = NULL;
+         createUBO(iterator);
       }
    }
    struct UsedUBO *ubo = g_UBOs + g_UBOsQuantity;
@@ -781,9 +1590,10 @@ void cce__allocateUBObuffers (uint16_t uboID, uint16_t moveGroupsQuantity, uint1
 
    if (ubo->flags & 0x2)
    {
-      cce_setUniformBufferToDefault(ubo->UBO, *(bufferUniformsOffsets + CCE_ROTATEANGLESINCOS_OFFSET));
+      cce__setUBOtoDefault(ubo);
       ubo->flags &= 0x1;
    }
+   cce__resizeGroupValuesUBO(ubo);
 }
 
 // Gets called before processing of map logic begins
@@ -793,7 +1603,7 @@ void cce__initLogicMap2D (struct Map2D *map)
    map->temporaryBools = cce__getFreeTemporaryBools();
    cce__allocateUBObuffers(map->UBO_ID, map->moveGroupsQuantity, map->extensionGroupsQuantity);
 
-   if (*g_endianess == CCE_BIG_ENDIAN)
+   if (cceHostEndianess == CCE_BIG_ENDIAN)
    {
       cce__callActions(cce_endianSwapActions, map->staticActionsQuantity, map->staticActionIDs, map->staticActionArgOffsets, map->staticActionArgs);
    }
@@ -815,12 +1625,9 @@ struct UsedUBO* cce__getFreeUBOdata (uint16_t ID)
    return g_UBOs + ID;
 }
 
-uint16_t cce__loadTexture (uint32_t textureID)
+static uint16_t getFreeTextureSlot (void)
 {
-   if (textureID == 0u)
-      return 0u;
-   map2Dflags |= CCE_PROCESS_TEXTURES;
-   uint16_t current_g_texture = 0u;
+   uint16_t current_g_texture = g_freeTextureSlotHint;
    for (;;)
    {
       if (current_g_texture >= g_texturesQuantity)
@@ -829,218 +1636,147 @@ uint16_t cce__loadTexture (uint32_t textureID)
          ++g_texturesQuantity;
          if (g_texturesQuantity > g_texturesQuantityAllocated)
          {
-            CCE_REALLOC_ARRAY(g_textures, (g_texturesQuantityAllocated + CCE_ALLOCATION_STEP));
+            CCE_REALLOC_ARRAY_ZEROED(g_textures, (g_texturesQuantityAllocated + CCE_ALLOCATION_STEP));
          }
          break;
       }
-      if ((g_textures + current_g_texture)->ID == (textureID - 1u))
-      {
-         ++((g_textures + current_g_texture)->dependantMapsQuantity);
-         return current_g_texture + 1u;
-      }
       if ((g_textures + current_g_texture)->dependantMapsQuantity == 0u)
       {
-         uint16_t i = current_g_texture;
-         while (i < g_texturesQuantity)
-         {
-            if ((g_textures + i)->ID == (textureID - 1u))
-            {
-               ++((g_textures + i)->dependantMapsQuantity);
-               return i + 1u;
-            }
-            ++i;
-         }
          break;
       }
       ++current_g_texture;
    }
-   (g_textures + current_g_texture)->ID = (textureID - 1u);
-   (g_textures + current_g_texture)->flags = CCE_LOADEDTEXTURES_TOBELOADED;
+   g_freeTextureSlotHint = current_g_texture;
+   return current_g_texture;
+}
+
+static inline void releaseTextureSlot (uint16_t position)
+{
+   if (--((g_textures + position)->dependantMapsQuantity) == 0u && position < g_freeTextureSlotHint)
+      g_freeTextureSlotHint = position;
+}
+
+static void reloadEvictedTexture (uint16_t position)
+{
+   setTextureToBeLoaded(position);
+   ++(g_residencyStats.reloadsQuantity);
+}
+
+uint16_t cce__loadTexture (uint32_t textureID)
+{
+   if (textureID == 0u)
+      return 0u;
+   map2Dflags |= CCE_PROCESS_TEXTURES;
+   uint16_t current_g_texture = findTextureSlot(textureID - 1u);
+   if (current_g_texture != UINT16_MAX)
+   {
+      ++((g_textures + current_g_texture)->dependantMapsQuantity);
+      if ((g_textures + current_g_texture)->flags & CCE_LOADEDTEXTURES_EVICTED)
+         reloadEvictedTexture(current_g_texture);
+      return current_g_texture + 1u;
+   }
+   current_g_texture = getFreeTextureSlot();
+   setTextureID(current_g_texture, textureID - 1u);
    (g_textures + current_g_texture)->dependantMapsQuantity = 1u;
-   setTextureAttributes(current_g_texture);
+   setTextureToBeLoaded(current_g_texture);
    return current_g_texture + 1u;
 }
 
 CCE_PUBLIC_OPTIONS uint16_t cceLoadTexture (char *path)
 {
-   uint16_t current_g_texture = 0u;
-   for (;;)
+   uint16_t current_g_texture = getFreeTextureSlot();
+   if (loadTexture(path, current_g_texture) != 0)
    {
-      if (current_g_texture >= g_texturesQuantity)
-      {
-         current_g_texture = g_texturesQuantity;
-         ++g_texturesQuantity;
-         if (g_texturesQuantity > g_texturesQuantityAllocated)
-         {
-            CCE_REALLOC_ARRAY(g_textures, (g_texturesQuantityAllocated + CCE_ALLOCATION_STEP));
-         }
-         break;
-      }
-      if ((g_textures + current_g_texture)->dependantMapsQuantity == 0u)
-      {
-         break;
-      }
-      ++current_g_texture;
+      --g_texturesQuantity;
+      return 0;
    }
-   if (loadTexture(path, current_g_texture) != 0)
+   setTextureID(current_g_texture, UINT32_MAX);
+   (g_textures + current_g_texture)->dependantMapsQuantity = 1u;
+   return current_g_texture + 1u;
+}
+
+/* name is path relative to resource pack root, returns 0 if there's no such file in the pack */
+CCE_PUBLIC_OPTIONS uint16_t cceLoadPackedTexture (const char *name)
+{
+   size_t imageSize;
+   const void *image = cceGetPackedResource(CCE_RESOURCE_FILE, cceResourceNameHash(name), &imageSize);
+   if (!image)
+      return 0;
+   uint16_t current_g_texture = getFreeTextureSlot();
+   if (loadTextureFromMemory(image, imageSize, name, current_g_texture) != 0)
    {
       --g_texturesQuantity;
       return 0;
    }
-   (g_textures + current_g_texture)->ID = UINT32_MAX;
+   setTextureID(current_g_texture, UINT32_MAX);
    (g_textures + current_g_texture)->dependantMapsQuantity = 1u;
    return current_g_texture + 1u;
 }
 
+/* Textures of elements are replaced by texture slots + 1, every slot is counted once per map. Returned slots are in order of first use by elements */
 uint16_t* cce__loadTexturesMap2D (struct Map2DElement *elements, uint32_t elementsQuantity, uint16_t *texturesLoadedMapReliesOnQuantity)
 {
    map2Dflags |= CCE_PROCESS_TEXTURES;
-   uint32_t *texturesMapReliesOn = NULL;
+   uint16_t *texturesMapReliesOn = NULL;
    uint16_t  texturesMapReliesOnQuantity = 0u, texturesMapReliesOnAllocated = 0u;
-   cce_ubyte isLoaded = 0u;
-   struct ElementsArray
-   {
-      struct Map2DElement **elements;
-      uint32_t elementsQuantity;
-      uint32_t elementsQuantityAllocated;
-   } *elementsWithTexture = NULL;
-   #define SET_TEXTUREID_FOR_ELEMENTS_AND_FREE(x, id) \
-   for (struct Map2DElement **ITERATOR = (x)->elements, **END = (x)->elements + (x)->elementsQuantity; ITERATOR < END; ++ITERATOR) \
-   { \
-      (**ITERATOR).textureInfo.ID = (id); \
-   } \
-   free(x->elements)
+   // New slots are appended at most once per element, so they are below g_texturesQuantity + elementsQuantity
+   uint8_t *isReliedOn = calloc((g_texturesQuantity + elementsQuantity) / 8u + 1u, sizeof(uint8_t));
    for (struct Map2DElement *iterator = elements, *end = elements + elementsQuantity; iterator < end; ++iterator)
    {
       uint32_t ID = iterator->textureInfo.ID;
       if (ID == 0u) continue;
-      for (uint32_t *jiterator = texturesMapReliesOn, *jend = texturesMapReliesOn + texturesMapReliesOnQuantity; jiterator < jend; ++jiterator)
+      uint16_t position = findTextureSlot(ID - 1u);
+      if (position == UINT16_MAX)
       {
-         if ((*jiterator) == (ID - 1u))
-         {
-            isLoaded = 1u;
-            struct ElementsArray *current = (elementsWithTexture + (jiterator - texturesMapReliesOn));
-            if (current->elementsQuantity >= current->elementsQuantityAllocated)
-            {
-               CCE_REALLOC_ARRAY(current->elements, current->elementsQuantity + 1);
-            }
-            current->elements[current->elementsQuantity] = iterator;
-            ++current->elementsQuantity;
-            break;
-         }
+         position = getFreeTextureSlot();
+         setTextureID(position, ID - 1u); // 0u is invalid for openGL shaders, but perfectly fine here
+         (g_textures + position)->dependantMapsQuantity = 0u;
+         setTextureToBeLoaded(position);
+      }
+      else if ((g_textures + position)->flags & CCE_LOADEDTEXTURES_EVICTED)
+      {
+         reloadEvictedTexture(position);
       }
-      if (!isLoaded)
+      if (!(*(isReliedOn + position / 8u) & (1u << (position % 8u))))
       {
+         *(isReliedOn + position / 8u) |= (1u << (position % 8u));
+         ++((g_textures + position)->dependantMapsQuantity);
          if (texturesMapReliesOnQuantity == texturesMapReliesOnAllocated)
          {
             texturesMapReliesOnAllocated += CCE_ALLOCATION_STEP;
-            texturesMapReliesOn = realloc(texturesMapReliesOn, texturesMapReliesOnAllocated * sizeof(uint32_t));
-            elementsWithTexture = realloc(elementsWithTexture, texturesMapReliesOnAllocated * sizeof(struct ElementsArray));
+            texturesMapReliesOn = realloc(texturesMapReliesOn, texturesMapReliesOnAllocated * sizeof(uint16_t));
          }
-         CCE_ALLOC_ARRAY(elementsWithTexture[texturesMapReliesOnQuantity].elements);
-         elementsWithTexture[texturesMapReliesOnQuantity].elementsQuantity = 1;
-         elementsWithTexture[texturesMapReliesOnQuantity].elements[0] = iterator;
-         (*(texturesMapReliesOn + texturesMapReliesOnQuantity)) = (ID - 1u); // 0u is invalid for openGL shaders, but perfectly fine here
+         *(texturesMapReliesOn + texturesMapReliesOnQuantity) = position + 1u;
          ++texturesMapReliesOnQuantity;
       }
+      iterator->textureInfo.ID = position + 1u; // 0u is invalid for openGL shaders (it's the way to say "We don't need texture there")
    }
-   uint16_t *texturesLoadedMapReliesOn = (uint16_t*) texturesMapReliesOn;
-   uint16_t *literator = texturesLoadedMapReliesOn;
-   uint16_t *end = texturesLoadedMapReliesOn + texturesMapReliesOnQuantity;
-   uint32_t *jiterator, *kiterator = texturesMapReliesOn;
-   uint32_t tmp;
-   uint16_t *freeLoadedTextures = NULL;
-   uint16_t freeLoadedTexturesQuantity = 0u, freeLoadedTexturesAllocated = 0u;
-   struct ElementsArray *elementsWithTextureIterator = elementsWithTexture;
-   isLoaded = 0u;
-   for (uint16_t current_g_texture = 0u; current_g_texture < g_texturesQuantity; ++current_g_texture)
-   {
-      jiterator = kiterator;
-      if ((g_textures + current_g_texture)->ID)
-      {
-         for (uint16_t *iterator = literator; iterator < end; ++iterator, ++jiterator)
-         {
-            if ((*jiterator) == ((g_textures + current_g_texture)->ID))
-            {
-               tmp = (*jiterator);
-               (*jiterator) = (*kiterator);
-               (*kiterator) = tmp;
-               (*literator) = current_g_texture + 1u;
-               SET_TEXTUREID_FOR_ELEMENTS_AND_FREE(elementsWithTextureIterator, current_g_texture + 1u);
-               ++((g_textures + current_g_texture)->dependantMapsQuantity);
-               ++literator;
-               ++kiterator;
-               ++elementsWithTextureIterator;
-               isLoaded = 1u;
-               break;
-            }
-         }
-         if ((!isLoaded) && (!(g_textures + current_g_texture)->dependantMapsQuantity) && ((end - literator) > freeLoadedTexturesQuantity))
-         {
-            if (freeLoadedTexturesQuantity == freeLoadedTexturesAllocated)
-            {
-               freeLoadedTexturesAllocated += CCE_ALLOCATION_STEP;
-               freeLoadedTextures = (uint16_t *) realloc(freeLoadedTextures, freeLoadedTexturesAllocated * sizeof(uint16_t));
-            }
-            (*(freeLoadedTextures + freeLoadedTexturesQuantity)) = current_g_texture;
-            ++freeLoadedTexturesQuantity;
-         }
-      }
-      else if ((end - literator) > freeLoadedTexturesQuantity)
-      {
-         if (freeLoadedTexturesQuantity == freeLoadedTexturesAllocated)
-         {
-            freeLoadedTexturesAllocated += CCE_ALLOCATION_STEP;
-            freeLoadedTextures = (uint16_t *) realloc(freeLoadedTextures, freeLoadedTexturesAllocated * sizeof(uint16_t));
-         }
-         (*(freeLoadedTextures + freeLoadedTexturesQuantity)) = current_g_texture;
-         ++freeLoadedTexturesQuantity;
-      }
-   }
-   uint16_t *iterator = freeLoadedTextures, *iend = freeLoadedTextures + freeLoadedTexturesQuantity;
-   while ((literator < end) && (iterator < iend))
-   {
-      ((g_textures + (*iterator))->ID) = *kiterator;
-      (*literator) = (*iterator) + 1u;
-      SET_TEXTUREID_FOR_ELEMENTS_AND_FREE(elementsWithTextureIterator, (*iterator) + 1u);
-      ((g_textures + (*iterator))->dependantMapsQuantity) = 1;
-      ((g_textures + (*iterator))->flags) = CCE_LOADEDTEXTURES_TOBELOADED;
-      setTextureAttributes(*iterator);
-      ++literator, ++kiterator, ++iterator, ++elementsWithTextureIterator;
-   }
-   free(freeLoadedTextures);
-   uint16_t current_g_texture = g_texturesQuantity;
-   while (literator < end)
-   {
-      if (current_g_texture >= g_texturesQuantity)
-      {
-         ++g_texturesQuantity;
-         if (g_texturesQuantity > g_texturesQuantityAllocated)
-         {
-            CCE_REALLOC_ARRAY(g_textures, g_texturesQuantityAllocated + CCE_ALLOCATION_STEP);
-         }
-      }
-      ((g_textures + current_g_texture)->ID) = (*kiterator);
-      (*literator) = current_g_texture + 1u; // 0u is invalid for openGL shaders (it's the way to say "We don't need texture there"), but perfectly fine here
-      SET_TEXTUREID_FOR_ELEMENTS_AND_FREE(elementsWithTextureIterator, current_g_texture + 1u);
-      ((g_textures + current_g_texture)->dependantMapsQuantity) = 1;
-      ((g_textures + current_g_texture)->flags) = CCE_LOADEDTEXTURES_TOBELOADED;
-      setTextureAttributes(current_g_texture);
-      ++literator, ++kiterator, ++current_g_texture, ++elementsWithTextureIterator;
-   }
+   free(isReliedOn);
    *texturesLoadedMapReliesOnQuantity = texturesMapReliesOnQuantity;
-   free(elementsWithTexture);
    if (texturesMapReliesOnQuantity > 0)
       return (uint16_t*) realloc(texturesMapReliesOn, texturesMapReliesOnQuantity * sizeof(uint16_t));
    free(texturesMapReliesOn);
    return NULL;
 }
 
+/* textureIDs are in element's format (image ID + 1). Used for baked maps, which already know their texture list */
+uint16_t* cce__loadTexturesListMap2D (const uint32_t *textureIDs, uint16_t texturesQuantity)
+{
+   if (!texturesQuantity)
+      return NULL;
+   uint16_t *texturesMapReliesOn = malloc(texturesQuantity * sizeof(uint16_t));
+   for (uint16_t *iterator = texturesMapReliesOn, *end = texturesMapReliesOn + texturesQuantity; iterator < end; ++iterator, ++textureIDs)
+   {
+      *iterator = cce__loadTexture(*textureIDs);
+   }
+   return texturesMapReliesOn;
+}
+
 void cce__releaseTextures (uint16_t *texturesMapReliesOn, uint16_t texturesMapReliesOnQuantity)
 {
    for (uint16_t *iterator = texturesMapReliesOn, *end = texturesMapReliesOn + texturesMapReliesOnQuantity; iterator < end; ++iterator)
    {
-      --((g_textures + (*(iterator) - 1u))->dependantMapsQuantity);
+      releaseTextureSlot(*(iterator) - 1u);
    }
    free(texturesMapReliesOn);
    return;
@@ -1051,10 +1787,180 @@ void cce__releaseTexture (uint16_t textureID)
    if (textureID == 0u)
       return;
    
-   --((g_textures + (textureID - 1u))->dependantMapsQuantity);
+   releaseTextureSlot(textureID - 1u);
    return;
 }
 
+/* 0 turns budget off */
+CCE_PUBLIC_OPTIONS void cceSetTexturesMemoryBudget (size_t budget)
+{
+   g_texturesMemoryBudget = budget ? budget : SIZE_MAX;
+   g_textureResidencyRetryFrame = 0u;
+}
+
+CCE_PUBLIC_OPTIONS struct TextureResidencyStats cceGetTextureResidencyStats (void)
+{
+   struct TextureResidencyStats stats = g_residencyStats;
+   stats.budget = g_texturesMemoryBudget;
+   stats.allocatedSize = getTexturePagesSize();
+   return stats;
+}
+
+/* Called right before the map is drawn. Placeholders are uploaded at once, so the map is never drawn with rectangles of other textures */
+static void reloadEvictedTexturesMap2D (struct Map2D *map)
+{
+   map->isTextureEvicted = 0u;
+   uint8_t isReloaded = 0u;
+   for (uint16_t *iterator = map->texturesMapReliesOn, *end = map->texturesMapReliesOn + map->texturesMapReliesOnQuantity; iterator < end; ++iterator)
+   {
+      if ((g_textures + *iterator - 1u)->flags & CCE_LOADEDTEXTURES_EVICTED)
+      {
+         reloadEvictedTexture(*iterator - 1u);
+         isReloaded = 1u;
+      }
+   }
+   if (!isReloaded)
+      return;
+   cce__updateTexturesArray();
+   map2Dflags &= ~CCE_PROCESS_TEXTURES;
+   bindTexturePages();
+}
+
+static void markTexturesUsedByMap2D (const struct Map2D *map, uint32_t *lastUsedFrames, uint16_t *mapReferences)
+{
+   for (const uint16_t *iterator = map->texturesMapReliesOn, *end = map->texturesMapReliesOn + map->texturesMapReliesOnQuantity; iterator < end; ++iterator)
+   {
+      ++(*(mapReferences + *iterator - 1u));
+      if (*(lastUsedFrames + *iterator - 1u) < map->lastDrawnFrame)
+         *(lastUsedFrames + *iterator - 1u) = map->lastDrawnFrame;
+   }
+}
+
+static void markEvictedTexturesMap2D (struct Map2D *map)
+{
+   for (const uint16_t *iterator = map->texturesMapReliesOn, *end = map->texturesMapReliesOn + map->texturesMapReliesOnQuantity; iterator < end; ++iterator)
+   {
+      if ((g_textures + *iterator - 1u)->flags & CCE_LOADEDTEXTURES_EVICTED)
+      {
+         map->isTextureEvicted = 1u;
+         return;
+      }
+   }
+}
+
+#define CCE_TEXTURE_RESIDENCY_RETRY_FRAMES 60u
+#define CCE_TEXTURE_EVICTION_MIN_AGE 120u /* Textures drawn fewer frames ago are never evicted */
+
+struct TextureEvictionCandidate
+{
+   uint32_t lastUsedFrame;
+   uint16_t position;
+};
+
+static int compareTextureEvictionCandidates (const void *a, const void *b)
+{
+   uint32_t first = ((const struct TextureEvictionCandidate*) a)->lastUsedFrame, second = ((const struct TextureEvictionCandidate*) b)->lastUsedFrame;
+   return (first > second) - (first < second);
+}
+
+/* Texels are copied on GPU to a rectangle in layers before layersLimit. Returns -1 if there's no place for texture there */
+static int moveTextureRectangle (struct LoadedTextures *texture, uint16_t layersLimit)
+{
+   struct cce_u16vec2 position;
+   uint16_t layer;
+   if (cce__allocateTextureAtlasRectangleBefore(texture->size, layersLimit, &position, &layer) != 0)
+      return -1;
+   const uint8_t fromPage = getTexturePage(texture->layer), toPage = getTexturePage(layer);
+   glBindFramebuffer(GL_READ_FRAMEBUFFER, g_copyFramebuffer);
+   glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, g_texturePages[fromPage], 0, texture->layer - g_texturePagesFirstLayer[fromPage]);
+   GL_CHECK_ERRORS;
+   glBindTexture(GL_TEXTURE_2D_ARRAY, g_texturePages[toPage]);
+   glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, position.x, position.y, layer - g_texturePagesFirstLayer[toPage],
+                       texture->atlasPosition.x, texture->atlasPosition.y, texture->size.x, texture->size.y);
+   GL_CHECK_ERRORS;
+   glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+   GL_CHECK_ERRORS;
+   cce__releaseTextureAtlasRectangle(texture->layer);
+   texture->atlasPosition = position;
+   texture->layer = layer;
+   map2Dflags |= CCE_PROCESS_TEXTURES;
+   return 0;
+}
+
+/* Least recently drawn textures are evicted until the rest take no more than the pages budget allows,
+ * then textures left in the pages after them are moved down, so these pages are freed (pages are freed only from the last one).
+ * Texture is evicted only if every dependant is a loaded map and none of them was drawn for CCE_TEXTURE_EVICTION_MIN_AGE frames.
+ * Textures of dynamic map, the dummy and ones loaded by cceLoadTexture (they can't be loaded again) always stay */
+static void updateTextureResidency (struct Map2Darray *maps)
+{
+   uint32_t *lastUsedFrames = calloc(g_texturesQuantity + 1u, sizeof(uint32_t));
+   uint16_t *mapReferences = calloc(g_texturesQuantity + 1u, sizeof(uint16_t));
+   markTexturesUsedByMap2D(maps->main, lastUsedFrames, mapReferences);
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator)
+   {
+      markTexturesUsedByMap2D(*iterator, lastUsedFrames, mapReferences);
+   }
+   for (struct DynamicMap2DElement *iterator = g_dynamicMap->elements, *end = g_dynamicMap->elements + g_dynamicMap->elementsQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->textureElementReliesOn)
+         *(lastUsedFrames + iterator->textureElementReliesOn - 1u) = g_frame;
+   }
+   
+   struct TextureEvictionCandidate *candidates = malloc((g_texturesQuantity + 1u) * sizeof(struct TextureEvictionCandidate));
+   uint16_t candidatesQuantity = 0u;
+   for (uint16_t i = 0u; i < g_texturesQuantity; ++i)
+   {
+      const struct LoadedTextures *texture = g_textures + i;
+      if ((texture->flags & CCE_LOADEDTEXTURES_PLACED) && texture->ID != UINT32_MAX && texture->dependantMapsQuantity > 0u &&
+          texture->dependantMapsQuantity == *(mapReferences + i) && g_frame - *(lastUsedFrames + i) >= CCE_TEXTURE_EVICTION_MIN_AGE)
+      {
+         *(candidates + candidatesQuantity) = (struct TextureEvictionCandidate) {*(lastUsedFrames + i), i};
+         ++candidatesQuantity;
+      }
+   }
+   free(mapReferences);
+   free(lastUsedFrames);
+   qsort(candidates, candidatesQuantity, sizeof(struct TextureEvictionCandidate), compareTextureEvictionCandidates);
+   
+   updateTexturePages();
+   const size_t layerSize = (size_t) g_textureSize.x * g_textureSize.y * 4u;
+   const uint8_t pagesQuantity = getTexturePagesQuantity(cce__getTextureAtlasLayersQuantity());
+   uint8_t keptPagesQuantity = 1u;
+   while (keptPagesQuantity < pagesQuantity && g_texturePagesFirstLayer[keptPagesQuantity + 1u] * layerSize <= g_texturesMemoryBudget)
+      ++keptPagesQuantity;
+   const uint16_t keptLayersQuantity = g_texturePagesFirstLayer[keptPagesQuantity];
+   uint16_t evictedQuantity = 0u;
+   for (struct TextureEvictionCandidate *iterator = candidates, *end = candidates + candidatesQuantity;
+        iterator < end && g_residencyStats.residentSize > keptLayersQuantity * layerSize; ++iterator, ++evictedQuantity)
+   {
+      struct LoadedTextures *texture = g_textures + iterator->position;
+      g_residencyStats.evictedSize += (size_t) texture->size.x * texture->size.y * 4u;
+      releaseTextureRectangle(texture);
+      texture->flags = CCE_LOADEDTEXTURES_EVICTED;
+   }
+   g_residencyStats.evictionsQuantity += evictedQuantity;
+   free(candidates);
+   
+   if (keptPagesQuantity < pagesQuantity)
+   {
+      for (struct LoadedTextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+      {
+         if ((iterator->flags & CCE_LOADEDTEXTURES_PLACED) && iterator->layer >= keptLayersQuantity && moveTextureRectangle(iterator, keptLayersQuantity) != 0)
+            break;
+      }
+   }
+   if (getTexturePagesSize() > g_texturesMemoryBudget)
+      g_textureResidencyRetryFrame = g_frame + CCE_TEXTURE_RESIDENCY_RETRY_FRAMES;
+   if (!evictedQuantity)
+      return;
+   
+   markEvictedTexturesMap2D(maps->main);
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator)
+   {
+      markEvictedTexturesMap2D(*iterator);
+   }
+}
+
 cce_ubyte cce__checkCollision (const uint32_t *group1firstID, uint16_t groups1quantity, const uint32_t *group2firstID, uint16_t groups2quantity,
                                const cce_void *elements1, size_t element1size, const cce_void *elements2, size_t element2size)
 {
@@ -1126,102 +2032,330 @@ CCE_PUBLIC_OPTIONS void cceSetLoadedMap2D (uint16_t number, struct cce_i32vec2 g
    map2Dflags |= CCE_PROCESS_LOADEDMAP2D;
 }
 
-static struct Map2Darray* loadMap2DwithDependies (struct Map2Darray *maps, uint16_t number)
+static void reserveNearestMaps2D (uint16_t quantity)
 {
-   if (!maps)
+   if (quantity > g_nearestMapsQuantityAllocated)
    {
-      maps = (struct Map2Darray*) calloc(1u, sizeof(struct Map2Darray));
+      g_nearestMapsQuantityAllocated = quantity;
+      g_nearestMaps = realloc(g_nearestMaps, quantity * sizeof(struct Map2D*));
+      g_nearestMapsOffsets = realloc(g_nearestMapsOffsets, quantity * sizeof(struct cce_i32vec2));
    }
+}
+
+/* Dependant maps are exit maps of main map. Maps that are already loaded are reused */
+static void loadExitMaps2D (struct Map2Darray *maps, uint16_t number)
+{
    if (maps->main)
    {
-      uint8_t oldExitMapsQuantity = maps->main->exitMapsQuantity;
-      if (maps->main->ID == number)
-         return maps;
-      if ((((map2Dflags & CCE_PROCESS_LOGIC_FLAGS) == CCE_PROCESS_LOGIC_FOR_VISIBLE_MAPS) ||
-           ((map2Dflags & CCE_PROCESS_LOGIC_FLAGS) == CCE_DONT_PROCESS_LOGIC)) &&
-           ((map2Dflags & CCE_FORCE_INITIALIZE_MAP_ONLOAD) == 0))
-      {
-         cce__releaseTemporaryBools(maps->main->temporaryBools);
-         cce__releaseUBO(maps->main->UBO_ID);
-      }
-      if (maps->dependies)
+      struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity;
+      while (iterator < end && (*iterator)->ID != number)
+         ++iterator;
+      if (iterator < end)
       {
-         for (struct Map2D **iterator = maps->dependies, **end = (maps->dependies + oldExitMapsQuantity - 1u);; ++iterator)
-         {
-            if (((*iterator)->ID) == number)
-            {
-               swapMap2D(&(maps->main), iterator);
-               break;
-            }
-            if (iterator >= end)
-            {
-               cceFreeMap2D(maps->main);
-               maps->main = cceLoadMap2D(number);
-               break;
-            }
-         }
+         swapMap2D(&(maps->main), iterator);
       }
       else
       {
          cceFreeMap2D(maps->main);
          maps->main = cceLoadMap2D(number);
       }
-      if (!(maps->main->exitMapsQuantity))
+   }
+   else
+   {
+      maps->main = cceLoadMap2D(number);
+   }
+   
+   struct Map2D **dependies = (struct Map2D**) malloc(maps->main->exitMapsQuantity * sizeof(struct Map2D*));
+   struct cce_i32vec2 *offsets = (struct cce_i32vec2*) malloc(maps->main->exitMapsQuantity * sizeof(struct cce_i32vec2));
+   struct Map2D **j = dependies;
+   struct cce_i32vec2 *offset = offsets;
+   for (struct ExitMap2D *i = maps->main->exitMaps, *iend = (maps->main->exitMaps + maps->main->exitMapsQuantity); i < iend; ++i, ++j, ++offset)
+   {
+      *offset = (struct cce_i32vec2) {i->xOffset, i->yOffset};
+      for (struct Map2D **k = maps->dependies, **kend = (maps->dependies + maps->dependiesQuantity);; ++k)
       {
-         if (maps->dependies)
+         if (k >= kend)
+         {
+            (*j) = cceLoadMap2D(i->ID);
+            break;
+         }
+         if ((*k) == NULL) continue;
+         if ((*k)->ID == i->ID)
          {
-            for (struct Map2D **iterator = maps->dependies, **end = (maps->dependies + oldExitMapsQuantity - 1u); iterator <= end; ++iterator)
-            {
-               cceFreeMap2D((*iterator));
-            }
-            free(maps->dependies);
-            maps->dependies = NULL;
+            (*j) = (*k);
+            (*k) = NULL;
+            break;
          }
       }
+   }
+   for (struct Map2D **iterator = maps->dependies, **end = (maps->dependies + maps->dependiesQuantity); iterator < end; ++iterator)
+   {
+      cceFreeMap2D((*iterator));
+   }
+   free(maps->dependies);
+   free(maps->dependiesOffsets);
+   maps->dependies = dependies;
+   maps->dependiesOffsets = offsets;
+   maps->dependiesQuantity = maps->main->exitMapsQuantity;
+   reserveNearestMaps2D(maps->dependiesQuantity);
+}
+
+#define CCE_DYNAMIC_MAP2D_REBASE_DISTANCE 0x40000000
+#define CCE_WORLD_MAP2D_NO_CELL ((struct cce_u32vec2) {UINT32_MAX, UINT32_MAX})
+
+static struct WorldMap2Dmap* findWorldMap2Dmap (uint32_t ID)
+{
+   size_t position = cceBinarySearch(&(g_world->maps->ID), g_world->mapsQuantity, sizeof(uint32_t), sizeof(struct WorldMap2Dmap), ID);
+   return (position < g_world->mapsQuantity && (g_world->maps + position)->ID == ID) ? g_world->maps + position : NULL;
+}
+
+static inline uint8_t isPointInWorldMap2Dmap (const struct WorldMap2Dmap *map, struct cce_worldvec2 point)
+{
+   return point.x >= map->boundsMin.x && point.x < map->boundsMax.x && point.y >= map->boundsMin.y && point.y < map->boundsMax.y;
+}
+
+static inline uint8_t isRectangleIntersectingWorldMap2Dmap (const struct WorldMap2Dmap *map, int64_t x1, int64_t y1, int64_t x2, int64_t y2)
+{
+   return map->boundsMin.x < x2 && map->boundsMax.x > x1 && map->boundsMin.y < y2 && map->boundsMax.y > y1;
+}
+
+/* Cell of the point, points outside the grid are clamped to the nearest cell */
+static struct cce_u32vec2 getPointCellWorldMap2D (struct cce_worldvec2 point)
+{
+   int64_t x = ((int64_t) point.x - g_world->gridOrigin.x), y = ((int64_t) point.y - g_world->gridOrigin.y);
+   x = (x < 0) ? 0 : x / g_world->cellSize.x;
+   y = (y < 0) ? 0 : y / g_world->cellSize.y;
+   return (struct cce_u32vec2) {(x >= g_world->gridSize.x) ? g_world->gridSize.x - 1u : (uint32_t) x,
+                                (y >= g_world->gridSize.y) ? g_world->gridSize.y - 1u : (uint32_t) y};
+}
+
+static const uint16_t* getWorldMap2DcellMaps (uint32_t x, uint32_t y, uint32_t *quantity)
+{
+   const uint32_t *cellStart = g_world->cellStarts + y * g_world->gridSize.x + x;
+   *quantity = *(cellStart + 1) - *cellStart;
+   return g_world->cellMaps + *cellStart;
+}
+
+CCE_PUBLIC_OPTIONS uint32_t cceGetMapsAtPointWorldMap2D (struct cce_worldvec2 point, uint32_t *mapIDs, uint32_t maxQuantity)
+{
+   if (!g_world)
+      return 0u;
+   struct cce_u32vec2 cell = getPointCellWorldMap2D(point);
+   uint32_t cellMapsQuantity, mapsQuantity = 0u;
+   for (const uint16_t *iterator = getWorldMap2DcellMaps(cell.x, cell.y, &cellMapsQuantity), *end = iterator + cellMapsQuantity;
+        iterator < end && mapsQuantity < maxQuantity; ++iterator)
+   {
+      if (isPointInWorldMap2Dmap(g_world->maps + *iterator, point))
+         *(mapIDs + mapsQuantity++) = (g_world->maps + *iterator)->ID;
+   }
+   return mapsQuantity;
+}
+
+/* Render offsets are 32-bit, maps further than that from the main map are clamped to the edge of the range */
+static int32_t clampWorldOffsetMap2D (int64_t offset)
+{
+   if (offset < INT32_MIN || offset > INT32_MAX)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::OFFSET_OUT_OF_RANGE:\n%lld doesn't fit 32-bit offset and is clamped", (long long) offset);
+      return (offset < 0) ? INT32_MIN : INT32_MAX;
+   }
+   return (int32_t) offset;
+}
+
+static struct cce_worldvec2 getCameraWorldMap2D (const struct WorldMap2Dmap *mainMap)
+{
+   const int64_t x = (int64_t) (mainMap ? mainMap->origin.x : 0) - cce__globalOffset.x;
+   const int64_t y = (int64_t) (mainMap ? mainMap->origin.y : 0) - cce__globalOffset.y;
+   if (sizeof(cce_world_coord) < sizeof(int64_t))
+      return (struct cce_worldvec2) {clampWorldOffsetMap2D(x), clampWorldOffsetMap2D(y)};
+   return (struct cce_worldvec2) {x, y};
+}
+
+/* Camera position in world coordinates, it is position in current map when there's no world index */
+CCE_PUBLIC_OPTIONS struct cce_worldvec2 cceGetCameraWorldMap2D (void)
+{
+   return getCameraWorldMap2D(g_world ? findWorldMap2Dmap(cce__loadedMap2Dnumber) : NULL);
+}
+
+CCE_PUBLIC_OPTIONS int cceLoadWorldMap2D (uint16_t number)
+{
+   struct WorldMap2D *world = cce__loadWorldMap2D(number);
+   if (!world)
+      return -1;
+   cce__freeWorldMap2D(g_world);
+   g_world = world;
+   g_worldCell = CCE_WORLD_MAP2D_NO_CELL;
+   map2Dflags |= CCE_PROCESS_NEAREST_MAPS;
+   return 0;
+}
+
+/* Maps within radius cells from the camera's cell are loaded, they are freed once they are further than radius + hysteresis */
+CCE_PUBLIC_OPTIONS void cceSetStreamingRadiusWorldMap2D (uint32_t radius, uint32_t hysteresis)
+{
+   g_worldRadius = radius;
+   g_worldHysteresis = hysteresis;
+   g_worldCell = CCE_WORLD_MAP2D_NO_CELL;
+   map2Dflags |= CCE_PROCESS_NEAREST_MAPS;
+}
+
+static void setWorldMap2Doffsets (struct Map2Darray *maps, const struct WorldMap2Dmap *mainMap)
+{
+   maps->dependiesOffsets = realloc(maps->dependiesOffsets, maps->dependiesQuantity * sizeof(struct cce_i32vec2));
+   struct cce_i32vec2 *offset = maps->dependiesOffsets;
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator, ++offset)
+   {
+      const struct WorldMap2Dmap *map = findWorldMap2Dmap((*iterator)->ID);
+      if (map)
+         *offset = (struct cce_i32vec2) {clampWorldOffsetMap2D((int64_t) map->origin.x - mainMap->origin.x), clampWorldOffsetMap2D((int64_t) map->origin.y - mainMap->origin.y)};
+      else
+         *offset = (struct cce_i32vec2) {0, 0}; // Not a part of the world, freed by next residency update
+   }
+   reserveNearestMaps2D(maps->dependiesQuantity);
+}
+
+/* Main map is swapped with a resident map, previous main map stays resident until it is far enough from the camera */
+static void loadWorldMaps2D (struct Map2Darray *maps, uint16_t number)
+{
+   if (maps->main)
+   {
+      struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity;
+      while (iterator < end && (*iterator)->ID != number)
+         ++iterator;
+      if (iterator < end)
+      {
+         swapMap2D(&(maps->main), iterator);
+      }
       else
       {
-         struct Map2D **dependies = (struct Map2D**) malloc(maps->main->exitMapsQuantity * sizeof(struct Map2D*));
-         struct Map2D **j = dependies;
-         for (struct ExitMap2D *i = maps->main->exitMaps, *iend = (maps->main->exitMaps + maps->main->exitMapsQuantity); i < iend; ++i, ++j)
+         maps->dependies = realloc(maps->dependies, (maps->dependiesQuantity + 1u) * sizeof(struct Map2D*));
+         *(maps->dependies + maps->dependiesQuantity++) = maps->main;
+         maps->main = cceLoadMap2D(number);
+      }
+   }
+   else
+   {
+      maps->main = cceLoadMap2D(number);
+   }
+   const struct WorldMap2Dmap *mainMap = findWorldMap2Dmap(maps->main->ID);
+   if (mainMap)
+      setWorldMap2Doffsets(maps, mainMap);
+   g_worldCell = CCE_WORLD_MAP2D_NO_CELL;
+}
+
+static void updateResidencyWorldMap2D (struct Map2Darray *maps, const struct WorldMap2Dmap *mainMap, struct cce_u32vec2 cell)
+{
+   {
+      int64_t keepDistance = (int64_t) g_worldRadius + g_worldHysteresis;
+      int64_t x1 = g_world->gridOrigin.x + ((int64_t) cell.x - keepDistance) * g_world->cellSize.x;
+      int64_t y1 = g_world->gridOrigin.y + ((int64_t) cell.y - keepDistance) * g_world->cellSize.y;
+      int64_t x2 = g_world->gridOrigin.x + ((int64_t) cell.x + keepDistance + 1) * g_world->cellSize.x;
+      int64_t y2 = g_world->gridOrigin.y + ((int64_t) cell.y + keepDistance + 1) * g_world->cellSize.y;
+      struct Map2D **kept = maps->dependies;
+      for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator)
+      {
+         const struct WorldMap2Dmap *map = findWorldMap2Dmap((*iterator)->ID);
+         if (map && isRectangleIntersectingWorldMap2Dmap(map, x1, y1, x2, y2))
+            *(kept++) = *iterator;
+         else
+            cceFreeMap2D(*iterator);
+      }
+      maps->dependiesQuantity = kept - maps->dependies;
+   }
+   
+   uint32_t x1 = (cell.x > g_worldRadius) ? cell.x - g_worldRadius : 0u, x2 = (g_world->gridSize.x - cell.x > g_worldRadius) ? cell.x + g_worldRadius : g_world->gridSize.x - 1u;
+   uint32_t y1 = (cell.y > g_worldRadius) ? cell.y - g_worldRadius : 0u, y2 = (g_world->gridSize.y - cell.y > g_worldRadius) ? cell.y + g_worldRadius : g_world->gridSize.y - 1u;
+   for (uint32_t y = y1; y <= y2; ++y)
+   {
+      for (uint32_t x = x1; x <= x2; ++x)
+      {
+         uint32_t cellMapsQuantity;
+         for (const uint16_t *iterator = getWorldMap2DcellMaps(x, y, &cellMapsQuantity), *end = iterator + cellMapsQuantity; iterator < end; ++iterator)
          {
-            for (struct Map2D **k = maps->dependies, **kend = (maps->dependies + oldExitMapsQuantity);; ++k)
-            {
-               if (k >= kend)
-               {
-                  (*j) = cceLoadMap2D(i->ID);
-                  break;
-               }
-               if ((*k) == NULL) continue;
-               if ((*k)->ID == i->ID)
-               {
-                  (*j) = (*k);
-                  (*k) = NULL;
-                  break;
-               }
-            }
+            uint32_t ID = (g_world->maps + *iterator)->ID;
+            if (ID == maps->main->ID)
+               continue;
+            struct Map2D **jiterator = maps->dependies, **jend = maps->dependies + maps->dependiesQuantity;
+            while (jiterator < jend && (*jiterator)->ID != ID)
+               ++jiterator;
+            if (jiterator < jend)
+               continue;
+            maps->dependies = realloc(maps->dependies, (maps->dependiesQuantity + 1u) * sizeof(struct Map2D*));
+            *(maps->dependies + maps->dependiesQuantity++) = cceLoadMap2D(ID);
          }
-         for (struct Map2D **iterator = maps->dependies, **end = (maps->dependies + oldExitMapsQuantity); iterator < end; ++iterator)
+      }
+   }
+   setWorldMap2Doffsets(maps, mainMap);
+}
+
+/* Point lookups are O(1) through the grid, residency is updated only when the camera moves to another cell */
+static void processWorldMap2D (struct Map2Darray *maps)
+{
+   const struct WorldMap2Dmap *mainMap = findWorldMap2Dmap(maps->main->ID);
+   g_nearestMapsQuantity = 0;
+   if (!mainMap)
+      return;
+   struct cce_worldvec2 camera = getCameraWorldMap2D(mainMap);
+   if (!isPointInWorldMap2Dmap(mainMap, camera))
+   {
+      struct cce_u32vec2 cell = getPointCellWorldMap2D(camera);
+      uint32_t cellMapsQuantity;
+      for (const uint16_t *iterator = getWorldMap2DcellMaps(cell.x, cell.y, &cellMapsQuantity), *end = iterator + cellMapsQuantity; iterator < end; ++iterator)
+      {
+         const struct WorldMap2Dmap *map = g_world->maps + *iterator;
+         if (map != mainMap && isPointInWorldMap2Dmap(map, camera))
          {
-            cceFreeMap2D((*iterator));
+            cceSetLoadedMap2D(map->ID, (struct cce_i32vec2) {clampWorldOffsetMap2D((int64_t) cce__globalOffset.x + map->origin.x - mainMap->origin.x),
+                                                             clampWorldOffsetMap2D((int64_t) cce__globalOffset.y + map->origin.y - mainMap->origin.y)});
+            break;
          }
-         free(maps->dependies);
-         maps->dependies = dependies;
       }
    }
-   else
    {
-      maps->main = cceLoadMap2D(number);
-      if (maps->dependies)
+      struct cce_u32vec2 cell = getPointCellWorldMap2D(camera);
+      if (cell.x != g_worldCell.x || cell.y != g_worldCell.y)
+      {
+         updateResidencyWorldMap2D(maps, mainMap, cell);
+         g_worldCell = cell;
+      }
+   }
+   
+   struct cce_u32vec2 step = cce__getCurrentStep();
+   int64_t stepX = step.x * g_stepMultiplier, stepY = step.y * g_stepMultiplier;
+   struct cce_i32vec2 *offset = maps->dependiesOffsets;
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator, ++offset)
+   {
+      const struct WorldMap2Dmap *map = findWorldMap2Dmap((*iterator)->ID);
+      if (map && isRectangleIntersectingWorldMap2Dmap(map, camera.x - stepX, camera.y - stepY, camera.x + stepX, camera.y + stepY))
       {
-         cce__errorPrint("ENGINE::MAP2DARRAY_LOADER::DEPENDENCY_OF_NOTHING:\nMaps->dependies initialized without maps->main. Cannot free maps->dependies. Possible memory leak", NULL);
+         *(g_nearestMaps + g_nearestMapsQuantity) = *iterator;
+         *(g_nearestMapsOffsets + g_nearestMapsQuantity++) = *offset;
       }
-      maps->dependies = (struct Map2D**) malloc(maps->main->exitMapsQuantity * sizeof(struct Map2D*));
-      struct ExitMap2D *exitmap = maps->main->exitMaps;
-      for (struct Map2D **iterator = maps->dependies, **end = (maps->dependies + maps->main->exitMapsQuantity - 1u); iterator <= end; ++iterator, ++exitmap)
+   }
+}
+
+static struct Map2Darray* loadMap2DwithDependies (struct Map2Darray *maps, uint16_t number)
+{
+   if (!maps)
+   {
+      maps = (struct Map2Darray*) calloc(1u, sizeof(struct Map2Darray));
+   }
+   if (maps->main)
+   {
+      if (maps->main->ID == number)
+         return maps;
+      if ((((map2Dflags & CCE_PROCESS_LOGIC_FLAGS) == CCE_PROCESS_LOGIC_FOR_VISIBLE_MAPS) ||
+           ((map2Dflags & CCE_PROCESS_LOGIC_FLAGS) == CCE_DONT_PROCESS_LOGIC)) &&
+           ((map2Dflags & CCE_FORCE_INITIALIZE_MAP_ONLOAD) == 0))
       {
-         (*iterator) = cceLoadMap2D(exitmap->ID);
+         cce__releaseTemporaryBools(maps->main->temporaryBools);
+         cce__releaseUBO(maps->main->UBO_ID);
       }
    }
+   g_nearestMapsQuantity = 0;
+   if (g_world)
+      loadWorldMaps2D(maps, number);
+   else
+      loadExitMaps2D(maps, number);
    cce__setCurrentArrayOfMaps(maps);
    if (((map2Dflags & (CCE_PROCESS_LOGIC_ONLY_FOR_CURRENT_MAP | CCE_DONT_PROCESS_LOGIC)) == (map2Dflags & CCE_PROCESS_LOGIC_FLAGS)) && 
        ((map2Dflags & CCE_FORCE_INITIALIZE_MAP_ONLOAD) == 0))
@@ -1256,17 +2390,18 @@ static inline uint8_t isMapVisiblePlusExited (struct ExitMap2D *borderInfo)
           ((nglobalOffsetB > borderInfo->b1Border && nglobalOffsetB < borderInfo->b2Border) && (aDistance < 0));
 }
 
-static void cce__processNearestMap2D (struct ExitMap2D *info, uint8_t quantity)
+static void cce__processNearestMap2D (struct Map2Darray *maps)
 {
    uint8_t state;
    g_nearestMapsQuantity = 0;
-   for (struct ExitMap2D *iterator = info, *end = info + quantity; iterator < end; ++iterator)
+   for (struct ExitMap2D *iterator = maps->main->exitMaps, *end = maps->main->exitMaps + maps->main->exitMapsQuantity; iterator < end; ++iterator)
    {
       state = isMapVisiblePlusExited(iterator);
       if (state == 0)
          continue;
       
-      g_nearestMaps[g_nearestMapsQuantity++] = iterator - info;
+      *(g_nearestMaps + g_nearestMapsQuantity) = *(maps->dependies + (iterator - maps->main->exitMaps));
+      *(g_nearestMapsOffsets + g_nearestMapsQuantity++) = (struct cce_i32vec2) {iterator->xOffset, iterator->yOffset};
       
       if (state == 2)
          cceSetLoadedMap2D(iterator->ID, (struct cce_i32vec2) {cce__globalOffset.x + iterator->xOffset, cce__globalOffset.y + iterator->yOffset});
@@ -1275,21 +2410,20 @@ static void cce__processNearestMap2D (struct ExitMap2D *info, uint8_t quantity)
 
 static void cce__loadMapsAndSetState (struct Map2Darray *maps)
 {
-   struct cce_i32vec2 offset = (struct cce_i32vec2) {g_newOffset.x - cce__globalOffset.x, g_newOffset.y - cce__globalOffset.y};
+   /* Dynamic elements keep their coordinates, only dynamic map's origin follows the new current map. */
+   /* Elements are rebased once origin gets far, which doesn't happen every transition even in 64-bit worlds */
+   int64_t originX = (int64_t) g_dynamicMap->origin.x - ((int64_t) g_newOffset.x - cce__globalOffset.x);
+   int64_t originY = (int64_t) g_dynamicMap->origin.y - ((int64_t) g_newOffset.y - cce__globalOffset.y);
+   if (originX > CCE_DYNAMIC_MAP2D_REBASE_DISTANCE || originX < -CCE_DYNAMIC_MAP2D_REBASE_DISTANCE ||
+       originY > CCE_DYNAMIC_MAP2D_REBASE_DISTANCE || originY < -CCE_DYNAMIC_MAP2D_REBASE_DISTANCE)
+   {
+      cce__rebaseDynamicMap2D();
+      originX = -((int64_t) g_newOffset.x - cce__globalOffset.x);
+      originY = -((int64_t) g_newOffset.y - cce__globalOffset.y);
+   }
+   g_dynamicMap->origin = (struct cce_i32vec2) {(int32_t) originX, (int32_t) originY};
    cce__globalOffset = (struct cce_i32vec2) {g_newOffset.x, g_newOffset.y};
    glUniform2iv(*(uniformLocations + CCE_GLOBALOFFSET_OFFSET), 1, (GLint*) &cce__globalOffset);
-   uint32_t i = 0;
-   while (i < g_dynamicMap->elementsQuantity)
-   {
-      uint8_t flags = cce__getDynamicElementFlags(i);
-      (g_dynamicMap->elements + i)->x -= offset.x;
-      (g_dynamicMap->elements + i)->y -= offset.y;
-      if ((flags & 0x10) > 0)
-         (g_dynamicMap->elements + i)->flags |= 0x4;
-            
-      ++i;
-   }
-   cce__setToBeProcessedDynamicMap2D();
    maps = loadMap2DwithDependies(maps, g_mapToLoad);
    cce__loadedMap2Dnumber = g_mapToLoad;
 }
@@ -1297,21 +2431,133 @@ static void cce__loadMapsAndSetState (struct Map2Darray *maps)
 void cce__terminateEngine2D (void)
 {
    cce__terminateDynamicMap2D();
+   cce__freeWorldMap2D(g_world);
+   free(g_nearestMaps);
+   free(g_nearestMapsOffsets);
+   cce__terminateTextureLoader();
+   cce__terminateTextureCache();
+   stbi_image_free(g_dummyTexture.data);
+   g_dummyTexture.data = NULL;
+   g_dummyTexture.rectangle.flags = 0u;
+   glDeleteBuffers(2, g_PBOs);
+   glDeleteFramebuffers(1, &g_copyFramebuffer);
    free(g_textures);
-   glDeleteTextures(1, &glTexturesArray);
-   for (struct UsedUBO *iterator = g_UBOs, *end = g_UBOs + g_UBOsQuantity; iterator < end; ++iterator)
+   free(g_textureSlots);
+   cce__terminateTextureAtlas();
+   glDeleteTextures(g_texturePagesQuantity, g_texturePages);
+   glDeleteTextures(1, &g_textureRectangles);
+   glDeleteBuffers(1, &g_textureRectanglesBuffer);
+   glDeleteBuffers(1, &g_cleanUBO);
+   glDeleteTextures(1, &g_cleanGroupValues);
+   glDeleteBuffers(1, &g_cleanGroupValuesBuffer);
+   for (struct UsedUBO *iterator = g_UBOs, *end = g_UBOs + g_UBOsQuantityAllocated; iterator < end; ++iterator)
    {
-      glDeleteBuffers(1, &(iterator->UBO));
+      deleteUBO(iterator);
    }
    free(g_UBOs);
-   glDeleteBuffers(1, &g_EBO);
+   cce__terminateStreamBuffers();
+   cce__terminateInstanceArena();
    free(bufferUniformsOffsets);
    free(uniformLocations);
    free(texturesPath);
    glDeleteProgram(shaderProgram);
+   cce__stopRenderThread();
    cce__terminateEngine();
 }
 
+/* 0 makes logic run once per frame (default) */
+CCE_PUBLIC_OPTIONS void cceSetLogicTickRate (uint16_t ticksPerSecond)
+{
+   g_logicTickLength = ticksPerSecond ? 1.0 / ticksPerSecond : 0.0;
+   g_logicTimeAccumulated = 0.0;
+   g_tickInterpolation = 1.0f;
+   g_globalOffsetTickShift = (struct cce_i32vec2) {0, 0};
+}
+
+/* Moved flags tell which UBOs were changed by the last tick */
+static void clearMovedUBOsMap2D (void)
+{
+   for (struct UsedUBO *iterator = g_UBOs, *end = g_UBOs + g_UBOsQuantity; iterator < end; ++iterator)
+   {
+      iterator->flags &= ~0x10;
+   }
+}
+
+/* Logic and collisions run with fixed step, time left over is carried to the next frame
+ * and tells how far drawing is between the last two ticks */
+static void processLogicTicksMap2D (struct Map2Darray *maps)
+{
+   if (g_logicTickLength <= 0.0)
+   {
+      clearMovedUBOsMap2D();
+      processLogicMap2Dcommon(maps);
+      return;
+   }
+   const double frameTime = *cceCurrentTime, frameDeltaTime = *cceDeltaTime;
+   g_logicTimeAccumulated = MIN(g_logicTimeAccumulated + frameDeltaTime, g_logicTickLength * CCE_MAX_LOGIC_TICKS_PER_FRAME);
+   while (g_logicTimeAccumulated >= g_logicTickLength)
+   {
+      g_logicTimeAccumulated -= g_logicTickLength;
+      cce__setLogicTime(frameTime - g_logicTimeAccumulated, g_logicTickLength);
+      clearMovedUBOsMap2D();
+      struct cce_i32vec2 globalOffset = cce__globalOffset;
+      processLogicMap2Dcommon(maps);
+      g_globalOffsetTickShift = (struct cce_i32vec2) {cce__globalOffset.x - globalOffset.x, cce__globalOffset.y - globalOffset.y};
+   }
+   cce__setLogicTime(frameTime, frameDeltaTime);
+   g_tickInterpolation = (float) (g_logicTimeAccumulated / g_logicTickLength);
+}
+
+static int32_t interpolateMap2D (int32_t previous, int32_t current, float interpolation)
+{
+   return previous + (int32_t) lroundf((float) ((int64_t) current - previous) * interpolation);
+}
+
+/* Move group values and global offset are drawn between the last two ticks. Only groups moved by the last tick are streamed
+ * with interpolated values, UBOs which stopped moving get their real values back */
+static void interpolateLogicTicksMap2D (void)
+{
+   const uint8_t isInterpolated = g_logicTickLength > 0.0;
+   const float interpolation = g_tickInterpolation;
+   g_drawnGlobalOffset = cce__globalOffset;
+   if (isInterpolated)
+   {
+      g_drawnGlobalOffset.x -= interpolateMap2D(g_globalOffsetTickShift.x, 0, interpolation);
+      g_drawnGlobalOffset.y -= interpolateMap2D(g_globalOffsetTickShift.y, 0, interpolation);
+   }
+   glUniform2iv(*(uniformLocations + CCE_GLOBALOFFSET_OFFSET), 1, (GLint*) &g_drawnGlobalOffset);
+   GL_CHECK_ERRORS;
+   for (struct UsedUBO *iterator = g_UBOs, *end = g_UBOs + g_UBOsQuantity; iterator < end; ++iterator)
+   {
+      if (isInterpolated && (iterator->flags & 0x11) == 0x11)
+      {
+         const uint16_t movedBegin = iterator->movedGroupsBegin, movedEnd = MIN(iterator->movedGroupsEnd, iterator->moveGroupValuesQuantity);
+         if (movedBegin >= movedEnd)
+            continue;
+         const GLintptr rangeBegin = movedBegin * 2 * sizeof(struct cce_i32vec2), rangeEnd = movedEnd * 2 * sizeof(struct cce_i32vec2);
+         for (uint16_t i = movedBegin; i < movedEnd; ++i)
+         {
+            struct cce_i32vec2 *value = iterator->groupValues + i * 2u;
+            const struct cce_i32vec2 *previous = iterator->previousMoveGroupValues + i;
+            value->x = interpolateMap2D(previous->x, value->x, interpolation);
+            value->y = interpolateMap2D(previous->y, value->y, interpolation);
+         }
+         cce__invalidateStreamBufferRange(&(iterator->groupValuesBuffer), rangeBegin, rangeEnd);
+         cce__flushStreamBuffer(&(iterator->groupValuesBuffer), GL_TEXTURE_BUFFER, iterator->groupValues);
+         /* Segment differs from CPU copy by moved values now, every segment gets the real ones with its next flush */
+         for (uint16_t i = movedBegin; i < movedEnd; ++i)
+            *(iterator->groupValues + i * 2u) = *(iterator->moveGroupValues + i);
+         cce__invalidateStreamBufferRange(&(iterator->groupValuesBuffer), rangeBegin, rangeEnd);
+         iterator->flags |= 0x20;
+      }
+      else if (iterator->flags & 0x20)
+      {
+         cce__flushStreamBuffer(&(iterator->groupValuesBuffer), GL_TEXTURE_BUFFER, iterator->groupValues);
+         iterator->flags &= ~0x20;
+      }
+   }
+}
+
 CCE_PUBLIC_OPTIONS int cceEngine2D (void)
 {
    if (map2Dflags & CCE_INIT)
@@ -1323,6 +2569,7 @@ CCE_PUBLIC_OPTIONS int cceEngine2D (void)
    struct Map2Darray *maps = loadMap2DwithDependies(NULL, 0u);
    cce__loadedMap2Dnumber = 0;
    cce__setCurrentArrayOfMaps(maps);
+   map2Dflags |= CCE_PROCESS_NEAREST_MAPS;
    while (!(*cce__flags & CCE_ENGINE_STOP))
    {
       cce__processDynamicMap2DElements();
@@ -1332,42 +2579,63 @@ CCE_PUBLIC_OPTIONS int cceEngine2D (void)
          cce__updateTexturesArray();
          map2Dflags &= ~CCE_PROCESS_TEXTURES;
       }
+      uploadDecodedTextures();
 
       if (map2Dflags & CCE_PROCESS_UBO_ARRAY)
       {
          updateUBOarray();
          map2Dflags &= ~CCE_PROCESS_UBO_ARRAY;
       }
+      interpolateLogicTicksMap2D();
       glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-      glClear(GL_COLOR_BUFFER_BIT);
+      glDepthMask(GL_TRUE);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
       GL_CHECK_ERRORS;
-      glBindTexture(GL_TEXTURE_2D_ARRAY, glTexturesArray);
-      GL_CHECK_ERRORS;
-      if (maps->main->exitMapsQuantity > 0)
-      {
-         if (map2Dflags & CCE_PROCESS_NEAREST_MAPS)
-         {
-            cce__processNearestMap2D(maps->main->exitMaps, maps->main->exitMapsQuantity);
-            map2Dflags &= ~CCE_PROCESS_NEAREST_MAPS;
-         }
-         drawMap2Dcommon(maps);
-      }
-      else
+      bindTexturePages();
+      if (map2Dflags & CCE_PROCESS_NEAREST_MAPS)
       {
-         drawMap2D(maps->main);
+         if (g_world)
+            processWorldMap2D(maps);
+         else if (maps->dependiesQuantity > 0)
+            cce__processNearestMap2D(maps);
+         map2Dflags &= ~CCE_PROCESS_NEAREST_MAPS;
       }
+      cce__bindInstanceArena();
+      forgetBoundUniformsMap2D();
+      /* Opaque elements first without blending, front to back, so covered fragments fail the depth test;
+       * translucent ones are blended over them in the painter's order without writing depth */
+      glEnable(GL_DEPTH_TEST);
+      glDisable(GL_BLEND);
+      glUniform1i(*(uniformLocations + CCE_PASS_OFFSET), CCE_DRAW_OPAQUE);
+      drawFrameMapsMap2D(maps, CCE_DRAW_OPAQUE);
+      glDepthMask(GL_FALSE);
+      glEnable(GL_BLEND);
+      glUniform1i(*(uniformLocations + CCE_PASS_OFFSET), CCE_DRAW_TRANSLUCENT);
+      drawFrameMapsMap2D(maps, CCE_DRAW_TRANSLUCENT);
+      glDisable(GL_DEPTH_TEST);
+      glUniform1i(*(uniformLocations + CCE_PASS_OFFSET), CCE_DRAW_ALL_ELEMENTS);
+      glUniform1i(*(uniformLocations + CCE_ORDEROFFSET_OFFSET), 0);
+      GL_CHECK_ERRORS;
       
       glBindVertexArray(g_dynamicMap->VAO);
       GL_CHECK_ERRORS;
-      glBindBufferRange(GL_UNIFORM_BUFFER, 1u, (g_UBOs + g_dynamicMap->UBO_ID)->UBO, 0u, g_uniformBufferSize);
+      bindUniformsMap2D((g_UBOs + g_dynamicMap->UBO_ID)->buffer.buffer, (g_UBOs + g_dynamicMap->UBO_ID)->buffer.offset,
+                        (g_UBOs + g_dynamicMap->UBO_ID)->groupValuesTexture, (g_UBOs + g_dynamicMap->UBO_ID)->groupValuesBuffer.offset,
+                        (g_UBOs + g_dynamicMap->UBO_ID)->groupValuesCapacity);
+      setMapOffsetMap2D((struct cce_i32vec2) {0, 0});
+      glUniform2i(*(uniformLocations + CCE_GLOBALOFFSET_OFFSET), g_drawnGlobalOffset.x + g_dynamicMap->origin.x, g_drawnGlobalOffset.y + g_dynamicMap->origin.y);
       GL_CHECK_ERRORS;
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_EBO);
+      cce__drawInstancesMap2D(g_dynamicMap->elementsQuantity);
       GL_CHECK_ERRORS;
-      glDrawElements(GL_TRIANGLES, g_dynamicMap->elementsQuantity * 6, GL_UNSIGNED_INT, (void*) 0);
+      glUniform2iv(*(uniformLocations + CCE_GLOBALOFFSET_OFFSET), 1, (GLint*) &g_drawnGlobalOffset);
       GL_CHECK_ERRORS;
+      cce__endFrameStreamBuffers();
       cce__swapBuffers();
       cce__engineUpdate();
-      processLogicMap2Dcommon(maps);
+      processLogicTicksMap2D(maps);
+      if (g_frame >= g_textureResidencyRetryFrame && getTexturePagesSize() > g_texturesMemoryBudget)
+         updateTextureResidency(maps);
+      ++g_frame;
 #ifndef NDEBUG
       {
          static uint16_t frames = 0;
@@ -1389,12 +2657,13 @@ CCE_PUBLIC_OPTIONS int cceEngine2D (void)
          map2Dflags |= CCE_PROCESS_NEAREST_MAPS;
       }
    }
-   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->main->exitMapsQuantity; iterator < end; ++iterator)
+   for (struct Map2D **iterator = maps->dependies, **end = maps->dependies + maps->dependiesQuantity; iterator < end; ++iterator)
    {
       cceFreeMap2D(*iterator);
    }
    cceFreeMap2D(maps->main);
    free(maps->dependies);
+   free(maps->dependiesOffsets);
    free(maps);
    cce__terminateEngine2D();
    return 0;
@@ -28,8 +28,11 @@
 #include "../../include/coffeechain/endianess.h"
 #include "../../include/coffeechain/map2D/map2D.h"
 #include "../../include/coffeechain/map2D/base_actions.h"
+#include "../../include/coffeechain/resource_pack.h"
+#include "../../include/coffeechain/utils.h"
 
 #include "../engine_common_internal.h"
+#include "../external/stb_image.h"
 #include "map2D_internal.h"
 
 static char *mapPath = NULL;
@@ -38,11 +41,42 @@ const cce_flag *map2Dflags;
 
 static void (*cce_fileParseFunc)(FILE*, uint16_t);
 static void (*cce_callbackOnFreeing)(uint16_t);
-static GLuint *g_EBO;
 
-void cce__initMap2DLoaders (GLuint *EBO, const cce_flag *flagsPointer)
+#define CCE_MAP2D_ELEMENT_FILE_SIZE 33u /* x, y, width, height, struct Texture and 9 uint8_t groups */
+
+/* Header of map file, see docs/Map2D.txt. Maps written before it have no header and end engine's part with 10 zero bytes */
+#define CCE_MAP2D_FILE_VERSION 1u
+#define CCE_MAP2D_FILE_GAME_DATA 0x1u /* Data written by writeFunc of cceWriteMap2Ddev follows engine's sections */
+#define CCE_MAP2D_FILE_SUPPORTED_FEATURES (CCE_MAP2D_FILE_GAME_DATA)
+
+enum Map2DFileSection
+{
+   CCE_MAP2D_SECTION_ELEMENTS = 0,
+   CCE_MAP2D_SECTION_MOVE_GROUPS,
+   CCE_MAP2D_SECTION_EXTENSION_GROUPS,
+   CCE_MAP2D_SECTION_COLLIDERS,
+   CCE_MAP2D_SECTION_COLLISION_GROUPS,
+   CCE_MAP2D_SECTION_COLLISION,
+   CCE_MAP2D_SECTION_TIMERS,
+   CCE_MAP2D_SECTION_LOGIC,
+   CCE_MAP2D_SECTION_STATIC_ACTIONS,
+   CCE_MAP2D_SECTION_EXIT_MAPS,
+   CCE_MAP2D_SECTION_GAME_DATA,
+   CCE_MAP2D_SECTIONS_QUANTITY
+};
+
+struct Map2DFileHeader
+{
+   char     magic[4];             /* "C2MH" */
+   uint16_t version;
+   uint16_t headerSize;           /* Sections start here, so newer versions can extend header */
+   uint32_t featureFlags;
+   uint32_t sectionSizes[CCE_MAP2D_SECTIONS_QUANTITY];
+   uint64_t checksum;             /* cceHash64 (seed 0) of everything after header */
+}; // 64 bytes
+
+void cce__initMap2DLoaders (const cce_flag *flagsPointer)
 {
-   g_EBO = EBO;
    map2Dflags = flagsPointer;
 }
 
@@ -69,10 +103,9 @@ CCE_PUBLIC_OPTIONS void cceFreeMap2D (struct Map2D *map)
 {
    if (!map)
       return;
-   if (map->VAO)
-      glDeleteVertexArrays(1u, &(map->VAO));
-   if (map->VBO)
-      glDeleteBuffers(1u, &(map->VBO));
+   if (map->tiles)
+      cce__freeInstanceArena(map->instancesFirst, map->elementsQuantity);
+   free(map->tiles);
    if (map->collidersQuantity)
       free(map->colliders);
    if (map->moveGroupsQuantity)
@@ -199,55 +232,94 @@ CCE_PUBLIC_OPTIONS void cceFreeMap2Ddev (struct Map2Ddev *map)
    free(map);
 }
 
-static GLuint makeVAOmap2D (struct Map2DElement *elements, uint32_t elementsQuantity, uint8_t *moveGroups, uint8_t *extensionGroups, uint8_t *globalOffsets, GLuint *VBO)
+static inline int32_t getTileCellCoordinate (int32_t coordinate)
 {
-   GLuint VAO;
-   glGenVertexArrays(1, &VAO);
-   GL_CHECK_ERRORS;
-   glGenBuffers(1, VBO);
-   GL_CHECK_ERRORS;
-   glBindVertexArray(VAO);
-   GL_CHECK_ERRORS;
-   glBindBuffer(GL_ARRAY_BUFFER, *VBO);
-   GL_CHECK_ERRORS;
-   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *g_EBO);
-   
-   glBufferData(GL_ARRAY_BUFFER, (sizeof(struct Map2DElementVertices) * 4 * elementsQuantity), NULL, GL_STATIC_DRAW);
-   GL_CHECK_ERRORS;
-   struct Map2DElementVertices *vertices = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-   GL_CHECK_ERRORS;
+   return (coordinate - (coordinate < 0) * (CCE_MAP2D_TILE_SIZE - 1)) / CCE_MAP2D_TILE_SIZE;
+}
+
+/* Splits instances into tiles, which are culled in drawMap2D. Map's elements are in painter's order, so instead of sorting them
+ * a tile is ended when it has enough elements and the next one is in other cell. Maps made cell by cell give tiles of one cell each */
+static void buildTilesMap2D (struct Map2D *map, const struct Map2DElementInstance *instances, uint32_t elementsQuantity)
+{
+   uint32_t tilesQuantityAllocated = 0u;
+   map->tiles = NULL;
+   map->tilesQuantity = 0u;
+   struct Map2DTile *tile = NULL;
+   struct cce_i32vec2 tileCell = {0, 0};
+   for (const struct Map2DElementInstance *iterator = instances, *end = instances + elementsQuantity; iterator < end; ++iterator)
+   {
+      struct cce_i32vec2 cell = {getTileCellCoordinate(iterator->position.x), getTileCellCoordinate(iterator->position.y)};
+      if (tile == NULL || tile->quantity >= CCE_MAP2D_TILE_MAX_ELEMENTS ||
+          (tile->quantity >= CCE_MAP2D_TILE_MIN_ELEMENTS && (cell.x != tileCell.x || cell.y != tileCell.y)))
+      {
+         if (map->tilesQuantity >= tilesQuantityAllocated)
+         {
+            tilesQuantityAllocated += CCE_ALLOCATION_STEP;
+            map->tiles = realloc(map->tiles, tilesQuantityAllocated * sizeof(struct Map2DTile));
+         }
+         tile = map->tiles + map->tilesQuantity;
+         ++(map->tilesQuantity);
+         tile->min = iterator->position;
+         tile->max = iterator->position;
+         tile->first = (uint32_t) (iterator - instances);
+         tile->quantity = 0u;
+         tile->flags = 0u;
+         tileCell = cell;
+      }
+      tile->min.x = MIN(tile->min.x, iterator->position.x);
+      tile->min.y = MIN(tile->min.y, iterator->position.y);
+      tile->max.x = MAX(tile->max.x, iterator->position.x + iterator->size.x);
+      tile->max.y = MAX(tile->max.y, iterator->position.y + iterator->size.y);
+      ++(tile->quantity);
+      
+      if (iterator->moveIDs[0] | iterator->moveIDs[1] | iterator->moveIDs[2] | iterator->moveIDs[3])
+         tile->flags |= CCE_MAP2D_TILE_MOVED;
+      if (iterator->extendIDs[0] | iterator->extendIDs[1] | iterator->extendIDs[2] | iterator->extendIDs[3])
+         tile->flags |= CCE_MAP2D_TILE_EXTENDED;
+      tile->flags |= (iterator->transformGroups.flags & CCE_INSTANCE_GLOBAL_OFFSET) ? CCE_MAP2D_TILE_GLOBAL_OFFSET : CCE_MAP2D_TILE_SCREEN_FIXED;
+      // Opacity of an image is known only once it is decoded, so textured elements may be drawn by either pass
+      tile->flags |= iterator->textureID ? (CCE_MAP2D_TILE_OPAQUE | CCE_MAP2D_TILE_TRANSLUCENT) : CCE_MAP2D_TILE_OPAQUE;
+      if (iterator->transformGroups.rotateGroupID ||
+          (tile->flags & (CCE_MAP2D_TILE_GLOBAL_OFFSET | CCE_MAP2D_TILE_SCREEN_FIXED)) == (CCE_MAP2D_TILE_GLOBAL_OFFSET | CCE_MAP2D_TILE_SCREEN_FIXED))
+         tile->flags |= CCE_MAP2D_TILE_ALWAYS_VISIBLE;
+   }
+   if (map->tilesQuantity)
+      map->tiles = realloc(map->tiles, map->tilesQuantity * sizeof(struct Map2DTile));
+}
+
+static void uploadInstancesMap2D (struct Map2D *map, const struct Map2DElementInstance *instances, uint32_t elementsQuantity)
+{
+   buildTilesMap2D(map, instances, elementsQuantity);
+   map->instancesFirst = cce__allocateInstanceArena(instances, elementsQuantity);
+}
+
+static void makeInstancesMap2D (struct Map2D *map, struct Map2DElement *elements, uint32_t elementsQuantity, uint16_t *moveGroups, uint16_t *extensionGroups, uint8_t *globalOffsets)
+{
+   struct Map2DElementInstance *instances = malloc(sizeof(struct Map2DElementInstance) * elementsQuantity);
+   struct Map2DElementInstance *instance = instances;
    for (struct Map2DElement *iterator = elements, *end = elements + elementsQuantity; iterator < end;
-        ++iterator, moveGroups += 4, extensionGroups += 4, ++globalOffsets, vertices += 4)
+        ++iterator, moveGroups += 4, extensionGroups += 4, ++globalOffsets, ++instance)
    {
-      cce__map2DElementToMap2DElementVertices(vertices, iterator, moveGroups, extensionGroups, *globalOffsets);
+      cce__map2DElementToMap2DElementInstance(instance, iterator, moveGroups, extensionGroups, *globalOffsets);
    }
-   glUnmapBuffer(GL_ARRAY_BUFFER);
-   GL_CHECK_ERRORS;
-   
-   cce__setAttribPointerVAO();
-   
-   glBindBuffer(GL_ARRAY_BUFFER, 0);
-   GL_CHECK_ERRORS;
-   glBindVertexArray(0);
-   GL_CHECK_ERRORS;
-   cce__extendElementBufferIfNecessary(elementsQuantity);
-   return VAO;
+   uploadInstancesMap2D(map, instances, elementsQuantity);
+   free(instances);
 }
 
 //#define ADD_TO_2BIT_ARRAY(array, i, number) ((array)[(i) >> (SHIFT_OF_FAST_SIZE - 1)] += ((number) << ((i) & ((1 << (SHIFT_OF_FAST_SIZE - 1)) - 1))))
 //#define GET_VALUE_FROM_2BIT_ARRAY(array, i)(((array)[(i) >> (SHIFT_OF_FAST_SIZE - 1)] >> ((i) & ((1 << (SHIFT_OF_FAST_SIZE - 1)) - 1))) & 3)
-static void convertCCEgroupsToGLgroups (uint16_t groupsQuantity, struct ElementGroup *groups, uint8_t *glGroups, uint8_t glGroupsStep, uint32_t elementsWithoutColliderQuantity, uint32_t elementsQuantity)
+static void convertCCEgroupsToGLgroups (uint16_t groupsQuantity, struct ElementGroup *groups, uint16_t *glGroups, uint8_t glGroupsStep, uint32_t elementsWithoutColliderQuantity, uint32_t elementsQuantity)
 {
-   uint8_t i = 1u;
+   uint16_t i = 1u;
    uint32_t offset = 0u;
-   struct ElementGroup *end = (groups + (MIN(256u, groupsQuantity)));
+   struct ElementGroup *end = (groups + groupsQuantity);
    while (groups < end)
    {
       if (groups->elementsQuantity) for (uint32_t *j = groups->elements, *jend = (groups->elements + groups->elementsQuantity); j < jend; ++j)
       {
          if ((*j) < elementsQuantity)
          {
-            for (uint8_t *iterator = glGroups + (*j) * glGroupsStep * 4, *iend = glGroups + (*j) * glGroupsStep * 4 + 4; iterator < iend; ++iterator)
+            for (uint16_t *iterator = glGroups + (*j) * glGroupsStep * 4, *iend = glGroups + (*j) * glGroupsStep * 4 + 4; iterator < iend; ++iterator)
             {
                if (*iterator == 0)
                {
@@ -277,6 +349,7 @@ static void convertCCEgroupsToGLgroups (uint16_t groupsQuantity, struct ElementG
       else
       {
          free(groups->elements);
+         groups->elements = NULL;
       }
       offset = 0u;
       ++i, ++groups;
@@ -312,6 +385,7 @@ static void offsetCCEgroupsFromElementsToColliders (uint16_t groupsQuantity, str
       else
       {
          free(groups->elements);
+         groups->elements = NULL;
       }
       offset = 0u;
       ++groups;
@@ -323,16 +397,17 @@ static void offsetCCEgroupsFromElementsToColliders (uint16_t groupsQuantity, str
                                                                                        (elementsQuantity) - (elementsWithoutColliderQuantity)  : \
                                                                                         0u)
 
-static struct Map2DCollider* elementsToColliders (uint32_t  elementsQuantity, uint32_t elementsWithoutColliderQuantity, struct Map2DElement *elements,
-                                                  uint16_t **texturesMapReliesOn, uint16_t *texturesMapReliesOnQuantity,
-                                                  uint16_t  moveGroupsQuantity, struct ElementGroup *moveGroups,
-                                                  uint16_t  extensionGroupsQuantity, struct ElementGroup *extensionGroups,
-                                                  GLuint *VAO, GLuint *VBO)
+/* Reallocates elements to hold GL groups after them: move and extension groups (4 per element each), then global offset flags (1 per element).
+ * Every group gets its GL group, groups are converted from elements to colliders meanwhile */
+static uint16_t* elementsToGLgroups (uint32_t elementsQuantity, uint32_t elementsWithoutColliderQuantity, struct Map2DElement **elementsPointer,
+                                     uint16_t moveGroupsQuantity, struct ElementGroup *moveGroups,
+                                     uint16_t extensionGroupsQuantity, struct ElementGroup *extensionGroups)
 {
-   *texturesMapReliesOn = cce__loadTexturesMap2D(elements, elementsQuantity, texturesMapReliesOnQuantity);
-   elements = (struct Map2DElement*) realloc(elements, (sizeof(struct Map2DElement) + (2 * 4 + 1) * sizeof(uint8_t)) * elementsQuantity);
-   uint8_t *glGroups = (uint8_t*) ((void*) (elements + elementsQuantity));
-   memset(glGroups, 0, elementsQuantity * ((2 * 4 + 1) * sizeof(uint8_t)));
+   struct Map2DElement *elements = (struct Map2DElement*) realloc(*elementsPointer, (sizeof(struct Map2DElement) + 2 * 4 * sizeof(uint16_t) + sizeof(uint8_t)) * elementsQuantity);
+   *elementsPointer = elements;
+   uint16_t *glGroups = (uint16_t*) ((void*) (elements + elementsQuantity));
+   uint8_t *globalOffsets = (uint8_t*) (glGroups + elementsQuantity * 2 * 4);
+   memset(glGroups, 0, elementsQuantity * (2 * 4 * sizeof(uint16_t) + sizeof(uint8_t)));
    uint32_t currentElement = 0;
    if (moveGroups)
    {
@@ -346,25 +421,22 @@ static struct Map2DCollider* elementsToColliders (uint32_t  elementsQuantity, ui
                break;
             continue;
          }
-         (*(glGroups + currentElement)) = 1;
+         (*(globalOffsets + currentElement)) = 1;
       }
-      convertCCEgroupsToGLgroups(moveGroupsQuantity - 1,  moveGroups + 1,  glGroups + (elementsQuantity * (1 * sizeof(uint8_t))), 1, elementsWithoutColliderQuantity, elementsQuantity);
+      convertCCEgroupsToGLgroups(moveGroupsQuantity - 1,  moveGroups + 1,  glGroups, 1, elementsWithoutColliderQuantity, elementsQuantity);
    }
    while (currentElement < elementsQuantity)
    {
-      (*(glGroups + currentElement)) = 1;
+      (*(globalOffsets + currentElement)) = 1;
       ++currentElement;
    }
    if (extensionGroups)
-      convertCCEgroupsToGLgroups(extensionGroupsQuantity, extensionGroups, glGroups + (elementsQuantity * (5 * sizeof(uint8_t))), 1, elementsWithoutColliderQuantity, elementsQuantity);
-      
-   *VAO = makeVAOmap2D(elements, elementsQuantity, glGroups + (elementsQuantity * sizeof(uint8_t)), glGroups + (elementsQuantity * 5 * sizeof(uint8_t)), glGroups, VBO);
-   
-   if (moveGroups && moveGroupsQuantity > 256u)
-      offsetCCEgroupsFromElementsToColliders(moveGroupsQuantity - 256u, moveGroups + 256u, elementsWithoutColliderQuantity);
-   if (extensionGroups && extensionGroupsQuantity > 255u)
-      offsetCCEgroupsFromElementsToColliders(extensionGroupsQuantity - 255u, extensionGroups + 255u, elementsWithoutColliderQuantity);
-   
+      convertCCEgroupsToGLgroups(extensionGroupsQuantity, extensionGroups, glGroups + elementsQuantity * 4, 1, elementsWithoutColliderQuantity, elementsQuantity);
+   return glGroups;
+}
+
+static struct Map2DCollider* elementsToCollidersInPlace (struct Map2DElement *elements, uint32_t elementsQuantity, uint32_t elementsWithoutColliderQuantity)
+{
    // Dangerous memory optimization!
    struct Map2DCollider *colliders = (struct Map2DCollider*) ((void*) elements);
    for (struct Map2DCollider *iterator = colliders, *end = (colliders + ELEMENTSCOLLIDERSQUANTITY(elementsQuantity, elementsWithoutColliderQuantity) - 1); iterator <= end; ++iterator, ++elements)
@@ -377,20 +449,218 @@ static struct Map2DCollider* elementsToColliders (uint32_t  elementsQuantity, ui
    return colliders;
 }
 
+static struct Map2DCollider* elementsToColliders (uint32_t  elementsQuantity, uint32_t elementsWithoutColliderQuantity, struct Map2DElement *elements,
+                                                  uint16_t **texturesMapReliesOn, uint16_t *texturesMapReliesOnQuantity,
+                                                  uint16_t  moveGroupsQuantity, struct ElementGroup *moveGroups,
+                                                  uint16_t  extensionGroupsQuantity, struct ElementGroup *extensionGroups,
+                                                  struct Map2D *map)
+{
+   *texturesMapReliesOn = cce__loadTexturesMap2D(elements, elementsQuantity, texturesMapReliesOnQuantity);
+   uint16_t *glGroups = elementsToGLgroups(elementsQuantity, elementsWithoutColliderQuantity, &elements, moveGroupsQuantity, moveGroups, extensionGroupsQuantity, extensionGroups);
+      
+   makeInstancesMap2D(map, elements, elementsQuantity, glGroups, glGroups + elementsQuantity * 4, (uint8_t*) (glGroups + elementsQuantity * 2 * 4));
+   
+   return elementsToCollidersInPlace(elements, elementsQuantity, elementsWithoutColliderQuantity);
+}
+
+/* Baked map (map_<n>.c2b) is produced by coffeechain-mapbake, see docs/Map2D.txt */
+#define CCE_BAKED_MAP2D_VERSION 5u
+
+struct BakedMap2DHeader
+{
+   char     magic[4];             /* "C2MB" */
+   uint16_t version;
+   uint16_t instanceSize;         /* sizeof(struct Map2DElementInstance) of the baker */
+   uint32_t textureMaxWidth;
+   uint32_t textureMaxHeight;
+   uint64_t sourceKey;            /* Checksum of map_<n>.c2m the blob was baked from, size of map file for maps without header */
+   uint32_t elementsQuantity;
+   uint32_t elementsWithoutColliderQuantity;
+   uint32_t collidersQuantity;
+   uint16_t texturesQuantity;
+   uint16_t reserved;
+}; // 40 bytes
+
+static long cce__getFileSize (FILE *file)
+{
+   long position = ftell(file);
+   fseek(file, 0, SEEK_END);
+   long size = ftell(file);
+   fseek(file, position, SEEK_SET);
+   return size;
+}
+
+/* Checks header and checksum of the whole map file in one pass, before anything is allocated for the map. mapData is contents of packed map (NULL otherwise)
+ * Returns 0 for maps without header (file position is unchanged), 1 for verified maps (file position is at the first section) */
+static int verifyMap2DFile (FILE *mapFile, const uint8_t *mapData, uint64_t mapFileSize, uint16_t number, struct Map2DFileHeader *header)
+{
+   if (fread(header, sizeof(struct Map2DFileHeader), 1u, mapFile) != 1u || memcmp(header->magic, "C2MH", 4u) != 0)
+   {
+      fseek(mapFile, 0, SEEK_SET);
+      return 0;
+   }
+   header->version = cceLittleEndianToHostEndianInt16(header->version);
+   header->headerSize = cceLittleEndianToHostEndianInt16(header->headerSize);
+   header->featureFlags = cceLittleEndianToHostEndianInt32(header->featureFlags);
+   cceLittleEndianToHostEndianArrayInt32(header->sectionSizes, CCE_MAP2D_SECTIONS_QUANTITY);
+   header->checksum = cceLittleEndianToHostEndianInt64(header->checksum);
+   
+   uint64_t bodySize = 0u;
+   for (uint32_t *iterator = header->sectionSizes, *end = header->sectionSizes + CCE_MAP2D_SECTIONS_QUANTITY; iterator < end; ++iterator)
+   {
+      bodySize += *iterator;
+   }
+   if (header->version == 0u || header->version > CCE_MAP2D_FILE_VERSION || (header->featureFlags & ~CCE_MAP2D_FILE_SUPPORTED_FEATURES))
+   {
+      cce__criticalErrorPrint("ENGINE::MAP2D_LOADER::UNSUPPORTED_VERSION:\nmap %u was written by newer engine version (file version %u, features 0x%x)",
+                              number, header->version, header->featureFlags);
+   }
+   if (header->headerSize < sizeof(struct Map2DFileHeader) || header->headerSize + bodySize != mapFileSize)
+   {
+      cce__criticalErrorPrint("ENGINE::MAP2D_LOADER::CORRUPTED_FILE:\nfile of map %u has size %lu, but header describes %lu bytes",
+                              number, (unsigned long) mapFileSize, (unsigned long) (header->headerSize + bodySize));
+   }
+   
+   struct cce_hash64State hashState;
+   cceHash64Init(&hashState, 0u);
+   fseek(mapFile, header->headerSize, SEEK_SET);
+   if (mapData)
+   {
+      cceHash64Update(&hashState, mapData + header->headerSize, bodySize);
+   }
+   else
+   {
+      uint8_t buffer[16384];
+      size_t readSize;
+      while ((readSize = fread(buffer, 1u, sizeof(buffer), mapFile)) > 0u)
+      {
+         cceHash64Update(&hashState, buffer, readSize);
+      }
+      fseek(mapFile, header->headerSize, SEEK_SET);
+   }
+   if (cceHash64Final(&hashState) != header->checksum)
+   {
+      cce__criticalErrorPrint("ENGINE::MAP2D_LOADER::CORRUPTED_FILE:\nchecksum of map %u doesn't match its contents", number);
+   }
+   return 1;
+}
+
+/* Returns NULL if there's no baked map or it doesn't match map file or engine settings. Baked instances are little endian, so only little endian hosts use them */
+static FILE* openBakedMap2D (uint16_t number, uint64_t mapKey, uint32_t elementsQuantity, uint32_t elementsWithoutColliderQuantity, struct BakedMap2DHeader *header)
+{
+   if (cceHostEndianess != CCE_LITTLE_ENDIAN)
+      return NULL;
+   size_t bakedFileSize;
+   FILE *bakedFile = cceOpenPackedResource(CCE_RESOURCE_BAKED_MAP2D, number, &bakedFileSize);
+   if (!bakedFile)
+   {
+      cce__shortToString(mapPath, number, ".c2b");
+      bakedFile = fopen(mapPath, "rb");
+      *(mapPath + mapPathLength) = '\0';
+      if (!bakedFile)
+         return NULL;
+      bakedFileSize = cce__getFileSize(bakedFile);
+   }
+   
+   if (fread(header, sizeof(struct BakedMap2DHeader), 1u, bakedFile) != 1u ||
+       memcmp(header->magic, "C2MB", 4u) != 0 || header->version != CCE_BAKED_MAP2D_VERSION ||
+       header->instanceSize != sizeof(struct Map2DElementInstance) ||
+       header->textureMaxWidth != cceTextureSize->x || header->textureMaxHeight != cceTextureSize->y ||
+       header->sourceKey != mapKey ||
+       header->elementsQuantity != elementsQuantity || header->elementsWithoutColliderQuantity != elementsWithoutColliderQuantity ||
+       header->collidersQuantity != ELEMENTSCOLLIDERSQUANTITY(elementsQuantity, elementsWithoutColliderQuantity) ||
+       (uint64_t) bakedFileSize != sizeof(struct BakedMap2DHeader) + header->texturesQuantity * sizeof(uint32_t) +
+                                                header->collidersQuantity * sizeof(struct Map2DCollider) +
+                                                (uint64_t) elementsQuantity * sizeof(struct Map2DElementInstance))
+   {
+      cce__errorPrint("ENGINE::MAP2D_LOADER::BAKED_MAP_MISMATCH:\nbaked map %u is outdated or was baked with different texture size. Falling back to map file", number);
+      fclose(bakedFile);
+      return NULL;
+   }
+   return bakedFile;
+}
+
+/* Whole baked map is read before anything is applied, so truncated file falls back to map file. Closes bakedFile, returns 0 on success */
+static int readBakedMap2D (FILE *bakedFile, const struct BakedMap2DHeader *header, uint16_t number,
+                           uint32_t **textureIDs, struct Map2DCollider **colliders, struct Map2DElementInstance **instances)
+{
+   *textureIDs = malloc(header->texturesQuantity * sizeof(uint32_t));
+   *colliders = header->collidersQuantity ? malloc(header->collidersQuantity * sizeof(struct Map2DCollider)) : NULL;
+   *instances = malloc(header->elementsQuantity * sizeof(struct Map2DElementInstance));
+   const uint8_t isRead = fread(*textureIDs, sizeof(uint32_t), header->texturesQuantity, bakedFile) == header->texturesQuantity &&
+                          fread(*colliders, sizeof(struct Map2DCollider), header->collidersQuantity, bakedFile) == header->collidersQuantity &&
+                          fread(*instances, sizeof(struct Map2DElementInstance), header->elementsQuantity, bakedFile) == header->elementsQuantity;
+   fclose(bakedFile);
+   if (isRead)
+      return 0;
+   cce__errorPrint("ENGINE::MAP2D_LOADER::BAKED_MAP_TRUNCATED:\nbaked map %u is shorter than its header says. Falling back to map file", number);
+   free(*textureIDs);
+   free(*colliders);
+   free(*instances);
+   *textureIDs = NULL;
+   *colliders = NULL;
+   *instances = NULL;
+   return -1;
+}
+
+/* Takes ownership of textureIDs and instances */
+static void bakedMap2DtoInstances (const struct BakedMap2DHeader *header, struct Map2D *map, uint32_t *textureIDs, struct Map2DElementInstance *instances,
+                                   uint16_t moveGroupsQuantity, struct ElementGroup *moveGroups,
+                                   uint16_t extensionGroupsQuantity, struct ElementGroup *extensionGroups)
+{
+   map->texturesMapReliesOn = cce__loadTexturesListMap2D(textureIDs, header->texturesQuantity);
+   map->texturesMapReliesOnQuantity = header->texturesQuantity;
+   free(textureIDs);
+   
+   // Baked texture IDs are positions in map's own texture list, they match engine's texture IDs only when map was loaded first
+   for (uint16_t *iterator = map->texturesMapReliesOn, *end = map->texturesMapReliesOn + map->texturesMapReliesOnQuantity; iterator < end; ++iterator)
+   {
+      if (*iterator == (iterator - map->texturesMapReliesOn) + 1u)
+         continue;
+      
+      for (struct Map2DElementInstance *jiterator = instances, *jend = instances + header->elementsQuantity; jiterator < jend; ++jiterator)
+      {
+         if (jiterator->textureID)
+            jiterator->textureID = *(map->texturesMapReliesOn + jiterator->textureID - 1u);
+      }
+      break;
+   }
+   // Instances are already converted by coffeechain-mapbake, so they are uploaded as is
+   uploadInstancesMap2D(map, instances, header->elementsQuantity);
+   free(instances);
+   
+   if (moveGroups && moveGroupsQuantity > 1u)
+      offsetCCEgroupsFromElementsToColliders(moveGroupsQuantity - 1u, moveGroups + 1u, header->elementsWithoutColliderQuantity);
+   if (extensionGroups && extensionGroupsQuantity)
+      offsetCCEgroupsFromElementsToColliders(extensionGroupsQuantity, extensionGroups, header->elementsWithoutColliderQuantity);
+}
+
+/* Elements are read with a single fread, fields are converted in place (no-op on little endian hosts). Returns NULL if file ends before them */
 static struct Map2DElement* cce__loadMap2DElements (uint32_t elementsQuantity, FILE *file)
 {
-   struct Map2DElement *elements = malloc(elementsQuantity * sizeof(struct Map2DElement));
-   for (struct Map2DElement *iterator = elements, *end = elements + elementsQuantity; iterator < end; ++iterator)
+   uint8_t *buffer = malloc(elementsQuantity * CCE_MAP2D_ELEMENT_FILE_SIZE);
+   if (fread(buffer, CCE_MAP2D_ELEMENT_FILE_SIZE, elementsQuantity, file) != elementsQuantity)
    {
-      fread(&(iterator->x), sizeof(int32_t), 2, file); // x and y at the same time
-      cceLittleEndianToHostEndianArrayInt32(&(iterator->x), 2);
-      fread(&(iterator->width), sizeof(uint16_t), 2, file);
-      cceLittleEndianToHostEndianArrayInt16(&(elements->width), 2);
-      fread(&(iterator->textureInfo), sizeof(struct Texture), 1, file);
-      cceLittleEndianToHostEndianArrayInt16(&(iterator->textureInfo), 4);
-      iterator->textureInfo.ID = cceLittleEndianToHostEndianInt32(iterator->textureInfo.ID);
-      fread(iterator->textureOffsetGroups, sizeof(uint8_t), 9, file);
+      free(buffer);
+      return NULL;
+   }
+   struct Map2DElement *elements = malloc(elementsQuantity * sizeof(struct Map2DElement));
+   uint8_t *current = buffer;
+   for (struct Map2DElement *iterator = elements, *end = elements + elementsQuantity; iterator < end; ++iterator, current += CCE_MAP2D_ELEMENT_FILE_SIZE)
+   {
+      memcpy(&(iterator->x), current, 2 * sizeof(int32_t)); // x and y at the same time
+      memcpy(&(iterator->width), current + 8, 2 * sizeof(uint16_t));
+      memcpy(&(iterator->textureInfo), current + 12, sizeof(struct Texture));
+      memcpy(iterator->textureOffsetGroups, current + 24, 9 * sizeof(uint8_t));
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
+      {
+         cceLittleEndianToHostEndianArrayInt32(&(iterator->x), 2);
+         cceLittleEndianToHostEndianArrayInt16(&(iterator->width), 2);
+         cceLittleEndianToHostEndianArrayInt16(&(iterator->textureInfo), 4);
+         iterator->textureInfo.ID = cceLittleEndianToHostEndianInt32(iterator->textureInfo.ID);
+      }
    }
+   free(buffer);
    return elements;
 }
 
@@ -449,17 +719,31 @@ static void cce__writeExitMap2Ds (struct ExitMap2D *exitMaps, uint8_t exitMapsQu
 
 struct Map2D* cceLoadMap2D (uint16_t number)
 {
-   cce__shortToString(mapPath, number, ".c2m");
-   FILE *mapFile = fopen(mapPath, "rb");
+   size_t mapFileSize;
+   const uint8_t *mapData = cceGetPackedResource(CCE_RESOURCE_MAP2D, number, &mapFileSize);
+   FILE *mapFile = (mapData) ? cceOpenPackedResource(CCE_RESOURCE_MAP2D, number, &mapFileSize) : NULL;
    if (!mapFile)
    {
-      cce__criticalErrorPrint("ENGINE::MAP2D::FAILED_TO_LOAD:\n%s - no such file or directory", mapPath);
+      cce__shortToString(mapPath, number, ".c2m");
+      mapFile = fopen(mapPath, "rb");
+      if (!mapFile)
+      {
+         cce__criticalErrorPrint("ENGINE::MAP2D::FAILED_TO_LOAD:\n%s - no such file or directory", mapPath);
+      }
+      *(mapPath + mapPathLength) = '\0';
+      mapFileSize = cce__getFileSize(mapFile);
+      mapData = NULL;
    }
-   *(mapPath + mapPathLength) = '\0';
+   struct Map2DFileHeader fileHeader;
+   int isVerified = verifyMap2DFile(mapFile, mapData, mapFileSize, number, &fileHeader);
    
    struct Map2D *map = (struct Map2D*) malloc(sizeof(struct Map2D));
    map->ID = number;
    map->delayedActions = LL_LIST_INIT(LL_SINGLELINKED);
+   map->isTextureEvicted = 0u;
+   map->lastDrawnFrame = 0u;
+   map->tiles = NULL;
+   map->tilesQuantity = 0u;
    // GL elements
    {
       struct Map2DElement *elements;
@@ -471,18 +755,31 @@ struct Map2D* cceLoadMap2D (uint16_t number)
       elementsCollidersQuantity = ELEMENTSCOLLIDERSQUANTITY(map->elementsQuantity, elementsWithoutColliderQuantity);
       struct Map2DCollider *colliders;
       colliders = NULL;
+      struct BakedMap2DHeader bakedHeader;
+      uint32_t *bakedTextureIDs = NULL;
+      struct Map2DElementInstance *bakedInstances = NULL;
       if (map->elementsQuantity)
-         elements = cce__loadMap2DElements(map->elementsQuantity, mapFile);
+      {
+         FILE *bakedFile = openBakedMap2D(number, (isVerified) ? fileHeader.checksum : mapFileSize, map->elementsQuantity, elementsWithoutColliderQuantity, &bakedHeader);
+         if (bakedFile && readBakedMap2D(bakedFile, &bakedHeader, number, &bakedTextureIDs, &colliders, &bakedInstances) == 0)
+            fseek(mapFile, (long) map->elementsQuantity * CCE_MAP2D_ELEMENT_FILE_SIZE, SEEK_CUR);
+         else if (!(elements = cce__loadMap2DElements(map->elementsQuantity, mapFile)))
+            cce__criticalErrorPrint("ENGINE::MAP2D_LOADER::CORRUPTED_FILE:\nfile of map %u ends before its %u elements", number, map->elementsQuantity);
+      }
       fread(&(map->moveGroupsQuantity), 2u/*uint16_t*/, 1u, mapFile);
       map->moveGroupsQuantity = cceLittleEndianToHostEndianInt16(map->moveGroupsQuantity);
       map->moveGroups = cce__loadGroups(map->moveGroupsQuantity, mapFile);
       fread(&(map->extensionGroupsQuantity), 2u/*uint16_t*/, 1u, mapFile);
       map->extensionGroupsQuantity = cceLittleEndianToHostEndianInt16(map->extensionGroupsQuantity);
       map->extensionGroups = cce__loadGroups(map->extensionGroupsQuantity, mapFile);
-      if (map->elementsQuantity)
+      if (bakedInstances)
+      {
+         bakedMap2DtoInstances(&bakedHeader, map, bakedTextureIDs, bakedInstances, map->moveGroupsQuantity, map->moveGroups, map->extensionGroupsQuantity, map->extensionGroups);
+      }
+      else if (map->elementsQuantity)
       {
          colliders = elementsToColliders(map->elementsQuantity, elementsWithoutColliderQuantity, elements, &(map->texturesMapReliesOn), &(map->texturesMapReliesOnQuantity),
-                                         map->moveGroupsQuantity, map->moveGroups, map->extensionGroupsQuantity, map->extensionGroups,  &(map->VAO), &(map->VBO));
+                                         map->moveGroupsQuantity, map->moveGroups, map->extensionGroupsQuantity, map->extensionGroups, map);
       }
       uint32_t collidersQuantity;
       fread(&collidersQuantity, 4u, 1u, mapFile);
@@ -492,7 +789,7 @@ struct Map2D* cceLoadMap2D (uint16_t number)
       if (collidersQuantity)
       {
          fread((map->colliders + elementsCollidersQuantity), sizeof(struct Map2DCollider), collidersQuantity, mapFile);
-         if (g_endianess == CCE_BIG_ENDIAN)
+         if (cceHostEndianess == CCE_BIG_ENDIAN)
             for (struct Map2DCollider *iterator = map->colliders + elementsCollidersQuantity, *end = map->colliders + map->collidersQuantity; iterator < end; ++iterator)
             {
                cceLittleEndianToBigEndianArrayInt32(&(iterator->x), 2);
@@ -569,8 +866,8 @@ struct Map2D* cceLoadMap2D (uint16_t number)
       map->exitMaps = cce__loadExitMap2Ds(map->exitMapsQuantity, mapFile);
    }
    
-   // I'm lazy
-   for (uint8_t smth = 0u, i = 0u; i < 10; ++i)
+   // Verified files need no sanity checks, old ones are checked by their reserved bytes
+   for (uint8_t smth = 0u, i = 0u; !isVerified && i < 10; ++i)
    {
       fread(&smth, 1u, 1u, mapFile);
       if (smth)
@@ -607,6 +904,10 @@ struct Map2D* cceMap2DdevToMap2D (struct Map2Ddev *mapdev)
    struct Map2D *map = (struct Map2D*) malloc(sizeof(struct Map2D));
    map->ID = mapdev->ID;
    map->delayedActions = LL_LIST_INIT(LL_SINGLELINKED);
+   map->isTextureEvicted = 0u;
+   map->lastDrawnFrame = 0u;
+   map->tiles = NULL;
+   map->tilesQuantity = 0u;
    map->moveGroupsQuantity = mapdev->moveGroupsQuantity;
    if (mapdev->moveGroupsQuantity)
    {
@@ -634,7 +935,7 @@ struct Map2D* cceMap2DdevToMap2D (struct Map2Ddev *mapdev)
       if (mapdev->elementsQuantity)
       {
          colliders = elementsToColliders(mapdev->elementsQuantity, mapdev->elementsWithoutColliderQuantity, elements, &(map->texturesMapReliesOn), &(map->texturesMapReliesOnQuantity),
-                                         mapdev->moveGroupsQuantity, map->moveGroups, mapdev->extensionGroupsQuantity, map->extensionGroups, &(map->VAO), &(map->VBO));
+                                         mapdev->moveGroupsQuantity, map->moveGroups, mapdev->extensionGroupsQuantity, map->extensionGroups, map);
       }
       map->collidersQuantity = elementsCollidersQuantity + mapdev->collidersQuantity;
       if (mapdev->collidersQuantity)
@@ -756,14 +1057,16 @@ struct Map2Ddev* cceLoadMap2Ddev (uint16_t number)
       cce__criticalErrorPrint("ENGINE::MAP2Ddev::FAILED_TO_LOAD:\n%s - no such file or directory", mapPath);
    }
    *(mapPath + mapPathLength) = '\0';
+   struct Map2DFileHeader fileHeader;
+   int isVerified = verifyMap2DFile(mapFile, NULL, cce__getFileSize(mapFile), number, &fileHeader);
    struct Map2Ddev *map = (struct Map2Ddev*) calloc(1u, sizeof(struct Map2Ddev));
    map->ID = number;
    fread(&(map->elementsQuantity), 4u/*uint32_t*/, 1u, mapFile);
    map->elementsQuantity = cceLittleEndianToHostEndianInt32(map->elementsQuantity);
    fread(&(map->elementsWithoutColliderQuantity), 4u/*uint32_t*/, 1u, mapFile);
    map->elementsWithoutColliderQuantity = cceLittleEndianToHostEndianInt32(map->elementsWithoutColliderQuantity);
-   if ((map->elementsQuantity))
-      map->elements = cce__loadMap2DElements(map->elementsQuantity, mapFile);
+   if ((map->elementsQuantity) && !(map->elements = cce__loadMap2DElements(map->elementsQuantity, mapFile)))
+      cce__criticalErrorPrint("ENGINE::MAP2Ddev_LOADER::CORRUPTED_FILE:\nfile of map %u ends before its %u elements", number, map->elementsQuantity);
    fread(&(map->moveGroupsQuantity), 2u/*uint16_t*/, 1u, mapFile);
    map->moveGroupsQuantity = cceLittleEndianToHostEndianInt16(map->moveGroupsQuantity);
    map->moveGroups = (struct DynamicElementGroup*) cce__loadGroups(map->moveGroupsQuantity, mapFile);
@@ -778,7 +1081,7 @@ struct Map2Ddev* cceLoadMap2Ddev (uint16_t number)
    {
       map->colliders = (struct Map2DCollider*) malloc(map->collidersQuantity * sizeof(struct Map2DCollider));
       fread(map->colliders, sizeof(struct Map2DCollider), map->collidersQuantity, mapFile);
-      if (g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
          for (struct Map2DCollider *iterator = map->colliders, *end = map->colliders + map->collidersQuantity; iterator < end; ++iterator)
          {
             cceLittleEndianToBigEndianArrayInt32(&(iterator->x), 2);
@@ -830,8 +1133,8 @@ struct Map2Ddev* cceLoadMap2Ddev (uint16_t number)
       map->exitMaps = cce__loadExitMap2Ds(map->exitMapsQuantity, mapFile);
    }
    
-   // I'm lazy, again
-   for (uint8_t smth = 0u, i = 0u; i < 10; ++i)
+   // Verified files need no sanity checks, old ones are checked by their reserved bytes
+   for (uint8_t smth = 0u, i = 0u; !isVerified && i < 10; ++i)
    {
       fread(&smth, 1u, 1u, mapFile);
       if (smth)
@@ -847,6 +1150,28 @@ struct Map2Ddev* cceLoadMap2Ddev (uint16_t number)
    return map;
 }
 
+static void endMap2DFileSection (FILE *mapFile, long *sectionStart, uint32_t *sectionSize)
+{
+   long position = ftell(mapFile);
+   *sectionSize = (uint32_t) (position - *sectionStart);
+   *sectionStart = position;
+}
+
+static uint64_t hashMap2DFileBody (FILE *mapFile, long bodyStart)
+{
+   struct cce_hash64State hashState;
+   cceHash64Init(&hashState, 0u);
+   fflush(mapFile);
+   fseek(mapFile, bodyStart, SEEK_SET);
+   uint8_t buffer[16384];
+   size_t readSize;
+   while ((readSize = fread(buffer, 1u, sizeof(buffer), mapFile)) > 0u)
+   {
+      cceHash64Update(&hashState, buffer, readSize);
+   }
+   return cceHash64Final(&hashState);
+}
+
 int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
 {
    union
@@ -856,13 +1181,17 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
       uint16_t arr16[2];
    } temporary;
    cce__shortToString(mapPath, map->ID, ".c2m");
-   FILE *mapFile = fopen(mapPath, "wb");
+   FILE *mapFile = fopen(mapPath, "w+b");
    if (!mapFile)
    {
       cce__errorPrint("ENGINE::MAP2Ddev::FAILED_TO_OPEN_FILE:\n%s - cannot open file. Are you haven't enough free space left? Are you have a directory with same name? Does directory really exist?\n", mapPath);
       return -1;
    }
    *(mapPath + mapPathLength) = '\0';
+   struct Map2DFileHeader header;
+   memset(&header, 0, sizeof(struct Map2DFileHeader));
+   fwrite(&header, sizeof(struct Map2DFileHeader), 1, mapFile); // Filled when all sections are written
+   long sectionStart = ftell(mapFile);
    temporary.u32 = cceHostEndianToLittleEndianInt32(map->elementsQuantity);
    fwrite(&(temporary.u32), 4/*uint32_t*/, 1, mapFile);
    temporary.u32 = cceHostEndianToLittleEndianInt32(map->elementsWithoutColliderQuantity);
@@ -871,23 +1200,26 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
    {
       cce__writeMap2DElements(map->elements, map->elementsQuantity, mapFile);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_ELEMENTS);
    temporary.u16 = cceHostEndianToLittleEndianInt16(map->moveGroupsQuantity);
    fwrite(&(temporary.u16), 2/*uint16_t*/, 1, mapFile);
    if ((map->moveGroupsQuantity))
    {
       cce__writeGroups(map->moveGroupsQuantity, (struct ElementGroup*) map->moveGroups, mapFile);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_MOVE_GROUPS);
    temporary.u16 = cceHostEndianToLittleEndianInt16(map->extensionGroupsQuantity);
    fwrite(&(temporary.u16), 2/*uint16_t*/, 1, mapFile);
    if ((map->extensionGroupsQuantity))
    {
       cce__writeGroups(map->extensionGroupsQuantity, (struct ElementGroup*) map->extensionGroups, mapFile);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_EXTENSION_GROUPS);
    temporary.u32 = cceHostEndianToLittleEndianInt32(map->collidersQuantity);
    fwrite(&(temporary.u32), 4/*uint32_t*/, 1, mapFile);
    if ((map->collidersQuantity))
    {
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          struct Map2DCollider collider;
          for (struct Map2DCollider *iterator = map->colliders, *end = map->colliders + map->collidersQuantity; iterator < end; ++iterator)
@@ -903,17 +1235,19 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
          fwrite(map->colliders, sizeof(struct Map2DCollider), map->collidersQuantity, mapFile);
       }
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_COLLIDERS);
    temporary.u16 = cceHostEndianToLittleEndianInt16(map->collisionGroupsQuantity);
    fwrite(&(temporary.u16), 2/*uint16_t*/, 1, mapFile);
    if ((map->collisionGroupsQuantity))
    {
       cce__writeGroups(map->collisionGroupsQuantity, (struct ElementGroup*) map->collisionGroups, mapFile);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_COLLISION_GROUPS);
    temporary.u16 = cceHostEndianToLittleEndianInt16(map->collisionQuantity);
    fwrite(&(temporary.u16), 2/*uint16_t*/, 1, mapFile);
    if ((map->collisionQuantity))
    {
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          for (struct CollisionGroup *iterator = map->collision, *end = map->collision + map->collisionQuantity; iterator < end; ++iterator)
          {
@@ -926,11 +1260,12 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
          fwrite((map->collision), sizeof(struct CollisionGroup), (map->collisionQuantity), mapFile);
       }
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_COLLISION);
    temporary.u16 = cceHostEndianToLittleEndianInt16(map->timersQuantity);
    fwrite(&(temporary.u16), 2/*uint16_t*/, 1, mapFile);
    if ((map->timersQuantity))
    {
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          for (uint32_t *iterator = (uint32_t*) map->timers, *end = (uint32_t*) map->timers + map->timersQuantity; iterator < end; ++iterator)
          {
@@ -943,16 +1278,18 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
          fwrite((map->timers), 4/*float*/, (map->timersQuantity), mapFile);
       }
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_TIMERS);
    temporary.u32 = cceHostEndianToLittleEndianInt32(map->logicQuantity);
    fwrite(&(temporary.u32), 4/*uint32_t*/, 1, mapFile);
    if (map->logicQuantity)
    {
       cce__writeLogic(map->logicQuantity, map->logic, mapFile, cce_endianSwapActions);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_LOGIC);
    fwrite(&(map->actionsQuantity), 1/*uint8_t*/, 1, mapFile);
    if (map->actionsQuantity)
    {
-      if (*g_endianess == CCE_BIG_ENDIAN)
+      if (cceHostEndianess == CCE_BIG_ENDIAN)
       {
          for (uint32_t *iterator = map->actionIDs, *end = map->actionIDs + map->actionsQuantity; iterator < end; ++iterator)
          {
@@ -972,22 +1309,454 @@ int cceWriteMap2Ddev (struct Map2Ddev *map, void (*writeFunc)(FILE*))
       }
       fwrite( (map->actionsArg),            1/*cce_void*/, *(map->actionsArgOffsets + map->actionsQuantity), mapFile);
    }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_STATIC_ACTIONS);
    fwrite(&(map->exitMapsQuantity), 1/*uint8_t*/, 1, mapFile);
    if (map->exitMapsQuantity)
    {
       cce__writeExitMap2Ds(map->exitMaps, map->exitMapsQuantity, mapFile);
    }
-   
-   // I'm lazy, again
-   uint8_t null = 0u;
-   for (uint8_t i = 0u; i < 10; ++i)
-   {
-      fwrite(&null, 1u/*uint8_t*/, 1u, mapFile);
-   }
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_EXIT_MAPS);
    if (writeFunc) writeFunc(mapFile);
+   endMap2DFileSection(mapFile, &sectionStart, header.sectionSizes + CCE_MAP2D_SECTION_GAME_DATA);
+   
+   memcpy(header.magic, "C2MH", 4u);
+   header.version = CCE_MAP2D_FILE_VERSION;
+   header.headerSize = sizeof(struct Map2DFileHeader);
+   header.featureFlags = (header.sectionSizes[CCE_MAP2D_SECTION_GAME_DATA]) ? CCE_MAP2D_FILE_GAME_DATA : 0u;
+   header.checksum = hashMap2DFileBody(mapFile, header.headerSize);
+   cceHostEndianToLittleEndianArrayInt16(&(header.version), 2);
+   header.featureFlags = cceHostEndianToLittleEndianInt32(header.featureFlags);
+   cceHostEndianToLittleEndianArrayInt32(header.sectionSizes, CCE_MAP2D_SECTIONS_QUANTITY);
+   header.checksum = cceHostEndianToLittleEndianInt64(header.checksum);
+   fseek(mapFile, 0, SEEK_SET);
+   fwrite(&header, sizeof(struct Map2DFileHeader), 1, mapFile);
    if (fclose(mapFile) == -1)
    {
       cce__errorPrint("ENGINE::MAP2Ddev_MAPWRITER::FILE_UNEXPECTED_CLOSE:\nmap %u file was unexpectedly closed by external file handler", map->ID);
    }
    return 0;
 }
+
+/* Writes map_<number>.c2b next to map file. Textures' sizes are taken from texturesPath, so baked map is only valid for same images and same texture size */
+int cceBakeMap2D (uint16_t number, const char *texturesPath, uint32_t textureMaxWidth, uint32_t textureMaxHeight)
+{
+   if (cceHostEndianess != CCE_LITTLE_ENDIAN)
+   {
+      cce__errorPrint("ENGINE::MAP2D_BAKER::UNSUPPORTED_PLATFORM:\nbaked maps are little endian only, map %u is not baked", number);
+      return -1;
+   }
+   struct BakedMap2DHeader header;
+   memset(&header, 0, sizeof(struct BakedMap2DHeader));
+   {
+      cce__shortToString(mapPath, number, ".c2m");
+      FILE *mapFile = fopen(mapPath, "rb");
+      if (!mapFile)
+      {
+         cce__errorPrint("ENGINE::MAP2D_BAKER::FAILED_TO_LOAD:\n%s - no such file or directory", mapPath);
+         *(mapPath + mapPathLength) = '\0';
+         return -1;
+      }
+      *(mapPath + mapPathLength) = '\0';
+      struct Map2DFileHeader fileHeader;
+      uint64_t mapFileSize = cce__getFileSize(mapFile);
+      header.sourceKey = (verifyMap2DFile(mapFile, NULL, mapFileSize, number, &fileHeader)) ? fileHeader.checksum : mapFileSize;
+      fclose(mapFile);
+   }
+   struct Map2Ddev *mapdev = cceLoadMap2Ddev(number);
+   if (!mapdev)
+   {
+      cce__errorPrint("ENGINE::MAP2D_BAKER::FAILED_TO_LOAD:\nmap %u could not be loaded", number);
+      return -1;
+   }
+   if (!mapdev->elementsQuantity)
+   {
+      cceFreeMap2Ddev(mapdev);
+      return 0;
+   }
+   memcpy(header.magic, "C2MB", 4u);
+   header.version = CCE_BAKED_MAP2D_VERSION;
+   header.instanceSize = sizeof(struct Map2DElementInstance);
+   header.textureMaxWidth  = textureMaxWidth;
+   header.textureMaxHeight = textureMaxHeight;
+   header.elementsQuantity = mapdev->elementsQuantity;
+   header.elementsWithoutColliderQuantity = mapdev->elementsWithoutColliderQuantity;
+   header.collidersQuantity = ELEMENTSCOLLIDERSQUANTITY(mapdev->elementsQuantity, mapdev->elementsWithoutColliderQuantity);
+   
+   // Same order as cce__loadTexturesMap2D, so baked texture IDs usually need no patching at runtime
+   uint32_t *textureIDs = malloc(mapdev->elementsQuantity * sizeof(uint32_t));
+   struct cce_u16vec2 *textureSizes = malloc(mapdev->elementsQuantity * sizeof(struct cce_u16vec2));
+   uint16_t *elementTextures = malloc(mapdev->elementsQuantity * sizeof(uint16_t));
+   {
+      char *imagePath = cceCreateNewPathFromOldPath(texturesPath, "img_", 10u);
+      size_t imagePathLength = strlen(imagePath);
+      uint16_t *current = elementTextures;
+      for (struct Map2DElement *iterator = mapdev->elements, *end = mapdev->elements + mapdev->elementsQuantity; iterator < end; ++iterator, ++current)
+      {
+         *current = 0u;
+         if (iterator->textureInfo.ID == 0u)
+            continue;
+         for (uint16_t i = 0u; i < header.texturesQuantity; ++i)
+         {
+            if (*(textureIDs + i) == iterator->textureInfo.ID)
+            {
+               *current = i + 1u;
+               break;
+            }
+         }
+         if (*current)
+            continue;
+         int width = 0, height = 0, channels;
+         cce__shortToString(imagePath, iterator->textureInfo.ID - 1u, ".png");
+         stbi_info(imagePath, &width, &height, &channels);
+         *(imagePath + imagePathLength) = '\0';
+         *(textureIDs + header.texturesQuantity) = iterator->textureInfo.ID;
+         *(textureSizes + header.texturesQuantity) = (struct cce_u16vec2){width, height};
+         *current = ++(header.texturesQuantity);
+      }
+      free(imagePath);
+   }
+   
+   uint16_t *glGroups = elementsToGLgroups(mapdev->elementsQuantity, mapdev->elementsWithoutColliderQuantity, &(mapdev->elements),
+                                           mapdev->moveGroupsQuantity, (struct ElementGroup*) mapdev->moveGroups,
+                                           mapdev->extensionGroupsQuantity, (struct ElementGroup*) mapdev->extensionGroups);
+   struct Map2DElementInstance *instances = malloc(mapdev->elementsQuantity * sizeof(struct Map2DElementInstance));
+   {
+      uint16_t *moveGroups = glGroups, *extensionGroups = glGroups + mapdev->elementsQuantity * 4u;
+      uint8_t *globalOffsets = (uint8_t*) (glGroups + mapdev->elementsQuantity * 2u * 4u);
+      uint16_t *current = elementTextures;
+      struct Map2DElementInstance *currentInstance = instances;
+      for (struct Map2DElement *iterator = mapdev->elements, *end = mapdev->elements + mapdev->elementsQuantity; iterator < end;
+           ++iterator, ++current, moveGroups += 4, extensionGroups += 4, ++globalOffsets, ++currentInstance)
+      {
+         cce__elementToMap2DElementInstanceSized(currentInstance, iterator->x, iterator->y, iterator->width, iterator->height, moveGroups, 4, extensionGroups, 4,
+                                                 *globalOffsets, iterator->rotateGroup, &(iterator->textureInfo), *current,
+                                                 (*current) ? *(textureSizes + *current - 1u) : (struct cce_u16vec2){0u, 0u},
+                                                 iterator->textureOffsetGroups, 4, iterator->colorGroups, 4);
+      }
+   }
+   free(elementTextures);
+   free(textureSizes);
+   struct Map2DCollider *colliders = elementsToCollidersInPlace(mapdev->elements, mapdev->elementsQuantity, mapdev->elementsWithoutColliderQuantity);
+   
+   int result = 0;
+   cce__shortToString(mapPath, number, ".c2b");
+   FILE *bakedFile = fopen(mapPath, "wb");
+   if (bakedFile)
+   {
+      fwrite(&header, sizeof(struct BakedMap2DHeader), 1u, bakedFile);
+      fwrite(textureIDs, sizeof(uint32_t), header.texturesQuantity, bakedFile);
+      fwrite(colliders, sizeof(struct Map2DCollider), header.collidersQuantity, bakedFile);
+      fwrite(instances, sizeof(struct Map2DElementInstance), header.elementsQuantity, bakedFile);
+      if (fclose(bakedFile) == -1)
+      {
+         cce__errorPrint("ENGINE::MAP2D_BAKER::FILE_UNEXPECTED_CLOSE:\n%s was unexpectedly closed by external file handler", mapPath);
+         result = -1;
+      }
+   }
+   else
+   {
+      cce__errorPrint("ENGINE::MAP2D_BAKER::FAILED_TO_OPEN_FILE:\n%s - cannot open file", mapPath);
+      result = -1;
+   }
+   *(mapPath + mapPathLength) = '\0';
+   free(instances);
+   free(textureIDs);
+   cceFreeMap2Ddev(mapdev);
+   return result;
+}
+
+/* World index (world_<n>.c2w) lives next to maps, see docs/Map2D.txt */
+#define CCE_WORLD_MAP2D_VERSION 2u
+#define CCE_WORLD_MAP2D_MAX_CELLS 0x1000000u
+
+/* Coordinates are always stored as 64-bit, so the same file works with both 32-bit and 64-bit world coordinates */
+struct WorldMap2DFileHeader
+{
+   char     magic[4];             /* "C2WI" */
+   uint16_t version;
+   uint16_t reserved;
+   int64_t  gridOrigin[2];
+   struct cce_u32vec2 cellSize;
+   struct cce_u32vec2 gridSize;
+   uint32_t mapsQuantity;
+   uint32_t cellMapsQuantity;
+}; // 48 bytes
+
+struct WorldMap2DFileMap
+{
+   uint32_t ID;
+   uint32_t reserved;
+   int64_t  coordinates[6];      /* origin, boundsMin, boundsMax */
+}; // 56 bytes
+
+static char* createWorldMap2Dpath (uint16_t number)
+{
+   size_t directoryLength = mapPathLength - (sizeof("map_") - 1u);
+   char *worldPath = malloc(directoryLength + sizeof("world_65535.c2w"));
+   memcpy(worldPath, mapPath, directoryLength);
+   memcpy(worldPath + directoryLength, "world_", sizeof("world_"));
+   cce__shortToString(worldPath, number, ".c2w");
+   return worldPath;
+}
+
+static int compareWorldMap2Dmaps (const void *a, const void *b)
+{
+   const struct WorldMap2Dmap *first = a, *second = b;
+   return (first->ID > second->ID) - (first->ID < second->ID);
+}
+
+static inline uint32_t getWorldMap2Dcell (int64_t coordinate, int64_t gridOrigin, uint32_t cellSize)
+{
+   return (uint32_t) ((coordinate - gridOrigin) / cellSize);
+}
+
+/* Doesn't let coordinates outside of cce_world_coord through when library is built without 64-bit world coordinates */
+static inline uint8_t isWorldMap2DcoordinateSupported (int64_t coordinate)
+{
+   return (cce_world_coord) coordinate == coordinate;
+}
+
+void cce__freeWorldMap2D (struct WorldMap2D *world)
+{
+   if (!world)
+      return;
+   free(world->maps);
+   free(world->cellStarts);
+   free(world->cellMaps);
+   free(world);
+}
+
+/* Returns NULL if there's no world index or it is broken, caller falls back to exit maps */
+struct WorldMap2D* cce__loadWorldMap2D (uint16_t number)
+{
+   FILE *worldFile = cceOpenPackedResource(CCE_RESOURCE_WORLD_MAP2D, number, NULL);
+   if (!worldFile)
+   {
+      char *worldPath = createWorldMap2Dpath(number);
+      worldFile = fopen(worldPath, "rb");
+      if (!worldFile)
+      {
+         cce__errorPrint("ENGINE::WORLD_MAP2D::FAILED_TO_LOAD:\n%s - no such file or directory", worldPath);
+         free(worldPath);
+         return NULL;
+      }
+      free(worldPath);
+   }
+   struct WorldMap2DFileHeader header;
+   if (fread(&header, sizeof(struct WorldMap2DFileHeader), 1u, worldFile) != 1u || memcmp(header.magic, "C2WI", 4u) != 0)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::PARSING_ERROR:\nworld %u is not a world index", number);
+      fclose(worldFile);
+      return NULL;
+   }
+   header.version = cceLittleEndianToHostEndianInt16(header.version);
+   cceLittleEndianToHostEndianArrayInt64(header.gridOrigin, 2);
+   cceLittleEndianToHostEndianArrayInt32(&(header.cellSize), 6);
+   uint64_t cellsQuantity = (uint64_t) header.gridSize.x * header.gridSize.y;
+   if (header.version != CCE_WORLD_MAP2D_VERSION || !header.cellSize.x || !header.cellSize.y || !cellsQuantity ||
+       cellsQuantity > CCE_WORLD_MAP2D_MAX_CELLS || header.mapsQuantity > UINT16_MAX + 1u)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::PARSING_ERROR:\nworld %u has unsupported version or grid", number);
+      fclose(worldFile);
+      return NULL;
+   }
+   // Quantities are checked against the rest of the file before anything is allocated for them
+   const uint64_t bodySize = (uint64_t) header.mapsQuantity * sizeof(struct WorldMap2DFileMap) + (cellsQuantity + 1u) * sizeof(uint32_t) +
+                             (uint64_t) header.cellMapsQuantity * sizeof(uint16_t);
+   const long fileSize = cce__getFileSize(worldFile), position = ftell(worldFile);
+   if (fileSize < 0 || position < 0 || bodySize > (uint64_t) (fileSize - position))
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::PARSING_ERROR:\nworld %u is truncated or corrupted", number);
+      fclose(worldFile);
+      return NULL;
+   }
+   
+   struct WorldMap2D *world = malloc(sizeof(struct WorldMap2D));
+   world->gridOrigin = (struct cce_worldvec2) {(cce_world_coord) header.gridOrigin[0], (cce_world_coord) header.gridOrigin[1]};
+   world->cellSize = header.cellSize;
+   world->gridSize = header.gridSize;
+   world->mapsQuantity = header.mapsQuantity;
+   world->maps = malloc(header.mapsQuantity * sizeof(struct WorldMap2Dmap));
+   world->cellStarts = malloc((cellsQuantity + 1u) * sizeof(uint32_t));
+   world->cellMaps = malloc(header.cellMapsQuantity * sizeof(uint16_t));
+   struct WorldMap2DFileMap *fileMaps = malloc(header.mapsQuantity * sizeof(struct WorldMap2DFileMap));
+   size_t readQuantity = fread(fileMaps, sizeof(struct WorldMap2DFileMap), header.mapsQuantity, worldFile) +
+                         fread(world->cellStarts, sizeof(uint32_t), cellsQuantity + 1u, worldFile) +
+                         fread(world->cellMaps, sizeof(uint16_t), header.cellMapsQuantity, worldFile);
+   fclose(worldFile);
+   cceLittleEndianToHostEndianArrayInt32(world->cellStarts, cellsQuantity + 1u);
+   cceLittleEndianToHostEndianArrayInt16(world->cellMaps, header.cellMapsQuantity);
+   
+   // Index is trusted after this, streaming does no bounds checks
+   uint8_t isValid = (readQuantity == header.mapsQuantity + cellsQuantity + 1u + header.cellMapsQuantity) &&
+                     (*(world->cellStarts) == 0u) && (*(world->cellStarts + cellsQuantity) == header.cellMapsQuantity);
+   uint8_t isSupported = isWorldMap2DcoordinateSupported(header.gridOrigin[0]) && isWorldMap2DcoordinateSupported(header.gridOrigin[1]);
+   for (struct WorldMap2DFileMap *iterator = fileMaps, *end = fileMaps + header.mapsQuantity; isValid && iterator < end; ++iterator)
+   {
+      iterator->ID = cceLittleEndianToHostEndianInt32(iterator->ID);
+      cceLittleEndianToHostEndianArrayInt64(iterator->coordinates, 6);
+      struct WorldMap2Dmap *map = world->maps + (iterator - fileMaps);
+      map->ID = iterator->ID;
+      map->origin    = (struct cce_worldvec2) {(cce_world_coord) iterator->coordinates[0], (cce_world_coord) iterator->coordinates[1]};
+      map->boundsMin = (struct cce_worldvec2) {(cce_world_coord) iterator->coordinates[2], (cce_world_coord) iterator->coordinates[3]};
+      map->boundsMax = (struct cce_worldvec2) {(cce_world_coord) iterator->coordinates[4], (cce_world_coord) iterator->coordinates[5]};
+      for (int64_t *coordinate = iterator->coordinates, *coordinatesEnd = iterator->coordinates + 6; coordinate < coordinatesEnd; ++coordinate)
+      {
+         isSupported &= isWorldMap2DcoordinateSupported(*coordinate);
+      }
+   }
+   free(fileMaps);
+   if (isValid && !isSupported)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::PARSING_ERROR:\nworld %u needs 64-bit world coordinates (CoffeeChain_WORLD_COORDINATES_64)", number);
+      cce__freeWorldMap2D(world);
+      return NULL;
+   }
+   for (uint32_t *iterator = world->cellStarts, *end = world->cellStarts + cellsQuantity; isValid && iterator < end; ++iterator)
+   {
+      isValid = (*iterator <= *(iterator + 1));
+   }
+   for (uint16_t *iterator = world->cellMaps, *end = world->cellMaps + header.cellMapsQuantity; isValid && iterator < end; ++iterator)
+   {
+      isValid = (*iterator < header.mapsQuantity);
+   }
+   for (struct WorldMap2Dmap *iterator = world->maps + 1, *end = world->maps + header.mapsQuantity; isValid && iterator < end; ++iterator)
+   {
+      isValid = ((iterator - 1)->ID < iterator->ID);
+   }
+   if (!isValid)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D::PARSING_ERROR:\nworld %u is truncated or corrupted", number);
+      cce__freeWorldMap2D(world);
+      return NULL;
+   }
+   return world;
+}
+
+/* Counts map in every cell it intersects (cellMaps is NULL) or puts its position at cellPositions of these cells */
+static void placeMapInWorldMap2Dcells (const struct WorldMap2Dmap *map, const struct WorldMap2DFileHeader *header, struct cce_u32vec2 cellSize,
+                                       uint32_t *cellPositions, uint16_t *cellMaps, uint16_t mapPosition)
+{
+   uint32_t x1 = getWorldMap2Dcell(map->boundsMin.x, header->gridOrigin[0], cellSize.x), x2 = getWorldMap2Dcell((int64_t) map->boundsMax.x - 1, header->gridOrigin[0], cellSize.x);
+   uint32_t y1 = getWorldMap2Dcell(map->boundsMin.y, header->gridOrigin[1], cellSize.y), y2 = getWorldMap2Dcell((int64_t) map->boundsMax.y - 1, header->gridOrigin[1], cellSize.y);
+   for (uint32_t y = y1; y <= y2; ++y)
+   {
+      for (uint32_t *cellPosition = cellPositions + y * header->gridSize.x + x1, *end = cellPositions + y * header->gridSize.x + x2; cellPosition <= end; ++cellPosition)
+      {
+         if (cellMaps)
+            *(cellMaps + *cellPosition) = mapPosition;
+         ++(*cellPosition);
+      }
+   }
+}
+
+/* Builds grid from bounds of maps. Bounds maximum is exclusive */
+CCE_PUBLIC_OPTIONS int cceWriteWorldMap2D (uint16_t number, const struct WorldMap2Dmap *maps, uint32_t mapsQuantity, struct cce_u32vec2 cellSize)
+{
+   if (!mapsQuantity || mapsQuantity > UINT16_MAX + 1u || !cellSize.x || !cellSize.y)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D_WRITER::INVALID_ARGUMENTS:\nworld %u needs 1 - 65536 maps and non-zero cell size", number);
+      return -1;
+   }
+   struct WorldMap2DFileHeader header;
+   memset(&header, 0, sizeof(struct WorldMap2DFileHeader));
+   int64_t gridEnd[2] = {maps->boundsMax.x, maps->boundsMax.y};
+   header.gridOrigin[0] = maps->boundsMin.x;
+   header.gridOrigin[1] = maps->boundsMin.y;
+   for (const struct WorldMap2Dmap *iterator = maps, *end = maps + mapsQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->boundsMin.x >= iterator->boundsMax.x || iterator->boundsMin.y >= iterator->boundsMax.y)
+      {
+         cce__errorPrint("ENGINE::WORLD_MAP2D_WRITER::INVALID_ARGUMENTS:\nmap %u has empty bounds", iterator->ID);
+         return -1;
+      }
+      header.gridOrigin[0] = (iterator->boundsMin.x < header.gridOrigin[0]) ? iterator->boundsMin.x : header.gridOrigin[0];
+      header.gridOrigin[1] = (iterator->boundsMin.y < header.gridOrigin[1]) ? iterator->boundsMin.y : header.gridOrigin[1];
+      gridEnd[0] = (iterator->boundsMax.x > gridEnd[0]) ? iterator->boundsMax.x : gridEnd[0];
+      gridEnd[1] = (iterator->boundsMax.y > gridEnd[1]) ? iterator->boundsMax.y : gridEnd[1];
+   }
+   uint64_t columns = ((uint64_t) (gridEnd[0] - header.gridOrigin[0]) + cellSize.x - 1u) / cellSize.x;
+   uint64_t rows    = ((uint64_t) (gridEnd[1] - header.gridOrigin[1]) + cellSize.y - 1u) / cellSize.y;
+   uint64_t cellsQuantity = columns * rows;
+   if (columns > CCE_WORLD_MAP2D_MAX_CELLS || rows > CCE_WORLD_MAP2D_MAX_CELLS || cellsQuantity > CCE_WORLD_MAP2D_MAX_CELLS)
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D_WRITER::TOO_MANY_CELLS:\nworld %u would have %lu cells, use bigger cell size", number, (unsigned long) cellsQuantity);
+      return -1;
+   }
+   header.gridSize = (struct cce_u32vec2) {(uint32_t) columns, (uint32_t) rows};
+   
+   struct WorldMap2Dmap *sortedMaps = malloc(mapsQuantity * sizeof(struct WorldMap2Dmap));
+   memcpy(sortedMaps, maps, mapsQuantity * sizeof(struct WorldMap2Dmap));
+   qsort(sortedMaps, mapsQuantity, sizeof(struct WorldMap2Dmap), compareWorldMap2Dmaps);
+   
+   // Counting sort of (cell, map) pairs: count maps per cell, turn counts into starts, then fill
+   uint32_t *cellStarts = calloc(cellsQuantity + 1u, sizeof(uint32_t));
+   for (struct WorldMap2Dmap *iterator = sortedMaps, *end = sortedMaps + mapsQuantity; iterator < end; ++iterator)
+   {
+      placeMapInWorldMap2Dcells(iterator, &header, cellSize, cellStarts + 1, NULL, 0u);
+   }
+   for (uint32_t *iterator = cellStarts + 1, *end = cellStarts + cellsQuantity + 1u; iterator < end; ++iterator)
+   {
+      *iterator += *(iterator - 1);
+   }
+   header.cellMapsQuantity = *(cellStarts + cellsQuantity);
+   uint16_t *cellMaps = malloc(header.cellMapsQuantity * sizeof(uint16_t));
+   uint32_t *cellPositions = malloc(cellsQuantity * sizeof(uint32_t));
+   memcpy(cellPositions, cellStarts, cellsQuantity * sizeof(uint32_t));
+   for (struct WorldMap2Dmap *iterator = sortedMaps, *end = sortedMaps + mapsQuantity; iterator < end; ++iterator)
+   {
+      placeMapInWorldMap2Dcells(iterator, &header, cellSize, cellPositions, cellMaps, iterator - sortedMaps);
+   }
+   free(cellPositions);
+   
+   memcpy(header.magic, "C2WI", 4u);
+   header.version = CCE_WORLD_MAP2D_VERSION;
+   header.cellSize = cellSize;
+   header.mapsQuantity = mapsQuantity;
+   uint32_t cellMapsQuantity = header.cellMapsQuantity;
+   header.version = cceHostEndianToLittleEndianInt16(header.version);
+   cceHostEndianToLittleEndianArrayInt64(header.gridOrigin, 2);
+   cceHostEndianToLittleEndianArrayInt32(&(header.cellSize), 6);
+   struct WorldMap2DFileMap *fileMaps = calloc(mapsQuantity, sizeof(struct WorldMap2DFileMap));
+   for (struct WorldMap2DFileMap *iterator = fileMaps, *end = fileMaps + mapsQuantity; iterator < end; ++iterator)
+   {
+      const struct WorldMap2Dmap *map = sortedMaps + (iterator - fileMaps);
+      iterator->ID = cceHostEndianToLittleEndianInt32(map->ID);
+      iterator->coordinates[0] = map->origin.x;
+      iterator->coordinates[1] = map->origin.y;
+      iterator->coordinates[2] = map->boundsMin.x;
+      iterator->coordinates[3] = map->boundsMin.y;
+      iterator->coordinates[4] = map->boundsMax.x;
+      iterator->coordinates[5] = map->boundsMax.y;
+      cceHostEndianToLittleEndianArrayInt64(iterator->coordinates, 6);
+   }
+   cceHostEndianToLittleEndianArrayInt32(cellStarts, cellsQuantity + 1u);
+   cceHostEndianToLittleEndianArrayInt16(cellMaps, cellMapsQuantity);
+   
+   int result = 0;
+   char *worldPath = createWorldMap2Dpath(number);
+   FILE *worldFile = fopen(worldPath, "wb");
+   if (worldFile)
+   {
+      fwrite(&header, sizeof(struct WorldMap2DFileHeader), 1u, worldFile);
+      fwrite(fileMaps, sizeof(struct WorldMap2DFileMap), mapsQuantity, worldFile);
+      fwrite(cellStarts, sizeof(uint32_t), cellsQuantity + 1u, worldFile);
+      fwrite(cellMaps, sizeof(uint16_t), cellMapsQuantity, worldFile);
+      if (fclose(worldFile) == -1)
+      {
+         cce__errorPrint("ENGINE::WORLD_MAP2D_WRITER::FILE_UNEXPECTED_CLOSE:\n%s was unexpectedly closed by external file handler", worldPath);
+         result = -1;
+      }
+   }
+   else
+   {
+      cce__errorPrint("ENGINE::WORLD_MAP2D_WRITER::FAILED_TO_OPEN_FILE:\n%s - cannot open file", worldPath);
+      result = -1;
+   }
+   free(worldPath);
+   free(cellMaps);
+   free(cellStarts);
+   free(fileMaps);
+   free(sortedMaps);
+   return result;
+}
@@ -59,18 +59,85 @@ struct DelayedAction
 
 struct LoadedTextures
 {
-   uint32_t ID; /* 0 is invalid */
+   uint32_t ID; /* Image ID, UINT32_MAX if slot is free or loaded by cceLoadTexture */
    struct cce_u16vec2 size;
    uint8_t  dependantMapsQuantity;
    uint8_t  flags; /* 0x80 - to be loaded, 0x40 - after that point there's no busy LoadedTextures */
+   struct cce_u16vec2 atlasPosition; /* Place of image inside its layer of texture array */
+   uint16_t layer;
+   uint8_t  isOpaque; /* Uploaded image has no translucent texels, elements with it are drawn by opaque pass. 0 until image is uploaded */
 };
 
-#define CCE_LOADEDTEXTURES_TOBELOADED 0x1u
+struct TextureSlotsTableEntry
+{
+   uint32_t key; /* Image ID + 1, 0 is empty entry */
+   uint16_t slot;
+};
+
+/* Textures are kept in up to CCE_TEXTURE_PAGES_MAX texture arrays (pages), page N has CCE_TEXTURE_FIRST_PAGE_LAYERS << N layers
+ * (at most GL_MAX_ARRAY_TEXTURE_LAYERS). Layers of texture atlas go through pages in order. Pages are never copied */
+#define CCE_TEXTURE_PAGES_MAX 8u /* Same as size of Textures in shaders */
+#if !defined(CCE_TEXTURE_FIRST_PAGE_LAYERS)
+#define CCE_TEXTURE_FIRST_PAGE_LAYERS 4u
+#endif
+
+#define CCE_LOADEDTEXTURES_TOBELOADED 0x1u /* Rectangle needs placeholder, texture array may have to grow */
+#define CCE_LOADEDTEXTURES_DECODING   0x2u /* Image is being decoded by texture loader, placeholder is drawn */
+#define CCE_LOADEDTEXTURES_PLACED     0x4u /* atlasPosition and layer are valid */
+#define CCE_LOADEDTEXTURES_EVICTED    0x8u /* Texture is still relied on by maps which aren't drawn, but has no place in texture array */
+
+/* Decoding request of texture loader, becomes its result once data is set (data stays NULL if image failed to decode) */
+struct TextureDecodingJob
+{
+   uint32_t ID;                   /* Image ID, result is dropped if texture slot got other image meanwhile */
+   uint16_t position;             /* Texture slot */
+   const void *file;              /* Packed image, NULL if it is read from path */
+   size_t fileSize;
+   char *path;
+   uint8_t *data;                 /* RGBA8, freed with stbi_image_free unless it is in cacheFile */
+   const uint8_t *cacheFile;      /* Mapped texture cache file data was taken from, NULL if image was decoded */
+   size_t cacheFileSize;
+   int width;
+   int height;
+   const char *failureReason;
+   struct TextureDecodingJob *next;
+};
 
 struct Map2Darray
 {
    struct Map2D *main;
    struct Map2D **dependies;
+   struct cce_i32vec2 *dependiesOffsets; /* MapOffset of every dependant map */
+   uint16_t dependiesQuantity;           /* main->exitMapsQuantity, or maps resident around camera when world index is loaded */
+};
+
+/* World index (world_<n>.c2w). World is divided into grid of cells, every cell lists maps that intersect it */
+struct WorldMap2D
+{
+   struct cce_worldvec2 gridOrigin;
+   struct cce_u32vec2 cellSize;
+   struct cce_u32vec2 gridSize;
+   uint32_t mapsQuantity;
+   struct WorldMap2Dmap *maps; /* Sorted by ID */
+   uint32_t *cellStarts;       /* gridSize.x * gridSize.y + 1 positions in cellMaps, cell (x, y) is cellStarts[y * gridSize.x + x] */
+   uint16_t *cellMaps;         /* Positions in maps */
+};
+
+#define CCE_STREAM_BUFFER_SEGMENTS 3u
+
+#define CCE_UNIFORM_ARRAYS_QUANTITY 4u /* Arrays of Variables uniform block, indexed by CCE_COLORGROUP_OFFSET and others */
+
+/* See stream_buffer.c */
+struct StreamBuffer
+{
+   GLuint     buffer;
+   uint8_t   *mapped; /* NULL if buffer is orphaned instead of being persistently mapped */
+   GLsizeiptr segmentSize;
+   GLintptr   offset; /* Of the data written last */
+   GLintptr   dirtyBegin[CCE_STREAM_BUFFER_SEGMENTS]; /* Changed bytes every segment misses, used by cce__flushStreamBuffer */
+   GLintptr   dirtyEnd[CCE_STREAM_BUFFER_SEGMENTS];
+   uint32_t   writtenFrame;
+   uint8_t    segment;
 };
 
 struct UsedUBO
@@ -80,8 +147,21 @@ struct UsedUBO
    struct cce_i16vec2 *extensionGroupValues;
    uint16_t extensionGroupValuesQuantity;
    float   *rotationAngles;  // Allows incremental rotation
-   uint32_t UBO;
-   uint8_t  flags; /* 0x1 - used, 0x2 - to be cleared; */
+   struct cce_i32vec2 *previousMoveGroupValues; // Move values of the tick before the last one, drawing interpolates from them
+   uint8_t *data;            // Whole uniform block, actions write here and changed groups are streamed to GPU once per frame
+   struct StreamBuffer buffer;
+   uint32_t changedGroups[CCE_UNIFORM_ARRAYS_QUANTITY][8]; /* Bit per group of every uniform array (CCE_*_OFFSET), set since the last upload */
+   uint8_t  changedUniforms; /* Bit per uniform array with changed groups */
+   struct cce_i32vec2 *groupValues; /* CPU copy of GroupValues buffer texture: texel 2i is move value of group i + 1, texel 2i + 1 is its extension */
+   struct StreamBuffer groupValuesBuffer;
+   GLuint   groupValuesTexture;
+   uint16_t groupValuesCapacity;     /* Groups GroupValues has place for, values of groups past it aren't drawn */
+   uint16_t changedGroupValuesBegin; /* Group indices [begin, end) changed since the last upload */
+   uint16_t changedGroupValuesEnd;
+   uint16_t movedGroupsBegin;        /* Group indices [begin, end), which may differ from previousMoveGroupValues */
+   uint16_t movedGroupsEnd;
+   uint8_t  changedGroupValues;      /* CCE_GROUPVALUES_MOVE | CCE_GROUPVALUES_EXTENSION */
+   uint8_t  flags; /* 0x1 - used, 0x2 - to be cleared, 0x4 - reset before base actions, 0x10 - moved by the last logic tick, 0x20 - GPU has interpolated values; */
 };
 
 struct DynamicMap2DElement
@@ -98,8 +178,8 @@ struct DynamicMap2DElement
    uint16_t *collisionGroups;
    uint16_t  collisionGroupsQuantity;
    uint16_t  textureElementReliesOn;
-   uint8_t   visibleMoveGroups[4];
-   uint8_t   visibleExtensionGroups[4];
+   uint16_t  visibleMoveGroups[4];
+   uint16_t  visibleExtensionGroups[4];
    uint8_t   textureOffsetGroups[4]; /* 0 is texture (more precisely - texture piece) unchangeable */
    uint8_t   colorGroups[4];         /* 0 is color unchangable */
    uint8_t   rotateGroup;            /* 0 is unrotatable */
@@ -147,29 +227,60 @@ struct DynamicMap2D
    
    struct list                   delayedActions;
    
+   struct cce_i32vec2 origin; /* position of dynamic map's (0, 0) in current map's coordinates, changed instead of elements on map transitions */
+   
    uint32_t VAO;
-   uint32_t VBO;
+   struct StreamBuffer buffer;
+   struct Map2DElementInstance *instances; /* Changed elements are converted here, then only changed range is streamed to buffer */
    uint32_t objectBufferAllocatedSpace; /* usually equals to elementsQuantityAllocated, or lower */
+   uint32_t dirtyElementsQuantity;
+   uint32_t dirtyElementsQuantityAllocated;
+   uint32_t *dirtyElements; /* IDs of elements with flag 0x4, each one is listed once */
    
 };
 
-struct Map2DElementVertices
+/* One per element, drawn as instance of a quad (corners come from gl_VertexID) */
+struct Map2DElementInstance
 {
-   struct cce_i32vec2 vertexCoords;
    struct cce_i32vec2 position;
-   struct cce_f32vec2  textureCoords;
-   uint8_t moveIDs  [4];
-   uint8_t extendIDs[4];
+   struct cce_u16vec2 size;
+   struct cce_i16vec2 textureOrigin; // Bottom left corner of the piece in the image, y is from the bottom
+   struct cce_u16vec2 textureSize;
+   uint16_t textureID;
    struct
    {
       uint8_t rotateGroupID;
-      uint8_t isGlobalOffset;
+      uint8_t flags; /* CCE_INSTANCE_* */
    } transformGroups;
-   uint16_t textureID;
-   struct cce_f32vec2 textureFragmentSize;
+   uint16_t moveIDs  [4];
+   uint16_t extendIDs[4];
    uint8_t textureOffsetIDs[4];
    uint8_t colorIDs[4];
-}; // 52 bytes
+}; // 48 bytes
+
+#define CCE_INSTANCE_GLOBAL_OFFSET 0x1
+
+#define CCE_MAP2D_TILE_SIZE 16 /* In map units, tiles are ended when elements leave the cell of this size */
+#define CCE_MAP2D_TILE_MIN_ELEMENTS 32u
+#define CCE_MAP2D_TILE_MAX_ELEMENTS 1024u
+
+#define CCE_MAP2D_TILE_MOVED          0x01 /* Bounds are widened by map's move group values when culled */
+#define CCE_MAP2D_TILE_EXTENDED       0x02 /* Bounds are widened by map's extension group values when culled */
+#define CCE_MAP2D_TILE_SCREEN_FIXED   0x04 /* Elements aren't moved by global offset */
+#define CCE_MAP2D_TILE_GLOBAL_OFFSET  0x08
+#define CCE_MAP2D_TILE_ALWAYS_VISIBLE 0x10 /* Rotated elements or both screen-fixed and global offset ones */
+#define CCE_MAP2D_TILE_OPAQUE         0x20 /* Has elements which may be drawn by opaque pass */
+#define CCE_MAP2D_TILE_TRANSLUCENT    0x40 /* Has elements which may be drawn by translucent pass */
+
+/* Consecutive instances of a map, which are culled together. Elements are never reordered, translucent ones are blended in the painter's order */
+struct Map2DTile
+{
+   struct cce_i32vec2 min; /* Bounds of the elements in map's coordinates */
+   struct cce_i32vec2 max;
+   uint32_t first;
+   uint32_t quantity;
+   uint8_t  flags;
+};
 
 struct Map2D
 {
@@ -198,12 +309,15 @@ struct Map2D
    cce_void              *staticActionArgs;
    struct list            delayedActions;
 
-   uint32_t VAO;
-   uint32_t VBO;
+   struct Map2DTile *tiles;
+   uint32_t tilesQuantity;
+   uint32_t instancesFirst; /* Position of map's instances in the instance arena */
    uint16_t temporaryBools;
    uint16_t texturesMapReliesOnQuantity;
    uint16_t ID;
    uint16_t UBO_ID;
+   uint8_t  isTextureEvicted; /* Some of texturesMapReliesOn were evicted, they are loaded again before the map is drawn */
+   uint32_t lastDrawnFrame;
 };
 
 extern void (**cce_actions)(void*);
@@ -211,29 +325,34 @@ extern void (**cce_endianSwapActions)(void*);
 extern struct cce_i32vec2 cce__globalOffset;
 
 void cce__baseActionsInit (struct DynamicMap2D *dynamic_map, struct UsedUBO *UBOs, const GLint *bufferUniformsOffsets,
-                           const GLint *uniformLocations, GLuint shaderProgram, void (*setUniformBufferToDefault)(GLuint, GLint),
+                           const GLint *uniformLocations, GLuint shaderProgram,
                            const GLint *uniformBufferSize, cce_flag *flags);
-void cce__initMap2DLoaders (GLuint *EBO, const cce_flag *flagsPointer);
+void cce__initMap2DLoaders (const cce_flag *flagsPointer);
 void cce__setCurrentArrayOfMaps (const struct Map2Darray *maps);
 void cce__beginBaseActions (struct Map2D *map);
 void cce__endBaseActions (void);
 void cce__endBaseActionsDynamicMap2D (void);
 
-void cce__setAttribPointerVAO (void);
-void cce__elementToMap2DElementVertices (struct Map2DElementVertices *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
-                                         uint8_t *moveGroups, uint8_t moveGroupsQuantity, uint8_t *extensionGroups, uint8_t extensionGroupsQuantity,
+void cce__setAttribPointerVAO (GLintptr offset);
+void cce__elementToMap2DElementInstance (struct Map2DElementInstance *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
+                                         uint16_t *moveGroups, uint8_t moveGroupsQuantity, uint16_t *extensionGroups, uint8_t extensionGroupsQuantity,
                                          uint8_t globalOffset, uint8_t rotationGroup, struct Texture *textureInfo, uint16_t textureID,
                                          uint8_t *textureOffsetGroups, uint8_t textureOffsetGroupsQuantity, uint8_t *colorGroups, uint8_t colorGroupsQuantity);
-void cce__extendElementBufferIfNecessary (uint32_t minimalSize);
+void cce__elementToMap2DElementInstanceSized (struct Map2DElementInstance *buffer, int32_t x, int32_t y, uint16_t width, uint16_t height,
+                                              uint16_t *moveGroups, uint8_t moveGroupsQuantity, uint16_t *extensionGroups, uint8_t extensionGroupsQuantity,
+                                              uint8_t globalOffset, uint8_t rotationGroup, struct Texture *textureInfo, uint16_t textureID,
+                                              struct cce_u16vec2 textureSize,
+                                              uint8_t *textureOffsetGroups, uint8_t textureOffsetGroupsQuantity, uint8_t *colorGroups, uint8_t colorGroupsQuantity);
+#define cce__drawInstancesMap2D(quantity) glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (quantity))
 
 
-#define cce__map2DElementToMap2DElementVertices(buffer, element, moveGroups, extensionGroups, globalOffset) \
-cce__elementToMap2DElementVertices(buffer, (element)->x, (element)->y, (element)->width, (element)->height, \
+#define cce__map2DElementToMap2DElementInstance(buffer, element, moveGroups, extensionGroups, globalOffset) \
+cce__elementToMap2DElementInstance(buffer, (element)->x, (element)->y, (element)->width, (element)->height, \
 moveGroups, 4, extensionGroups, 4, globalOffset, (element)->rotateGroup, &((element)->textureInfo), (element)->textureInfo.ID, \
 (element)->textureOffsetGroups, 4, (element)->colorGroups, 4)
 
-#define cce__dynamicMap2DElementToMap2DElementVertices(buffer, element) \
-cce__elementToMap2DElementVertices(buffer, (element)->x, (element)->y, (element)->width, (element)->height, \
+#define cce__dynamicMap2DElementToMap2DElementInstance(buffer, element) \
+cce__elementToMap2DElementInstance(buffer, (element)->x, (element)->y, (element)->width, (element)->height, \
 (element)->visibleMoveGroups, 4, (element)->visibleExtensionGroups, 4, \
 ((element)->flags & CCE_GLOBAL_OFFSET_MASK) > 0, (element)->rotateGroup, &((element)->textureInfo), (element)->textureElementReliesOn, \
 (element)->textureOffsetGroups, 4, (element)->colorGroups, 4)
@@ -250,6 +369,7 @@ cce_ubyte cce__checkCollisionDynamicMap2DmultipleMaps (uint16_t ID, struct Map2D
 uint16_t cce__loadTexture (uint32_t ID);
 void cce__processDynamicMap2DElements (void);
 uint16_t* cce__loadTexturesMap2D (struct Map2DElement *elements, uint32_t elementsQuantity, uint16_t *texturesLoadedMapReliesOnQuantity);
+uint16_t* cce__loadTexturesListMap2D (const uint32_t *textureIDs, uint16_t texturesQuantity);
 void cce__releaseTextures (uint16_t *texturesMapReliesOn, uint16_t texturesMapReliesOnQuantity);
 void cce__releaseTexture (uint16_t textureID);
 void cce__initLogicMap2D (struct Map2D *map);
@@ -258,11 +378,54 @@ void cce__releaseUBO (uint16_t ID);
 void cce__releaseUnusedUBO (uint16_t ID);
 void cce__allocateUBObuffers (uint16_t uboID, uint16_t moveGroupsQuantity, uint16_t extensionGroupsQuantity);
 struct UsedUBO* cce__getFreeUBOdata (uint16_t ID);
-struct DynamicMap2D* cce__initDynamicMap2D (GLuint EBO);
+void cce__setUBOtoDefault (struct UsedUBO *ubo);
+void cce__uploadUBO (struct UsedUBO *ubo);
+void cce__setGroupChangedUBO (struct UsedUBO *ubo, uint8_t uniform, uint16_t groupIndex);
+uint8_t cce__isGroupChangedUBO (const struct UsedUBO *ubo, uint8_t uniform, uint16_t groupIndex);
+void cce__uploadChangedUBO (struct UsedUBO *ubo);
+void cce__resizeGroupValuesUBO (struct UsedUBO *ubo);
+void cce__setGroupValueChangedUBO (struct UsedUBO *ubo, uint8_t kind, uint16_t groupIndex);
+void cce__uploadChangedGroupValuesUBO (struct UsedUBO *ubo);
+struct DynamicMap2D* cce__initDynamicMap2D (void);
 uint8_t cce__getDynamicElementFlags (uint16_t ID);
 void cce__setToBeProcessedDynamicMap2D (void);
+void cce__rebaseDynamicMap2D (void);
 void cce__terminateDynamicMap2D (void);
 void cce__terminateEngine2D (void);
+void cce__initInstanceArena (void);
+void cce__terminateInstanceArena (void);
+uint32_t cce__allocateInstanceArena (const struct Map2DElementInstance *instances, uint32_t quantity);
+void cce__freeInstanceArena (uint32_t first, uint32_t quantity);
+void cce__bindInstanceArena (void);
+void cce__pointInstanceArena (uint32_t first);
+
+void cce__initStreamBuffers (void);
+void cce__terminateStreamBuffers (void);
+void cce__createStreamBuffer (struct StreamBuffer *stream, GLenum target, GLsizeiptr size);
+void cce__deleteStreamBuffer (struct StreamBuffer *stream);
+GLintptr cce__writeStreamBuffer (struct StreamBuffer *stream, GLenum target, const void *data, GLsizeiptr size);
+void cce__invalidateStreamBufferRange (struct StreamBuffer *stream, GLintptr begin, GLintptr end);
+GLintptr cce__flushStreamBuffer (struct StreamBuffer *stream, GLenum target, const void *data);
+void cce__endFrameStreamBuffers (void);
+void cce__initTextureAtlas (struct cce_u32vec2 layerSize, uint16_t maxLayersQuantity);
+void cce__terminateTextureAtlas (void);
+int cce__allocateTextureAtlasRectangle (struct cce_u16vec2 size, struct cce_u16vec2 *position, uint16_t *layer);
+int cce__allocateTextureAtlasRectangleBefore (struct cce_u16vec2 size, uint16_t layersLimit, struct cce_u16vec2 *position, uint16_t *layer);
+void cce__releaseTextureAtlasRectangle (uint16_t layer);
+uint16_t cce__getTextureAtlasLayersQuantity (void);
+
+void cce__initTextureLoader (void);
+void cce__terminateTextureLoader (void);
+void cce__requestTextureDecoding (uint32_t ID, uint16_t position, const void *file, size_t fileSize, const char *path);
+struct TextureDecodingJob* cce__getDecodedTexture (void);
+void cce__freeDecodedTexture (struct TextureDecodingJob *job);
+int  cce__readTextureCache (struct TextureDecodingJob *job);
+void cce__writeTextureCache (const struct TextureDecodingJob *job);
+void cce__terminateTextureCache (void);
+int  cce__getImageInfo (uint32_t ID, const char *path, int *width, int *height, int *channels);
+void cce__forgetImageInfo (uint32_t ID);
+struct WorldMap2D* cce__loadWorldMap2D (uint16_t number);
+void cce__freeWorldMap2D (struct WorldMap2D *world);
 
 /* Action is a function: void action (void *ptr) */
 #define cce__processLogicMap2D(map) if ((map)->logicQuantity) cce__setCurrentTemporaryBools((map)->temporaryBools); \
@@ -275,13 +438,28 @@ cce__endBaseActions(); \
 cce__endBaseActionsDynamicMap2D()
 
 #define CCE_COLORGROUP_OFFSET 0u
-#define CCE_MOVEGROUP_OFFSET 1u
-#define CCE_EXTENSIONGROUP_OFFSET 2u
-#define CCE_TEXTUREOFFSET_OFFSET 3u
-#define CCE_ROTATIONOFFSET_OFFSET 4u
-#define CCE_ROTATEANGLESINCOS_OFFSET 5u
+#define CCE_TEXTUREOFFSET_OFFSET 1u
+#define CCE_ROTATIONOFFSET_OFFSET 2u
+#define CCE_ROTATEANGLESINCOS_OFFSET 3u
 
 #define CCE_GLOBALOFFSET_OFFSET 1u
+#define CCE_MAPOFFSET_OFFSET 2u
+#define CCE_PASS_OFFSET 3u
+#define CCE_ORDEROFFSET_OFFSET 4u
+#define CCE_GROUPVALUESOFFSET_OFFSET 5u
+#define CCE_GROUPVALUESQUANTITY_OFFSET 6u
+
+/* Move and extension values are in GroupValues buffer texture instead of the uniform block. Every segment of its stream buffer has a copy,
+ * so groups are limited by GL_MAX_TEXTURE_BUFFER_SIZE / (2 * CCE_STREAM_BUFFER_SEGMENTS) - 32 (about 10900 with minimal 65536 texels), up to 65535 */
+#define CCE_GROUPVALUES_MOVE      0x1u
+#define CCE_GROUPVALUES_EXTENSION 0x2u
+#define CCE_GROUPVALUES_TEXTURE_UNIT (CCE_TEXTURE_PAGES_MAX + 1u) /* Texture unit after TextureRectangles */
+
+#define CCE_MAX_LOGIC_TICKS_PER_FRAME 8u /* Slower frames make logic slow down instead of spending even more time on ticks */
+
+#define CCE_DRAW_ALL_ELEMENTS 0 /* Values of Pass uniform */
+#define CCE_DRAW_OPAQUE       1
+#define CCE_DRAW_TRANSLUCENT  2
 
 #ifdef __cplusplus
 }
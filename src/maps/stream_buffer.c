@@ -0,0 +1,199 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../../include/coffeechain/engine_common.h"
+#include "map2D_internal.h"
+
+/* Buffers written by CPU every frame. With ARB_buffer_storage they are persistently mapped and have CCE_STREAM_BUFFER_SEGMENTS segments,
+ * one is written while GPU may still read others, fences make sure frame CCE_STREAM_BUFFER_SEGMENTS frames ago is finished.
+ * On plain OpenGL 3.3 buffer is orphaned by glBufferData(NULL) before every write instead, so driver gives new storage without waiting */
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#define CCE_STREAM_BUFFER_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+static GLsync   g_fences[CCE_STREAM_BUFFER_SEGMENTS];
+static uint32_t g_streamFrame;
+static uint8_t  g_isFenceWaited;
+static GLint    g_segmentAlignment;
+
+void cce__initStreamBuffers (void)
+{
+   glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &g_segmentAlignment);
+   GL_CHECK_ERRORS;
+   if (g_segmentAlignment < 64)
+      g_segmentAlignment = 64;
+   memset(g_fences, 0, sizeof(g_fences));
+   g_streamFrame = 1u;
+   g_isFenceWaited = 0u;
+}
+
+void cce__terminateStreamBuffers (void)
+{
+   for (GLsync *iterator = g_fences, *end = g_fences + CCE_STREAM_BUFFER_SEGMENTS; iterator < end; ++iterator)
+   {
+      if (*iterator)
+         glDeleteSync(*iterator);
+      *iterator = NULL;
+   }
+}
+
+/* Leaves buffer bound to target */
+void cce__createStreamBuffer (struct StreamBuffer *stream, GLenum target, GLsizeiptr size)
+{
+   stream->segmentSize = (size + g_segmentAlignment - 1) / g_segmentAlignment * g_segmentAlignment;
+   stream->offset = 0;
+   memset(stream->dirtyBegin, 0, sizeof(stream->dirtyBegin));
+   memset(stream->dirtyEnd,   0, sizeof(stream->dirtyEnd));
+   stream->writtenFrame = 0u;
+   stream->segment = 0u;
+   stream->mapped = NULL;
+   glGenBuffers(1, &(stream->buffer));
+   GL_CHECK_ERRORS;
+   glBindBuffer(target, stream->buffer);
+   GL_CHECK_ERRORS;
+   if (cce__glBufferStorage)
+   {
+      cce__glBufferStorage(target, stream->segmentSize * CCE_STREAM_BUFFER_SEGMENTS, NULL, CCE_STREAM_BUFFER_FLAGS);
+      GL_CHECK_ERRORS;
+      stream->mapped = glMapBufferRange(target, 0, stream->segmentSize * CCE_STREAM_BUFFER_SEGMENTS, CCE_STREAM_BUFFER_FLAGS);
+      GL_CHECK_ERRORS;
+   }
+   else
+   {
+      glBufferData(target, stream->segmentSize, NULL, GL_STREAM_DRAW);
+      GL_CHECK_ERRORS;
+   }
+}
+
+void cce__deleteStreamBuffer (struct StreamBuffer *stream)
+{
+   glDeleteBuffers(1, &(stream->buffer)); // Mapping goes with the buffer
+   GL_CHECK_ERRORS;
+   stream->buffer = 0u;
+   stream->mapped = NULL;
+}
+
+static void waitStreamFence (void)
+{
+   g_isFenceWaited = 1u;
+   GLsync *fence = g_fences + g_streamFrame % CCE_STREAM_BUFFER_SEGMENTS;
+   if (!*fence)
+      return;
+   while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u) == GL_TIMEOUT_EXPIRED);
+   glDeleteSync(*fence);
+   *fence = NULL;
+}
+
+/* Segment changes at most once per frame: segment written this frame isn't read by GPU before frame's draw calls, so it can be written again */
+static void selectStreamSegment (struct StreamBuffer *stream)
+{
+   if (!g_isFenceWaited)
+      waitStreamFence();
+   if (stream->writtenFrame != g_streamFrame)
+   {
+      stream->segment = (stream->segment + 1u) % CCE_STREAM_BUFFER_SEGMENTS;
+      stream->writtenFrame = g_streamFrame;
+   }
+   stream->offset = stream->segment * stream->segmentSize;
+}
+
+/* Returns offset of data in the buffer, which has to be used for drawing until the next write */
+GLintptr cce__writeStreamBuffer (struct StreamBuffer *stream, GLenum target, const void *data, GLsizeiptr size)
+{
+   if (!stream->mapped)
+   {
+      glBindBuffer(target, stream->buffer);
+      GL_CHECK_ERRORS;
+      glBufferData(target, stream->segmentSize, NULL, GL_STREAM_DRAW);
+      GL_CHECK_ERRORS;
+      glBufferSubData(target, 0, size, data);
+      GL_CHECK_ERRORS;
+      return stream->offset = 0;
+   }
+   selectStreamSegment(stream);
+   memcpy(stream->mapped + stream->offset, data, size);
+   return stream->offset;
+}
+
+/* Marks bytes [begin, end) of CPU copy as changed, every segment gets them with its next cce__flushStreamBuffer.
+ * Changes are coalesced into one range per segment, as copying bytes between them costs less than extra calls */
+void cce__invalidateStreamBufferRange (struct StreamBuffer *stream, GLintptr begin, GLintptr end)
+{
+   for (uint8_t i = 0u; i < CCE_STREAM_BUFFER_SEGMENTS; ++i)
+   {
+      if (stream->dirtyBegin[i] >= stream->dirtyEnd[i])
+      {
+         stream->dirtyBegin[i] = begin;
+         stream->dirtyEnd[i]   = end;
+         continue;
+      }
+      if (begin < stream->dirtyBegin[i])
+         stream->dirtyBegin[i] = begin;
+      if (end > stream->dirtyEnd[i])
+         stream->dirtyEnd[i] = end;
+   }
+}
+
+/* Uploads only invalidated ranges of data, which is CPU copy of the whole buffer. Returns offset like cce__writeStreamBuffer.
+ * Current segment has nothing invalidated only if nothing changed since the last flush, then nothing is uploaded */
+GLintptr cce__flushStreamBuffer (struct StreamBuffer *stream, GLenum target, const void *data)
+{
+   if (stream->dirtyBegin[stream->segment] >= stream->dirtyEnd[stream->segment])
+      return stream->offset;
+   
+   if (!stream->mapped)
+   {
+      glBindBuffer(target, stream->buffer);
+      GL_CHECK_ERRORS;
+      glBufferSubData(target, stream->dirtyBegin[0], stream->dirtyEnd[0] - stream->dirtyBegin[0], ((const uint8_t*) data) + stream->dirtyBegin[0]);
+      GL_CHECK_ERRORS;
+      memset(stream->dirtyBegin, 0, sizeof(stream->dirtyBegin));
+      memset(stream->dirtyEnd,   0, sizeof(stream->dirtyEnd));
+      return stream->offset = 0;
+   }
+   selectStreamSegment(stream);
+   GLintptr begin = stream->dirtyBegin[stream->segment], end = stream->dirtyEnd[stream->segment];
+   if (begin < end)
+      memcpy(stream->mapped + stream->offset + begin, ((const uint8_t*) data) + begin, end - begin);
+   stream->dirtyBegin[stream->segment] = stream->dirtyEnd[stream->segment] = 0;
+   return stream->offset;
+}
+
+/* Called after the last draw call of the frame */
+void cce__endFrameStreamBuffers (void)
+{
+   if (!cce__glBufferStorage)
+      return;
+   GLsync *fence = g_fences + g_streamFrame % CCE_STREAM_BUFFER_SEGMENTS;
+   if (*fence)
+      glDeleteSync(*fence);
+   *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   GL_CHECK_ERRORS;
+   ++g_streamFrame;
+   g_isFenceWaited = 0u;
+}
@@ -0,0 +1,209 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../../include/coffeechain/engine_common.h"
+#include "../../include/coffeechain/utils.h"
+#include "map2D_internal.h"
+
+/* Skyline packer: every layer of texture array keeps its top outline as segments sorted by x, images are put at the lowest place they fit.
+ * Space of a released image isn't reused until all images of its layer are released, then layer starts from scratch */
+
+struct SkylineSegment
+{
+   uint32_t x;
+   uint32_t y;
+   uint32_t width;
+};
+
+struct TextureAtlasLayer
+{
+   struct SkylineSegment *segments;
+   uint32_t segmentsQuantity;
+   uint32_t segmentsQuantityAllocated;
+   uint32_t texturesQuantity;
+};
+
+static struct TextureAtlasLayer *g_layers = NULL;
+static uint16_t g_layersQuantity = 0u;
+static uint16_t g_layersQuantityAllocated = 0u;
+static uint16_t g_maxLayersQuantity;
+static struct cce_u32vec2 g_layerSize;
+
+static void resetTextureAtlasLayer (struct TextureAtlasLayer *layer)
+{
+   layer->segmentsQuantity = 1u;
+   *(layer->segments) = (struct SkylineSegment) {0u, 0u, g_layerSize.x};
+   layer->texturesQuantity = 0u;
+}
+
+void cce__initTextureAtlas (struct cce_u32vec2 layerSize, uint16_t maxLayersQuantity)
+{
+   g_layerSize = layerSize;
+   g_maxLayersQuantity = maxLayersQuantity;
+   g_layersQuantity = 0u;
+}
+
+void cce__terminateTextureAtlas (void)
+{
+   for (struct TextureAtlasLayer *iterator = g_layers, *end = g_layers + g_layersQuantityAllocated; iterator < end; ++iterator)
+   {
+      free(iterator->segments);
+   }
+   free(g_layers);
+   g_layers = NULL;
+   g_layersQuantity = g_layersQuantityAllocated = 0u;
+}
+
+/* Returns y of the lowest place for width at segment, or UINT32_MAX if it doesn't fit there */
+static uint32_t fitSkylineSegment (const struct TextureAtlasLayer *layer, uint32_t segment, uint32_t width, uint32_t height)
+{
+   const struct SkylineSegment *iterator = layer->segments + segment, *end = layer->segments + layer->segmentsQuantity;
+   if (iterator->x + width > g_layerSize.x)
+      return UINT32_MAX;
+   uint32_t y = 0u;
+   for (uint32_t coveredWidth = 0u; coveredWidth < width && iterator < end; coveredWidth += iterator->width, ++iterator)
+   {
+      y = (iterator->y > y) ? iterator->y : y;
+   }
+   return (y + height <= g_layerSize.y) ? y : UINT32_MAX;
+}
+
+static void addSkylineSegment (struct TextureAtlasLayer *layer, uint32_t segment, uint32_t x, uint32_t y, uint32_t width)
+{
+   if (layer->segmentsQuantity >= layer->segmentsQuantityAllocated)
+   {
+      layer->segmentsQuantityAllocated += CCE_ALLOCATION_STEP;
+      layer->segments = realloc(layer->segments, layer->segmentsQuantityAllocated * sizeof(struct SkylineSegment));
+   }
+   struct SkylineSegment *segments = layer->segments;
+   memmove(segments + segment + 1u, segments + segment, (layer->segmentsQuantity - segment) * sizeof(struct SkylineSegment));
+   *(segments + segment) = (struct SkylineSegment) {x, y, width};
+   ++(layer->segmentsQuantity);
+   
+   // Segments under the new one are cut off or removed
+   uint32_t end = x + width, next = segment + 1u;
+   while (next < layer->segmentsQuantity && (segments + next)->x < end)
+   {
+      uint32_t overlap = end - (segments + next)->x;
+      if ((segments + next)->width > overlap)
+      {
+         (segments + next)->x += overlap;
+         (segments + next)->width -= overlap;
+         break;
+      }
+      memmove(segments + next, segments + next + 1u, (layer->segmentsQuantity - next - 1u) * sizeof(struct SkylineSegment));
+      --(layer->segmentsQuantity);
+   }
+   
+   for (uint32_t i = 0u; i + 1u < layer->segmentsQuantity;)
+   {
+      if ((segments + i)->y == (segments + i + 1u)->y)
+      {
+         (segments + i)->width += (segments + i + 1u)->width;
+         memmove(segments + i + 1u, segments + i + 2u, (layer->segmentsQuantity - i - 2u) * sizeof(struct SkylineSegment));
+         --(layer->segmentsQuantity);
+      }
+      else
+      {
+         ++i;
+      }
+   }
+}
+
+/* Returns 0 if there's a place for size in an existing layer */
+static int placeInTextureAtlasLayer (struct TextureAtlasLayer *layer, struct cce_u16vec2 size, struct cce_u16vec2 *position)
+{
+   uint32_t bestSegment = UINT32_MAX, bestY = UINT32_MAX;
+   for (uint32_t i = 0u; i < layer->segmentsQuantity; ++i)
+   {
+      uint32_t y = fitSkylineSegment(layer, i, size.x, size.y);
+      if (y < bestY)
+      {
+         bestY = y;
+         bestSegment = i;
+      }
+   }
+   if (bestSegment == UINT32_MAX)
+      return -1;
+   
+   uint32_t x = (layer->segments + bestSegment)->x;
+   addSkylineSegment(layer, bestSegment, x, bestY + size.y, size.x);
+   *position = (struct cce_u16vec2) {x, bestY};
+   ++(layer->texturesQuantity);
+   return 0;
+}
+
+/* Returns -1 if size doesn't fit into a layer at all or all layers are full. New layers are added on demand, so texture array may have to grow after it */
+int cce__allocateTextureAtlasRectangle (struct cce_u16vec2 size, struct cce_u16vec2 *position, uint16_t *layer)
+{
+   return cce__allocateTextureAtlasRectangleBefore(size, g_maxLayersQuantity, position, layer);
+}
+
+/* Same, but rectangle is placed only in layers before layersLimit */
+int cce__allocateTextureAtlasRectangleBefore (struct cce_u16vec2 size, uint16_t layersLimit, struct cce_u16vec2 *position, uint16_t *layer)
+{
+   if (size.x > g_layerSize.x || size.y > g_layerSize.y)
+      return -1;
+   for (struct TextureAtlasLayer *iterator = g_layers, *end = g_layers + MIN(g_layersQuantity, layersLimit); iterator < end; ++iterator)
+   {
+      if (placeInTextureAtlasLayer(iterator, size, position) == 0)
+      {
+         *layer = iterator - g_layers;
+         return 0;
+      }
+   }
+   if (g_layersQuantity >= MIN(g_maxLayersQuantity, layersLimit))
+      return -1;
+   if (g_layersQuantity >= g_layersQuantityAllocated)
+   {
+      g_layers = realloc(g_layers, (g_layersQuantityAllocated + CCE_ALLOCATION_STEP) * sizeof(struct TextureAtlasLayer));
+      for (struct TextureAtlasLayer *iterator = g_layers + g_layersQuantityAllocated, *end = iterator + CCE_ALLOCATION_STEP; iterator < end; ++iterator)
+      {
+         iterator->segments = malloc(CCE_ALLOCATION_STEP * sizeof(struct SkylineSegment));
+         iterator->segmentsQuantityAllocated = CCE_ALLOCATION_STEP;
+      }
+      g_layersQuantityAllocated += CCE_ALLOCATION_STEP;
+   }
+   struct TextureAtlasLayer *newLayer = g_layers + g_layersQuantity;
+   resetTextureAtlasLayer(newLayer);
+   placeInTextureAtlasLayer(newLayer, size, position);
+   *layer = g_layersQuantity++;
+   return 0;
+}
+
+void cce__releaseTextureAtlasRectangle (uint16_t layer)
+{
+   struct TextureAtlasLayer *atlasLayer = g_layers + layer;
+   if (--(atlasLayer->texturesQuantity) > 0u)
+      return;
+   resetTextureAtlasLayer(atlasLayer);
+   while (g_layersQuantity > 0u && (g_layers + g_layersQuantity - 1u)->texturesQuantity == 0u)
+      --g_layersQuantity;
+}
+
+/* Layers after this one are empty */
+uint16_t cce__getTextureAtlasLayersQuantity (void)
+{
+   return g_layersQuantity;
+}
@@ -0,0 +1,370 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../../include/coffeechain/engine_common.h"
+#include "../../include/coffeechain/utils.h"
+#include "../../include/coffeechain/os_interaction.h"
+#include "../../include/coffeechain/map2D/map2D.h"
+#include "../external/stb_image.h"
+#include "../platform/files.h"
+#include "map2D_internal.h"
+
+/* Decoded images are kept in <app data>/<folderName>/texture_cache/<image ID>.c2t, so PNGs aren't decoded again next session.
+ * File is valid while size and modification time of the image (or checksum of packed image) are the same. Used from decoding threads */
+#define CCE_TEXTURE_CACHE_VERSION 1u
+#define CCE_TEXTURE_CACHE_NAME_SIZE 32u
+
+struct TextureCacheHeader
+{
+   char     magic[4]; /* "C2TC" */
+   uint16_t version;
+   uint16_t reserved;
+   uint32_t width;
+   uint32_t height;
+   uint64_t sourceSize;
+   uint64_t sourceStamp;
+}; // 32 bytes, followed by width * height RGBA8 texels as they are uploaded. Host endianess, cache isn't meant to be moved
+
+static char  *g_cachePath = NULL;
+static size_t g_cachePathLength;
+
+/* Sizes of loose images by ID, so attributes of textures are known without opening images. Persisted to <cache>/images.c2i.
+ * Entries read from disk are checked against size and modification time of the image once per session. Used from main thread only */
+#define CCE_IMAGE_INFO_VERSION 1u
+#define CCE_IMAGE_INFO_USED    0x1u
+#define CCE_IMAGE_INFO_CHECKED 0x2u
+
+struct ImageInfo
+{
+   uint32_t ID;
+   uint16_t width;
+   uint16_t height;
+   uint8_t  channels;
+   uint8_t  flags;
+   uint16_t reserved;
+   uint32_t reserved2;
+   uint64_t sourceSize;
+   uint64_t sourceStamp;
+}; // 32 bytes, entries of images.c2i are stored as is after 16 bytes header (flags are 0 there)
+
+static struct ImageInfo *g_imageInfos = NULL;
+static uint32_t g_imageInfosQuantity = 0u;
+static uint8_t  g_imageInfosAllocatedLog2 = 0u;
+static uint8_t  g_isImageInfosLoaded = 0u, g_isImageInfosChanged = 0u;
+
+static void saveImageInfos (void);
+static void freeImageInfos (void);
+
+/* folderName is folder of the game in app data directory, NULL turns cache off. Has to be called before cceInitEngine2D */
+CCE_PUBLIC_OPTIONS int cceSetTextureCache (const char *folderName)
+{
+   cce__terminateTextureCache();
+   if (!folderName)
+      return 0;
+   char *path = cceGetAppDataPath(folderName, 16u + CCE_TEXTURE_CACHE_NAME_SIZE);
+   if (!path)
+      return -1;
+   size_t pathLength = strlen(path);
+   cceAppendPath(path, pathLength + 16u + CCE_TEXTURE_CACHE_NAME_SIZE, "texture_cache");
+   if (!cceGetDirectory(path, pathLength + 16u + CCE_TEXTURE_CACHE_NAME_SIZE))
+   {
+      free(path);
+      return -1;
+   }
+   g_cachePathLength = strlen(path);
+   cceAppendPath(path, g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE, "");
+   g_cachePathLength = strlen(path);
+   g_cachePath = path;
+   return 0;
+}
+
+void cce__terminateTextureCache (void)
+{
+   saveImageInfos();
+   freeImageInfos();
+   free(g_cachePath);
+   g_cachePath = NULL;
+}
+
+/* Packed images have no modification time, their checksum is used instead */
+static int getTextureSourceKey (const struct TextureDecodingJob *job, uint64_t *size, uint64_t *stamp)
+{
+   if (job->file)
+   {
+      *size = job->fileSize;
+      *stamp = cceHash64(job->file, job->fileSize, 0u);
+      return 0;
+   }
+   return cce__getFileStamp(job->path, size, stamp);
+}
+
+/* path must have g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE bytes */
+static void getTextureCachePath (char *path, uint32_t ID, const char *extension)
+{
+   memcpy(path, g_cachePath, g_cachePathLength);
+   snprintf(path + g_cachePathLength, CCE_TEXTURE_CACHE_NAME_SIZE, "%u%s", ID, extension);
+}
+
+/* Returns 0 and sets data of job to mapped texels if cache of the image is valid */
+int cce__readTextureCache (struct TextureDecodingJob *job)
+{
+   if (!g_cachePath)
+      return -1;
+   uint64_t sourceSize, sourceStamp;
+   if (getTextureSourceKey(job, &sourceSize, &sourceStamp) != 0)
+      return -1;
+   char *path = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   getTextureCachePath(path, job->ID, ".c2t");
+   size_t fileSize;
+   const uint8_t *file = cce__mapFile(path, &fileSize);
+   free(path);
+   if (!file)
+      return -1;
+   
+   struct TextureCacheHeader header;
+   if (fileSize >= sizeof(struct TextureCacheHeader))
+      memcpy(&header, file, sizeof(struct TextureCacheHeader));
+   if (fileSize < sizeof(struct TextureCacheHeader) || memcmp(header.magic, "C2TC", 4u) != 0 || header.version != CCE_TEXTURE_CACHE_VERSION ||
+       header.sourceSize != sourceSize || header.sourceStamp != sourceStamp || header.width == 0u || header.height == 0u ||
+       header.width > UINT16_MAX || header.height > UINT16_MAX ||
+       (fileSize - sizeof(struct TextureCacheHeader)) / 4u / header.width < header.height)
+   {
+      cce__unmapFile(file, fileSize);
+      return -1;
+   }
+   job->cacheFile = file;
+   job->cacheFileSize = fileSize;
+   job->data = (uint8_t*) (file + sizeof(struct TextureCacheHeader));
+   job->width = header.width;
+   job->height = header.height;
+   return 0;
+}
+
+/* Written to temporary file first, so other process (or decoding thread) never maps half-written file. Failures only mean no cache */
+void cce__writeTextureCache (const struct TextureDecodingJob *job)
+{
+   if (!g_cachePath || !job->data)
+      return;
+   struct TextureCacheHeader header;
+   memcpy(header.magic, "C2TC", 4u);
+   header.version = CCE_TEXTURE_CACHE_VERSION;
+   header.reserved = 0u;
+   header.width = job->width;
+   header.height = job->height;
+   if (getTextureSourceKey(job, &(header.sourceSize), &(header.sourceStamp)) != 0)
+      return;
+   
+   char *path = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   char *temporaryPath = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   getTextureCachePath(path, job->ID, ".c2t");
+   char extension[CCE_TEXTURE_CACHE_NAME_SIZE - 10u];
+   snprintf(extension, sizeof(extension), ".%lx.tmp", (unsigned long) (uintptr_t) job);
+   getTextureCachePath(temporaryPath, job->ID, extension);
+   FILE *file = fopen(temporaryPath, "wb");
+   if (file)
+   {
+      size_t dataSize = (size_t) job->width * job->height * 4u;
+      int isWritten = (fwrite(&header, sizeof(struct TextureCacheHeader), 1u, file) == 1u) && (fwrite(job->data, 1u, dataSize, file) == dataSize);
+      isWritten = (fclose(file) == 0) && isWritten;
+      if (!isWritten || cce__replaceFile(temporaryPath, path) != 0)
+         remove(temporaryPath);
+   }
+   free(temporaryPath);
+   free(path);
+}
+
+static inline uint32_t hashImageID (uint32_t ID)
+{
+   return (ID * 0x9E3779B1u) >> (32u - g_imageInfosAllocatedLog2);
+}
+
+/* Returns entry of ID or empty entry, where it has to be inserted */
+static struct ImageInfo* findImageInfo (uint32_t ID)
+{
+   uint32_t mask = (1u << g_imageInfosAllocatedLog2) - 1u;
+   for (uint32_t i = hashImageID(ID);; i = (i + 1u) & mask)
+   {
+      if (!((g_imageInfos + i)->flags & CCE_IMAGE_INFO_USED) || (g_imageInfos + i)->ID == ID)
+         return g_imageInfos + i;
+   }
+}
+
+/* Table is never more than half full */
+static struct ImageInfo* insertImageInfo (uint32_t ID)
+{
+   if ((g_imageInfosQuantity + 1u) * 2u > (1u << g_imageInfosAllocatedLog2))
+   {
+      struct ImageInfo *oldInfos = g_imageInfos;
+      uint32_t oldAllocated = g_imageInfosAllocatedLog2 ? (1u << g_imageInfosAllocatedLog2) : 0u;
+      g_imageInfosAllocatedLog2 = g_imageInfosAllocatedLog2 ? g_imageInfosAllocatedLog2 + 1u : 6u;
+      g_imageInfos = calloc(1u << g_imageInfosAllocatedLog2, sizeof(struct ImageInfo));
+      for (struct ImageInfo *iterator = oldInfos, *end = oldInfos + oldAllocated; iterator < end; ++iterator)
+      {
+         if (iterator->flags & CCE_IMAGE_INFO_USED)
+            *findImageInfo(iterator->ID) = *iterator;
+      }
+      free(oldInfos);
+   }
+   struct ImageInfo *info = findImageInfo(ID);
+   if (!(info->flags & CCE_IMAGE_INFO_USED))
+   {
+      memset(info, 0, sizeof(struct ImageInfo));
+      info->ID = ID;
+      info->flags = CCE_IMAGE_INFO_USED;
+      ++g_imageInfosQuantity;
+   }
+   return info;
+}
+
+/* path must have g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE bytes */
+static void getImageInfosPath (char *path)
+{
+   memcpy(path, g_cachePath, g_cachePathLength);
+   memcpy(path + g_cachePathLength, "images.c2i", sizeof("images.c2i"));
+}
+
+static void loadImageInfos (void)
+{
+   g_isImageInfosLoaded = 1u;
+   if (!g_cachePath)
+      return;
+   char *path = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   getImageInfosPath(path);
+   size_t fileSize;
+   const uint8_t *file = cce__mapFile(path, &fileSize);
+   free(path);
+   if (!file)
+      return;
+   
+   uint16_t version;
+   uint32_t infosQuantity;
+   if (fileSize >= 16u)
+   {
+      memcpy(&version, file + 4u, sizeof(uint16_t));
+      memcpy(&infosQuantity, file + 8u, sizeof(uint32_t));
+   }
+   if (fileSize >= 16u && memcmp(file, "C2II", 4u) == 0 && version == CCE_IMAGE_INFO_VERSION && (fileSize - 16u) / sizeof(struct ImageInfo) >= infosQuantity)
+   {
+      for (const uint8_t *iterator = file + 16u, *end = file + 16u + (size_t) infosQuantity * sizeof(struct ImageInfo); iterator < end; iterator += sizeof(struct ImageInfo))
+      {
+         struct ImageInfo info;
+         memcpy(&info, iterator, sizeof(struct ImageInfo));
+         struct ImageInfo *entry = insertImageInfo(info.ID);
+         *entry = info;
+         entry->flags = CCE_IMAGE_INFO_USED;
+      }
+   }
+   cce__unmapFile(file, fileSize);
+}
+
+/* Written like texture cache, through temporary file. Failures only mean images are probed again next session */
+static void saveImageInfos (void)
+{
+   if (!g_cachePath || !g_isImageInfosChanged)
+      return;
+   g_isImageInfosChanged = 0u;
+   char *path = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   char *temporaryPath = malloc(g_cachePathLength + CCE_TEXTURE_CACHE_NAME_SIZE);
+   getImageInfosPath(path);
+   getTextureCachePath(temporaryPath, 0u, ".c2i.tmp");
+   FILE *file = fopen(temporaryPath, "wb");
+   if (file)
+   {
+      uint8_t header[16] = {'C', '2', 'I', 'I'};
+      uint16_t version = CCE_IMAGE_INFO_VERSION;
+      memcpy(header + 4u, &version, sizeof(uint16_t));
+      memcpy(header + 8u, &g_imageInfosQuantity, sizeof(uint32_t));
+      int isWritten = (fwrite(header, sizeof(header), 1u, file) == 1u);
+      for (struct ImageInfo *iterator = g_imageInfos, *end = g_imageInfos + (g_imageInfos ? (1u << g_imageInfosAllocatedLog2) : 0u); iterator < end; ++iterator)
+      {
+         if (!(iterator->flags & CCE_IMAGE_INFO_USED))
+            continue;
+         struct ImageInfo info = *iterator;
+         info.flags = 0u;
+         isWritten = isWritten && (fwrite(&info, sizeof(struct ImageInfo), 1u, file) == 1u);
+      }
+      isWritten = (fclose(file) == 0) && isWritten;
+      if (!isWritten || cce__replaceFile(temporaryPath, path) != 0)
+         remove(temporaryPath);
+   }
+   free(temporaryPath);
+   free(path);
+}
+
+static void freeImageInfos (void)
+{
+   free(g_imageInfos);
+   g_imageInfos = NULL;
+   g_imageInfosQuantity = 0u;
+   g_imageInfosAllocatedLog2 = 0u;
+   g_isImageInfosLoaded = 0u;
+   g_isImageInfosChanged = 0u;
+}
+
+/* Works like stbi_info on image ID at path, but image is opened only if it isn't known yet or was changed since */
+int cce__getImageInfo (uint32_t ID, const char *path, int *width, int *height, int *channels)
+{
+   if (!g_isImageInfosLoaded)
+      loadImageInfos();
+   struct ImageInfo *info = g_imageInfos ? findImageInfo(ID) : NULL;
+   if (info && (info->flags & CCE_IMAGE_INFO_USED) && !(info->flags & CCE_IMAGE_INFO_CHECKED))
+   {
+      uint64_t sourceSize, sourceStamp;
+      if (cce__getFileStamp(path, &sourceSize, &sourceStamp) == 0 && sourceSize == info->sourceSize && sourceStamp == info->sourceStamp)
+         info->flags |= CCE_IMAGE_INFO_CHECKED;
+   }
+   if (!info || !(info->flags & CCE_IMAGE_INFO_CHECKED))
+   {
+      uint64_t sourceSize, sourceStamp;
+      if (cce__getFileStamp(path, &sourceSize, &sourceStamp) != 0 || !stbi_info(path, width, height, channels) ||
+          *width <= 0 || *height <= 0 || *width > UINT16_MAX || *height > UINT16_MAX)
+         return 0;
+      info = insertImageInfo(ID);
+      info->width = *width;
+      info->height = *height;
+      info->channels = *channels;
+      info->sourceSize = sourceSize;
+      info->sourceStamp = sourceStamp;
+      info->flags |= CCE_IMAGE_INFO_CHECKED;
+      g_isImageInfosChanged = 1u;
+      return 1;
+   }
+   *width = info->width;
+   *height = info->height;
+   *channels = info->channels;
+   return 1;
+}
+
+/* Image turned out to be different from its entry (it was replaced during session), it is probed again next time */
+void cce__forgetImageInfo (uint32_t ID)
+{
+   if (!g_imageInfos)
+      return;
+   struct ImageInfo *info = findImageInfo(ID);
+   if (info->flags & CCE_IMAGE_INFO_USED)
+   {
+      info->flags &= ~CCE_IMAGE_INFO_CHECKED;
+      info->sourceSize = UINT64_MAX;
+   }
+}
@@ -0,0 +1,204 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include "../platform/threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../../include/coffeechain/engine_common.h"
+#include "../external/stb_image.h"
+#include "../platform/files.h"
+#include "map2D_internal.h"
+
+/* Decoding pool: PNGs are read and decoded by worker threads, main thread only uploads results (see cce__updateTexturesArray) */
+#define CCE_TEXTURE_LOADER_MAX_THREADS 4u
+
+struct TextureDecodingQueue
+{
+   struct TextureDecodingJob *first;
+   struct TextureDecodingJob *last;
+};
+
+static cce__thread    g_threads[CCE_TEXTURE_LOADER_MAX_THREADS];
+static uint32_t       g_threadsQuantity = 0u;
+static cce__mutex     g_mutex;
+static cce__condition g_condition;
+static struct TextureDecodingQueue g_requests, g_results;
+static uint8_t        g_isStopping;
+static uint32_t       g_packedJobsQuantity; /* Requested jobs which read the resource pack and aren't decoded yet */
+
+static void pushTextureDecodingJob (struct TextureDecodingQueue *queue, struct TextureDecodingJob *job)
+{
+   job->next = NULL;
+   if (queue->last)
+      queue->last->next = job;
+   else
+      queue->first = job;
+   queue->last = job;
+}
+
+static struct TextureDecodingJob* popTextureDecodingJob (struct TextureDecodingQueue *queue)
+{
+   struct TextureDecodingJob *job = queue->first;
+   if (job)
+   {
+      queue->first = job->next;
+      if (!queue->first)
+         queue->last = NULL;
+   }
+   return job;
+}
+
+static void decodeTexture (struct TextureDecodingJob *job)
+{
+   if (cce__readTextureCache(job) == 0)
+      return;
+   if (job->file)
+      job->data = stbi_load_from_memory(job->file, job->fileSize, &(job->width), &(job->height), NULL, 4);
+   else
+      job->data = stbi_load(job->path, &(job->width), &(job->height), NULL, 4);
+   if (!job->data)
+      job->failureReason = stbi_failure_reason();
+   else
+      cce__writeTextureCache(job);
+}
+
+static void textureLoaderThread (void *argument)
+{
+   (void) argument;
+   cce__lockMutex(&g_mutex);
+   for (;;)
+   {
+      struct TextureDecodingJob *job;
+      while (!(job = popTextureDecodingJob(&g_requests)) && !g_isStopping)
+         cce__waitCondition(&g_condition, &g_mutex);
+      if (!job)
+         break;
+      cce__unlockMutex(&g_mutex);
+      decodeTexture(job);
+      cce__lockMutex(&g_mutex);
+      pushTextureDecodingJob(&g_results, job);
+      if (job->file && --g_packedJobsQuantity == 0u)
+         cce__broadcastCondition(&g_condition);
+   }
+   cce__unlockMutex(&g_mutex);
+}
+
+/* Pack stays mapped until every packed image already requested is decoded, decoding threads keep going meanwhile */
+static void waitPackedTexturesDecoding (void)
+{
+   cce__lockMutex(&g_mutex);
+   while (g_packedJobsQuantity)
+      cce__waitCondition(&g_condition, &g_mutex);
+   cce__unlockMutex(&g_mutex);
+}
+
+/* Leaves one core for the main thread. Without threads requests are decoded on the spot */
+void cce__initTextureLoader (void)
+{
+   uint32_t processors = cce__getProcessorsQuantity();
+   uint32_t threadsQuantity = (processors > 1u) ? processors - 1u : 1u;
+   if (threadsQuantity > CCE_TEXTURE_LOADER_MAX_THREADS)
+      threadsQuantity = CCE_TEXTURE_LOADER_MAX_THREADS;
+   cce__initMutex(&g_mutex);
+   cce__initCondition(&g_condition);
+   g_requests = g_results = (struct TextureDecodingQueue) {NULL, NULL};
+   g_isStopping = 0u;
+   g_packedJobsQuantity = 0u;
+   cce__beforeResourcePackUnmap = waitPackedTexturesDecoding;
+   for (g_threadsQuantity = 0u; g_threadsQuantity < threadsQuantity; ++g_threadsQuantity)
+   {
+      if (cce__createThread(g_threads + g_threadsQuantity, textureLoaderThread, NULL) != 0)
+      {
+         cce__errorPrint("ENGINE::TEXTURE_LOADER::THREAD_CREATION_FAILED:\nstarted %u of %u decoding threads", g_threadsQuantity, threadsQuantity);
+         break;
+      }
+   }
+}
+
+void cce__terminateTextureLoader (void)
+{
+   cce__beforeResourcePackUnmap = NULL;
+   cce__lockMutex(&g_mutex);
+   g_isStopping = 1u;
+   cce__broadcastCondition(&g_condition);
+   cce__unlockMutex(&g_mutex);
+   for (cce__thread *iterator = g_threads, *end = g_threads + g_threadsQuantity; iterator < end; ++iterator)
+   {
+      cce__joinThread(*iterator);
+   }
+   g_threadsQuantity = 0u;
+   for (struct TextureDecodingJob *job; (job = popTextureDecodingJob(&g_requests));)
+      cce__freeDecodedTexture(job);
+   for (struct TextureDecodingJob *job; (job = popTextureDecodingJob(&g_results));)
+      cce__freeDecodedTexture(job);
+   cce__destroyCondition(&g_condition);
+   cce__destroyMutex(&g_mutex);
+}
+
+/* file is packed image (cceCloseResourcePack waits until it is decoded), otherwise path is copied */
+void cce__requestTextureDecoding (uint32_t ID, uint16_t position, const void *file, size_t fileSize, const char *path)
+{
+   struct TextureDecodingJob *job = calloc(1u, sizeof(struct TextureDecodingJob));
+   job->ID = ID;
+   job->position = position;
+   job->file = file;
+   job->fileSize = fileSize;
+   if (!file)
+   {
+      size_t pathSize = strlen(path) + 1u;
+      job->path = malloc(pathSize);
+      memcpy(job->path, path, pathSize);
+   }
+   if (g_threadsQuantity == 0u)
+   {
+      decodeTexture(job);
+      pushTextureDecodingJob(&g_results, job);
+      return;
+   }
+   cce__lockMutex(&g_mutex);
+   pushTextureDecodingJob(&g_requests, job);
+   g_packedJobsQuantity += (file != NULL);
+   cce__broadcastCondition(&g_condition);
+   cce__unlockMutex(&g_mutex);
+}
+
+/* Returns NULL if no image finished decoding. Never blocks */
+struct TextureDecodingJob* cce__getDecodedTexture (void)
+{
+   if (g_threadsQuantity == 0u)
+      return popTextureDecodingJob(&g_results);
+   cce__lockMutex(&g_mutex);
+   struct TextureDecodingJob *job = popTextureDecodingJob(&g_results);
+   cce__unlockMutex(&g_mutex);
+   return job;
+}
+
+void cce__freeDecodedTexture (struct TextureDecodingJob *job)
+{
+   if (job->cacheFile)
+      cce__unmapFile(job->cacheFile, job->cacheFileSize);
+   else
+      stbi_image_free(job->data);
+   free(job->path);
+   free(job);
+}
@@ -42,67 +42,112 @@ CCE_PUBLIC_OPTIONS void* (*cceBigEndianConversionNewArrayIntN) (void*, const voi
 static cce_endianess endianess;
 CCE_PUBLIC_OPTIONS const cce_endianess *const g_endianess = &endianess;
 
-CCE_PUBLIC_OPTIONS uint16_t cceSwapEndianInt16 (uint16_t value)
+/* Names are in parentheses, because endianess.h defines them as macros using compiler builtins */
+CCE_PUBLIC_OPTIONS uint16_t (cceSwapEndianInt16) (uint16_t value)
 {
-   uint8_t *bytes = (uint8_t*) &value;
-   register uint8_t buffer;
-   buffer   = bytes[0];
-   bytes[0] = bytes[1];
-   bytes[1] = buffer;
-   return value;
+   #ifdef CCE_BYTESWAP16
+   return CCE_BYTESWAP16(value);
+   #else
+   return (uint16_t) ((value >> 8) | (value << 8));
+   #endif // CCE_BYTESWAP16
 }
 
-CCE_PUBLIC_OPTIONS uint32_t cceSwapEndianInt32 (uint32_t value)
+CCE_PUBLIC_OPTIONS uint32_t (cceSwapEndianInt32) (uint32_t value)
 {
-   uint8_t *bytes = (uint8_t*) &value;
-   register uint8_t buffer;
-   buffer   = bytes[0];
-   bytes[0] = bytes[3];
-   bytes[3] = buffer;
-   buffer   = bytes[1];
-   bytes[1] = bytes[2];
-   bytes[2] = buffer;
-   return value;
+   #ifdef CCE_BYTESWAP32
+   return CCE_BYTESWAP32(value);
+   #else
+   value = ((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu);
+   return (value << 16) | (value >> 16);
+   #endif // CCE_BYTESWAP32
 }
 
-CCE_PUBLIC_OPTIONS uint64_t cceSwapEndianInt64 (uint64_t value)
+CCE_PUBLIC_OPTIONS uint64_t (cceSwapEndianInt64) (uint64_t value)
 {
-   uint8_t *bytes = (uint8_t*) &value;
-   register uint8_t buffer;
-   buffer   = bytes[0];
-   bytes[0] = bytes[7];
-   bytes[7] = buffer;
-   buffer   = bytes[1];
-   bytes[1] = bytes[6];
-   bytes[6] = buffer;
-   buffer   = bytes[2];
-   bytes[2] = bytes[5];
-   bytes[5] = buffer;
-   buffer   = bytes[3];
-   bytes[3] = bytes[4];
-   bytes[4] = buffer;
-   return value;
+   #ifdef CCE_BYTESWAP64
+   return CCE_BYTESWAP64(value);
+   #else
+   return ((uint64_t) (cceSwapEndianInt32)((uint32_t) value) << 32) | (cceSwapEndianInt32)((uint32_t) (value >> 32));
+   #endif // CCE_BYTESWAP64
 }
 
-CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayIntN (void *array, size_t arraySize, size_t n)
-{
-   register uint8_t buffer;
-   for (uint8_t *iterator = (uint8_t*) array, *end = ((uint8_t*) array) + arraySize * n; iterator < end; iterator += n)
-   {
-      for (size_t i = 0; i < (n / 2); ++i)
-      {
-         buffer              = iterator[i];
-         iterator[i]         = iterator[n - i - 1];
-         iterator[n - i - 1] = buffer;
-      }
+/* Swaps 16 bytes per iteration with pshufb (SSSE3) or rev (NEON) when target supports it, the rest goes through bswap.
+ * Arrays can be unaligned (action arguments are packed), so only unaligned loads and memcpy are used. dest can be equal to src */
+#define CCE_SWAP_ARRAY_FUNCTION(bits, bytes, ssse3Mask, neonRev) \
+static void swapArrayInt ## bits (uint8_t *dest, const uint8_t *src, size_t arraySize) \
+{ \
+   size_t i = 0; \
+   CCE_SWAP_ARRAY_VECTOR(bytes, ssse3Mask, neonRev) \
+   for (; i < arraySize; ++i) \
+   { \
+      uint ## bits ## _t value; \
+      memcpy(&value, src + i * bytes, bytes); \
+      value = cceSwapEndianInt ## bits(value); \
+      memcpy(dest + i * bytes, &value, bytes); \
+   } \
+}
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CCE_SWAP_ARRAY_VECTOR(bytes, ssse3Mask, neonRev) \
+   const __m128i mask = _mm_setr_epi8 ssse3Mask; \
+   for (; i + 16 / bytes <= arraySize; i += 16 / bytes) \
+   { \
+      __m128i vector = _mm_loadu_si128((const __m128i*) (src + i * bytes)); \
+      _mm_storeu_si128((__m128i*) (dest + i * bytes), _mm_shuffle_epi8(vector, mask)); \
+   }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CCE_SWAP_ARRAY_VECTOR(bytes, ssse3Mask, neonRev) \
+   for (; i + 16 / bytes <= arraySize; i += 16 / bytes) \
+   { \
+      vst1q_u8(dest + i * bytes, neonRev(vld1q_u8(src + i * bytes))); \
    }
+#else
+#define CCE_SWAP_ARRAY_VECTOR(bytes, ssse3Mask, neonRev)
+#endif // __SSSE3__
+
+CCE_SWAP_ARRAY_FUNCTION(16, 2, (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14), vrev16q_u8)
+CCE_SWAP_ARRAY_FUNCTION(32, 4, (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12), vrev32q_u8)
+CCE_SWAP_ARRAY_FUNCTION(64, 8, (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8), vrev64q_u8)
+
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt16 (void *array, size_t arraySize)
+{
+   swapArrayInt16(array, array, arraySize);
+   return array;
+}
+
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt32 (void *array, size_t arraySize)
+{
+   swapArrayInt32(array, array, arraySize);
+   return array;
+}
+
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayInt64 (void *array, size_t arraySize)
+{
+   swapArrayInt64(array, array, arraySize);
    return array;
 }
 
 CCE_PUBLIC_OPTIONS void* cceSwapEndianNewArrayIntN (void *newArray, const void *array, size_t arraySize, size_t n)
 {
+   switch (n)
+   {
+      case 1:
+         memcpy(newArray, array, arraySize);
+         return newArray;
+      case 2:
+         swapArrayInt16(newArray, array, arraySize);
+         return newArray;
+      case 4:
+         swapArrayInt32(newArray, array, arraySize);
+         return newArray;
+      case 8:
+         swapArrayInt64(newArray, array, arraySize);
+         return newArray;
+   }
    for (uint8_t *iterator = (uint8_t*) array, *jiterator = (uint8_t*) newArray, *end = ((uint8_t*) array) + arraySize * n;
-        iterator < end; iterator += n)
+        iterator < end; iterator += n, jiterator += n)
    {
       for (size_t i = 0; i < (n / 2); ++i)
       {
@@ -113,6 +158,23 @@ CCE_PUBLIC_OPTIONS void* cceSwapEndianNewArrayIntN (void *newArray, const void *
    return newArray;
 }
 
+CCE_PUBLIC_OPTIONS void* cceSwapEndianArrayIntN (void *array, size_t arraySize, size_t n)
+{
+   if (n == 2 || n == 4 || n == 8)
+      return cceSwapEndianNewArrayIntN(array, array, arraySize, n);
+   register uint8_t buffer;
+   for (uint8_t *iterator = (uint8_t*) array, *end = ((uint8_t*) array) + arraySize * n; iterator < end; iterator += n)
+   {
+      for (size_t i = 0; i < (n / 2); ++i)
+      {
+         buffer              = iterator[i];
+         iterator[i]         = iterator[n - i - 1];
+         iterator[n - i - 1] = buffer;
+      }
+   }
+   return array;
+}
+
 static uint16_t ccePreserveEndianInt16 (uint16_t value)
 {
    return value;
@@ -72,6 +72,13 @@ static void calculateInternalDeltaTime (void)
    lastTime = currentTime;
 }
 
+/* Fixed step logic sees time of its tick, frame's time has to be set back after ticks */
+void cce__setLogicTime (double currentTime, double tickDeltaTime)
+{
+   lastTime = currentTime;
+   deltaTime = tickDeltaTime;
+}
+
 static void engineUpdate__glfw (void)
 {
    glfwPollEvents();
@@ -100,6 +107,17 @@ void swapBuffers__glfw (void)
    glfwSwapBuffers(g_GLFWstate.window);
 }
 
+static void makeContextCurrent__glfw (uint8_t isCurrent)
+{
+   glfwMakeContextCurrent(isCurrent ? g_GLFWstate.window : NULL);
+}
+
+/* Needs current context, so it's called by render thread when it's running */
+static void setSwapInterval__glfw (void)
+{
+   glfwSwapInterval(1);
+}
+
 static size_t registerKey__glfw (int glfwKey, int glfwKeyModifiers, uint16_t eventType, uint16_t number)
 {
    //if (keysQuantity >= keysQuantityAllocated)
@@ -160,14 +178,14 @@ static void toFullscreen__glfw (void)
    }
    glfwSetWindowSizeCallback(g_GLFWstate.window, windowResizeCallback);
    g_GLFWstate.flags |= CCE_FULLSCREEN;
-   glfwSwapInterval(1);
+   cce__callOnRenderThread(setSwapInterval__glfw);
 }
 
 static void toWindow__glfw (void)
 {
    glfwSetWindowMonitor(g_GLFWstate.window, NULL, g_GLFWstate.windowPositionX, g_GLFWstate.windowPositionY, g_GLFWstate.windowWidth, g_GLFWstate.windowHeight, g_GLFWstate.vidMode->refreshRate);
    g_GLFWstate.flags &= ~CCE_FULLSCREEN;
-   glfwSwapInterval(1);
+   cce__callOnRenderThread(setSwapInterval__glfw);
 }
 
 static void showWindow__glfw (void)
@@ -396,6 +414,7 @@ int cce__initEngine__glfw (const char *label, uint16_t globalBoolsQuantity)
    glfwWindowHint(GLFW_AUTO_ICONIFY,   GLFW_TRUE);
    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
    glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
+   glfwWindowHint(GLFW_DEPTH_BITS, 24);
    char *wl = getenv("WAYLAND_DISPLAY");
    internalFlags |= CCE_WAYLAND * (wl != NULL && (*wl != '\0'));
    if ((~internalFlags & CCE_WAYLAND) == CCE_WAYLAND)
@@ -503,6 +522,21 @@ int cce__initEngine__glfw (const char *label, uint16_t globalBoolsQuantity)
       glfwTerminate();
       return -1;
    }
+   cce__glBufferStorage = NULL;
+   /* Game thread can't write to mapped memory which render thread reads at any time */
+   if (!cce__isRenderThreadEnabled() && glfwExtensionSupported("GL_ARB_buffer_storage"))
+   {
+      cce__glBufferStorage = (void (*) (GLenum, GLsizeiptr, const void*, GLbitfield)) glfwGetProcAddress("glBufferStorage");
+   }
+   cce__glGetProgramBinary = NULL;
+   cce__glProgramBinary = NULL;
+   cce__glProgramParameteri = NULL;
+   if (glfwExtensionSupported("GL_ARB_get_program_binary"))
+   {
+      cce__glGetProgramBinary = (void (*) (GLuint, GLsizei, GLsizei*, GLenum*, void*)) glfwGetProcAddress("glGetProgramBinary");
+      cce__glProgramBinary = (void (*) (GLuint, GLenum, const void*, GLsizei)) glfwGetProcAddress("glProgramBinary");
+      cce__glProgramParameteri = (void (*) (GLuint, GLenum, GLint)) glfwGetProcAddress("glProgramParameteri");
+   }
    cce_keys = malloc(14u * sizeof(struct RegisteredKeys));
    
    registerKey__glfw(GLFW_KEY_UP,          GLFW_FALSE, 0x0, globalBoolsQuantity - 12);
@@ -537,6 +571,7 @@ int cce__initEngine__glfw (const char *label, uint16_t globalBoolsQuantity)
    }
    cce__toFullscreen = toFullscreen__glfw;
    cce__swapBuffers = swapBuffers__glfw;
+   cce__makeContextCurrent = makeContextCurrent__glfw;
    cce__getCurrentStep = getCurrentStep__glfw;
    cce__engineUpdate__api = engineUpdate__glfw;
    cce__terminateEngine__api = terminateEngine__glfw;
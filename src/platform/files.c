@@ -0,0 +1,125 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include "platforms.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined(POSIX_SYSTEM)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#elif defined(WINDOWS_SYSTEM)
+#include <windows.h>
+#endif
+
+#include "files.h"
+
+#if defined(POSIX_SYSTEM)
+
+const uint8_t* cce__mapFile (const char *path, size_t *size)
+{
+   int file = open(path, O_RDONLY);
+   if (file == -1)
+      return NULL;
+   struct stat fileInfo;
+   if (fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0)
+   {
+      close(file);
+      return NULL;
+   }
+   void *data = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+   close(file);
+   if (data == MAP_FAILED)
+      return NULL;
+   *size = fileInfo.st_size;
+   return data;
+}
+
+void cce__unmapFile (const uint8_t *data, size_t size)
+{
+   munmap((void*) data, size);
+}
+
+int cce__getFileStamp (const char *path, uint64_t *size, uint64_t *modificationTime)
+{
+   struct stat fileInfo;
+   if (stat(path, &fileInfo) != 0)
+      return -1;
+   *size = fileInfo.st_size;
+   *modificationTime = fileInfo.st_mtime;
+   return 0;
+}
+
+int cce__replaceFile (const char *temporaryPath, const char *path)
+{
+   return (rename(temporaryPath, path) == 0) ? 0 : -1;
+}
+
+#elif defined(WINDOWS_SYSTEM)
+
+const uint8_t* cce__mapFile (const char *path, size_t *size)
+{
+   HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE)
+      return NULL;
+   LARGE_INTEGER fileSize;
+   if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+   {
+      CloseHandle(file);
+      return NULL;
+   }
+   HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+   CloseHandle(file);
+   if (!mapping)
+      return NULL;
+   void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping); // View holds the mapping
+   if (!data)
+      return NULL;
+   *size = fileSize.QuadPart;
+   return data;
+}
+
+void cce__unmapFile (const uint8_t *data, size_t size)
+{
+   (void) size;
+   UnmapViewOfFile(data);
+}
+
+int cce__getFileStamp (const char *path, uint64_t *size, uint64_t *modificationTime)
+{
+   WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+   if (!GetFileAttributesExA(path, GetFileExInfoStandard, &fileInfo))
+      return -1;
+   *size = ((uint64_t) fileInfo.nFileSizeHigh << 32) | fileInfo.nFileSizeLow;
+   *modificationTime = ((uint64_t) fileInfo.ftLastWriteTime.dwHighDateTime << 32) | fileInfo.ftLastWriteTime.dwLowDateTime;
+   return 0;
+}
+
+int cce__replaceFile (const char *temporaryPath, const char *path)
+{
+   return MoveFileExA(temporaryPath, path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+}
+
+#endif // POSIX_SYSTEM
@@ -0,0 +1,40 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#ifndef FILES_H
+#define FILES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Whole file is mapped read-only, returns NULL if file doesn't exist, is empty or can't be mapped */
+const uint8_t* cce__mapFile (const char *path, size_t *size);
+void cce__unmapFile (const uint8_t *data, size_t size);
+
+/* Size and last modification time of file (in platform units, only compared for equality). Returns -1 if file doesn't exist */
+int cce__getFileStamp (const char *path, uint64_t *size, uint64_t *modificationTime);
+
+/* Replaces file at path by file at temporaryPath, readers never see partially written file. Returns -1 on failure */
+int cce__replaceFile (const char *temporaryPath, const char *path);
+
+/* Called before resource pack is unmapped, so pointers into the pack handed to other threads aren't read afterwards */
+extern void (*cce__beforeResourcePackUnmap) (void);
+
+#endif // FILES_H
@@ -30,8 +30,12 @@
     defined(sun) || defined(__sun) || defined (sinux) || defined(__minix)
 
 #define POSIX_SYSTEM
+#ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE 500L
+#endif
 
 #elif defined(_WIN32) || defined(__WIN32__) || defined(_WIN64) || defined(__TOS_WIN__) || defined(__WINDOWS__) || \
       defined(__MINGW32__) || defined(__MINGW64__) || defined(__CYGWIN__)
@@ -0,0 +1,368 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include "platforms.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../include/coffeechain/engine_common.h"
+#include "../../include/coffeechain/endianess.h"
+#include "../../include/coffeechain/os_interaction.h"
+#include "../../include/coffeechain/resource_pack.h"
+#include "files.h"
+
+/* Pack file structure (little endian):
+ * struct ResourcePackHeader header
+ * struct ResourcePackEntry  entries [entriesQuantity] // Sorted by type, then by ID
+ * payloads, each starts at offset multiple of alignment */
+#define CCE_RESOURCE_PACK_VERSION 1u
+#define CCE_RESOURCE_PACK_ALIGNMENT 4096u
+
+struct ResourcePackHeader
+{
+   char     magic[4]; /* "C2RP" */
+   uint16_t version;
+   uint16_t reserved;
+   uint32_t entriesQuantity;
+   uint32_t alignment;
+}; // 16 bytes
+
+struct ResourcePackEntry
+{
+   uint32_t type;
+   uint32_t ID;
+   uint64_t offset;
+   uint64_t size;
+}; // 24 bytes
+
+static const uint8_t *pack = NULL;
+static size_t packSize;
+static const struct ResourcePackEntry *packEntries;
+static struct ResourcePackEntry *packEntriesConverted = NULL; // Used on big endian hosts only
+static uint32_t packEntriesQuantity;
+void (*cce__beforeResourcePackUnmap) (void) = NULL;
+
+CCE_PUBLIC_OPTIONS void cceCloseResourcePack (void)
+{
+   if (!pack)
+      return;
+   if (cce__beforeResourcePackUnmap)
+      cce__beforeResourcePackUnmap();
+   cce__unmapFile(pack, packSize);
+   pack = NULL;
+   free(packEntriesConverted);
+   packEntriesConverted = NULL;
+   packEntries = NULL;
+   packEntriesQuantity = 0u;
+}
+
+static int readResourcePackIndex (void)
+{
+   struct ResourcePackHeader header;
+   if (packSize < sizeof(struct ResourcePackHeader))
+      return -1;
+   memcpy(&header, pack, sizeof(struct ResourcePackHeader));
+   header.version         = cceLittleEndianToHostEndianInt16(header.version);
+   header.entriesQuantity = cceLittleEndianToHostEndianInt32(header.entriesQuantity);
+   if (memcmp(header.magic, "C2RP", 4u) != 0 || header.version != CCE_RESOURCE_PACK_VERSION ||
+       (packSize - sizeof(struct ResourcePackHeader)) / sizeof(struct ResourcePackEntry) < header.entriesQuantity)
+      return -1;
+   
+   packEntriesQuantity = header.entriesQuantity;
+   packEntries = (const struct ResourcePackEntry*) (pack + sizeof(struct ResourcePackHeader));
+   if (cceHostEndianess == CCE_BIG_ENDIAN)
+   {
+      packEntriesConverted = malloc(packEntriesQuantity * sizeof(struct ResourcePackEntry));
+      for (struct ResourcePackEntry *iterator = packEntriesConverted, *end = packEntriesConverted + packEntriesQuantity; iterator < end; ++iterator, ++packEntries)
+      {
+         iterator->type   = cceLittleEndianToHostEndianInt32(packEntries->type);
+         iterator->ID     = cceLittleEndianToHostEndianInt32(packEntries->ID);
+         iterator->offset = cceLittleEndianToHostEndianInt64(packEntries->offset);
+         iterator->size   = cceLittleEndianToHostEndianInt64(packEntries->size);
+      }
+      packEntries = packEntriesConverted;
+   }
+   for (const struct ResourcePackEntry *iterator = packEntries, *end = packEntries + packEntriesQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->offset > packSize || iterator->size > packSize - iterator->offset)
+         return -1;
+   }
+   return 0;
+}
+
+/* Maps whole pack into memory, so loaders don't open a file per resource. Loaders fall back to separate files for resources that aren't in the pack */
+CCE_PUBLIC_OPTIONS int cceOpenResourcePack (const char *path)
+{
+   cceCloseResourcePack();
+   if (!cceLittleEndianConversionInt32)
+      cceInitEndianConversion();
+   pack = cce__mapFile(path, &packSize);
+   if (!pack)
+   {
+      fprintf(stderr, "ENGINE::RESOURCE_PACK::FAILED_TO_OPEN:\n%s - cannot open or map file\n", path);
+      return -1;
+   }
+   if (readResourcePackIndex() != 0)
+   {
+      fprintf(stderr, "ENGINE::RESOURCE_PACK::CORRUPTED:\n%s is not a resource pack or is corrupted\n", path);
+      cceCloseResourcePack();
+      return -1;
+   }
+   return 0;
+}
+
+static const struct ResourcePackEntry* findPackedResource (uint32_t type, uint32_t ID)
+{
+   if (!pack)
+      return NULL;
+   const struct ResourcePackEntry *low = packEntries, *high = packEntries + packEntriesQuantity;
+   while (low < high)
+   {
+      const struct ResourcePackEntry *middle = low + (high - low) / 2;
+      if (middle->type < type || (middle->type == type && middle->ID < ID))
+      {
+         low = middle + 1;
+      }
+      else if (middle->type == type && middle->ID == ID)
+      {
+         return middle;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+   return NULL;
+}
+
+/* Returns NULL if there's no pack opened or resource isn't in it. Memory is valid until cceCloseResourcePack */
+CCE_PUBLIC_OPTIONS const void* cceGetPackedResource (cce_enum type, uint32_t ID, size_t *size)
+{
+   const struct ResourcePackEntry *entry = findPackedResource(type, ID);
+   if (!entry)
+      return NULL;
+   if (size)
+      *size = entry->size;
+   return pack + entry->offset;
+}
+
+/* Same as cceGetPackedResource, but for loaders reading through stdio. Returned file must be closed with fclose */
+CCE_PUBLIC_OPTIONS FILE* cceOpenPackedResource (cce_enum type, uint32_t ID, size_t *size)
+{
+   const struct ResourcePackEntry *entry = findPackedResource(type, ID);
+   if (!entry)
+      return NULL;
+   if (size)
+      *size = entry->size;
+   #if defined(POSIX_SYSTEM)
+   return fmemopen((void*) (pack + entry->offset), entry->size, "rb");
+   #else
+   // Windows has no fmemopen, so resource is copied to temporary file to keep end of file where loaders expect it
+   FILE *file = tmpfile();
+   if (!file)
+      return NULL;
+   fwrite(pack + entry->offset, 1u, entry->size, file);
+   rewind(file);
+   return file;
+   #endif // POSIX_SYSTEM
+}
+
+/* FNV-1a, both slash types are treated as '/' so packs are same on all platforms */
+CCE_PUBLIC_OPTIONS uint32_t cceResourceNameHash (const char *name)
+{
+   uint32_t hash = 2166136261u;
+   for (; *name != '\0'; ++name)
+   {
+      hash ^= (uint8_t) ((*name == '\\') ? '/' : *name);
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static int parseResourceID (const char *name, const char *prefix, const char *suffix, uint32_t *ID)
+{
+   size_t prefixLength = strlen(prefix), suffixLength = strlen(suffix), nameLength = strlen(name);
+   if (nameLength <= prefixLength + suffixLength || nameLength > prefixLength + suffixLength + 10u ||
+       memcmp(name, prefix, prefixLength) != 0 || memcmp(name + nameLength - suffixLength, suffix, suffixLength) != 0)
+      return -1;
+   uint64_t value = 0u;
+   for (const char *iterator = name + prefixLength, *end = name + nameLength - suffixLength; iterator < end; ++iterator)
+   {
+      if (*iterator < '0' || *iterator > '9')
+         return -1;
+      value = value * 10u + (*iterator - '0');
+   }
+   if (value > UINT32_MAX)
+      return -1;
+   *ID = value;
+   return 0;
+}
+
+static struct ResourcePackEntry classifyResource (const char *name)
+{
+   struct ResourcePackEntry entry = {CCE_RESOURCE_FILE, 0u, 0u, 0u};
+   const char *fileName = name;
+   for (const char *iterator = name; *iterator != '\0'; ++iterator)
+   {
+      if (*iterator == '/' || *iterator == '\\')
+         fileName = iterator + 1;
+   }
+   if (parseResourceID(fileName, "map_", ".c2m", &entry.ID) == 0)
+      entry.type = CCE_RESOURCE_MAP2D;
+   else if (parseResourceID(fileName, "map_", ".c2b", &entry.ID) == 0)
+      entry.type = CCE_RESOURCE_BAKED_MAP2D;
+   else if (parseResourceID(fileName, "world_", ".c2w", &entry.ID) == 0)
+      entry.type = CCE_RESOURCE_WORLD_MAP2D;
+   else if (parseResourceID(fileName, "img_", ".png", &entry.ID) == 0)
+      entry.type = CCE_RESOURCE_IMAGE;
+   else if (strcmp(fileName, "dummy.png") == 0)
+   {
+      entry.type = CCE_RESOURCE_IMAGE;
+      entry.ID   = CCE_RESOURCE_DUMMY_IMAGE;
+   }
+   else
+      entry.ID = cceResourceNameHash(name);
+   return entry;
+}
+
+static int compareResourcePackEntries (const void *a, const void *b)
+{
+   const struct ResourcePackEntry *first = a, *second = b;
+   if (first->type != second->type)
+      return (first->type < second->type) ? -1 : 1;
+   if (first->ID != second->ID)
+      return (first->ID < second->ID) ? -1 : 1;
+   return 0;
+}
+
+struct PackedFile
+{
+   struct ResourcePackEntry entry;
+   const char *name;
+};
+
+/* Sorts files and sets their sizes and page aligned offsets */
+static int indexPackedFiles (struct PackedFile *packedFiles, size_t filesQuantity, const char *rootPath)
+{
+   qsort(packedFiles, filesQuantity, sizeof(struct PackedFile), compareResourcePackEntries);
+   uint64_t offset = sizeof(struct ResourcePackHeader) + filesQuantity * sizeof(struct ResourcePackEntry);
+   for (struct PackedFile *iterator = packedFiles, *end = packedFiles + filesQuantity; iterator < end; ++iterator)
+   {
+      if (iterator > packedFiles && compareResourcePackEntries(iterator - 1, iterator) == 0)
+      {
+         fprintf(stderr, "ENGINE::RESOURCE_PACK::DUPLICATE_RESOURCE:\n%s and %s have same type and ID\n", (iterator - 1)->name, iterator->name);
+         return -1;
+      }
+      char *path = cceCreateNewPathFromOldPath(rootPath, iterator->name, 0u);
+      FILE *file = fopen(path, "rb");
+      if (!file)
+      {
+         fprintf(stderr, "ENGINE::RESOURCE_PACK::FAILED_TO_OPEN:\n%s - no such file or directory\n", path);
+         free(path);
+         return -1;
+      }
+      free(path);
+      fseek(file, 0, SEEK_END);
+      iterator->entry.size = ftell(file);
+      fclose(file);
+      offset = (offset + CCE_RESOURCE_PACK_ALIGNMENT - 1u) & ~((uint64_t) CCE_RESOURCE_PACK_ALIGNMENT - 1u);
+      iterator->entry.offset = offset;
+      offset += iterator->entry.size;
+   }
+   return 0;
+}
+
+static int writePackedFiles (const struct PackedFile *packedFiles, size_t filesQuantity, const char *rootPath, FILE *output)
+{
+   struct ResourcePackHeader header = {{'C', '2', 'R', 'P'}, cceHostEndianToLittleEndianInt16(CCE_RESOURCE_PACK_VERSION), 0u,
+                                       cceHostEndianToLittleEndianInt32(filesQuantity), cceHostEndianToLittleEndianInt32(CCE_RESOURCE_PACK_ALIGNMENT)};
+   fwrite(&header, sizeof(struct ResourcePackHeader), 1u, output);
+   for (const struct PackedFile *iterator = packedFiles, *end = packedFiles + filesQuantity; iterator < end; ++iterator)
+   {
+      struct ResourcePackEntry entry;
+      entry.type   = cceHostEndianToLittleEndianInt32(iterator->entry.type);
+      entry.ID     = cceHostEndianToLittleEndianInt32(iterator->entry.ID);
+      entry.offset = cceHostEndianToLittleEndianInt64(iterator->entry.offset);
+      entry.size   = cceHostEndianToLittleEndianInt64(iterator->entry.size);
+      fwrite(&entry, sizeof(struct ResourcePackEntry), 1u, output);
+   }
+   uint8_t buffer[CCE_RESOURCE_PACK_ALIGNMENT];
+   uint64_t position = sizeof(struct ResourcePackHeader) + filesQuantity * sizeof(struct ResourcePackEntry);
+   for (const struct PackedFile *iterator = packedFiles, *end = packedFiles + filesQuantity; iterator < end; ++iterator)
+   {
+      memset(buffer, 0, CCE_RESOURCE_PACK_ALIGNMENT);
+      fwrite(buffer, 1u, iterator->entry.offset - position, output);
+      char *path = cceCreateNewPathFromOldPath(rootPath, iterator->name, 0u);
+      FILE *file = fopen(path, "rb");
+      free(path);
+      if (!file)
+         return -1;
+      size_t read;
+      position = iterator->entry.offset;
+      while ((read = fread(buffer, 1u, CCE_RESOURCE_PACK_ALIGNMENT, file)) > 0u && position + read <= iterator->entry.offset + iterator->entry.size)
+      {
+         fwrite(buffer, 1u, read, output);
+         position += read;
+      }
+      fclose(file);
+      if (position != iterator->entry.offset + iterator->entry.size)
+      {
+         fprintf(stderr, "ENGINE::RESOURCE_PACK::FILE_CHANGED:\n%s was changed while packing\n", iterator->name);
+         return -1;
+      }
+   }
+   return 0;
+}
+
+/* files are paths relative to rootPath. Maps, baked maps and images are indexed by their number, everything else - by cceResourceNameHash of given path */
+CCE_PUBLIC_OPTIONS int cceCreateResourcePack (const char *outputPath, const char *rootPath, const char *const *files, size_t filesQuantity)
+{
+   if (!cceLittleEndianConversionInt32)
+      cceInitEndianConversion();
+   struct PackedFile *packedFiles = malloc(filesQuantity * sizeof(struct PackedFile));
+   for (size_t i = 0; i < filesQuantity; ++i)
+   {
+      const char *name = *(files + i);
+      while (name[0] == '.' && (name[1] == '/' || name[1] == '\\'))
+         name += 2;
+      (packedFiles + i)->name  = name;
+      (packedFiles + i)->entry = classifyResource(name);
+   }
+   if (indexPackedFiles(packedFiles, filesQuantity, rootPath) != 0)
+   {
+      free(packedFiles);
+      return -1;
+   }
+   FILE *output = fopen(outputPath, "wb");
+   if (!output)
+   {
+      fprintf(stderr, "ENGINE::RESOURCE_PACK::FAILED_TO_OPEN_FILE:\n%s - cannot open file\n", outputPath);
+      free(packedFiles);
+      return -1;
+   }
+   int result = writePackedFiles(packedFiles, filesQuantity, rootPath, output);
+   if (fclose(output) != 0)
+      result = -1;
+   free(packedFiles);
+   return result;
+}
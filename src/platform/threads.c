@@ -0,0 +1,197 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include "platforms.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined(POSIX_SYSTEM)
+#include <unistd.h>
+#endif
+
+#include "threads.h"
+
+struct ThreadStart
+{
+   cce__threadFunction function;
+   void *argument;
+};
+
+#if defined(POSIX_SYSTEM)
+
+static void* threadStart (void *start)
+{
+   struct ThreadStart threadStart = *((struct ThreadStart*) start);
+   free(start);
+   threadStart.function(threadStart.argument);
+   return NULL;
+}
+
+int cce__createThread (cce__thread *thread, cce__threadFunction function, void *argument)
+{
+   struct ThreadStart *start = malloc(sizeof(struct ThreadStart));
+   *start = (struct ThreadStart) {function, argument};
+   if (pthread_create(thread, NULL, threadStart, start) != 0)
+   {
+      free(start);
+      return -1;
+   }
+   return 0;
+}
+
+void cce__joinThread (cce__thread thread)
+{
+   pthread_join(thread, NULL);
+}
+
+void cce__initMutex (cce__mutex *mutex)
+{
+   pthread_mutex_init(mutex, NULL);
+}
+
+void cce__destroyMutex (cce__mutex *mutex)
+{
+   pthread_mutex_destroy(mutex);
+}
+
+void cce__lockMutex (cce__mutex *mutex)
+{
+   pthread_mutex_lock(mutex);
+}
+
+void cce__unlockMutex (cce__mutex *mutex)
+{
+   pthread_mutex_unlock(mutex);
+}
+
+void cce__initCondition (cce__condition *condition)
+{
+   pthread_cond_init(condition, NULL);
+}
+
+void cce__destroyCondition (cce__condition *condition)
+{
+   pthread_cond_destroy(condition);
+}
+
+void cce__waitCondition (cce__condition *condition, cce__mutex *mutex)
+{
+   pthread_cond_wait(condition, mutex);
+}
+
+void cce__signalCondition (cce__condition *condition)
+{
+   pthread_cond_signal(condition);
+}
+
+void cce__broadcastCondition (cce__condition *condition)
+{
+   pthread_cond_broadcast(condition);
+}
+
+uint32_t cce__getProcessorsQuantity (void)
+{
+   long processors = sysconf(_SC_NPROCESSORS_ONLN);
+   return (processors > 0) ? (uint32_t) processors : 1u;
+}
+
+#elif defined(WINDOWS_SYSTEM)
+
+static DWORD WINAPI threadStart (LPVOID start)
+{
+   struct ThreadStart threadStart = *((struct ThreadStart*) start);
+   free(start);
+   threadStart.function(threadStart.argument);
+   return 0;
+}
+
+int cce__createThread (cce__thread *thread, cce__threadFunction function, void *argument)
+{
+   struct ThreadStart *start = malloc(sizeof(struct ThreadStart));
+   *start = (struct ThreadStart) {function, argument};
+   *thread = CreateThread(NULL, 0, threadStart, start, 0, NULL);
+   if (*thread == NULL)
+   {
+      free(start);
+      return -1;
+   }
+   return 0;
+}
+
+void cce__joinThread (cce__thread thread)
+{
+   WaitForSingleObject(thread, INFINITE);
+   CloseHandle(thread);
+}
+
+void cce__initMutex (cce__mutex *mutex)
+{
+   InitializeSRWLock(mutex);
+}
+
+void cce__destroyMutex (cce__mutex *mutex)
+{
+   (void) mutex; // SRW locks don't need to be destroyed
+}
+
+void cce__lockMutex (cce__mutex *mutex)
+{
+   AcquireSRWLockExclusive(mutex);
+}
+
+void cce__unlockMutex (cce__mutex *mutex)
+{
+   ReleaseSRWLockExclusive(mutex);
+}
+
+void cce__initCondition (cce__condition *condition)
+{
+   InitializeConditionVariable(condition);
+}
+
+void cce__destroyCondition (cce__condition *condition)
+{
+   (void) condition;
+}
+
+void cce__waitCondition (cce__condition *condition, cce__mutex *mutex)
+{
+   SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
+}
+
+void cce__signalCondition (cce__condition *condition)
+{
+   WakeConditionVariable(condition);
+}
+
+void cce__broadcastCondition (cce__condition *condition)
+{
+   WakeAllConditionVariable(condition);
+}
+
+uint32_t cce__getProcessorsQuantity (void)
+{
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return (info.dwNumberOfProcessors > 0) ? (uint32_t) info.dwNumberOfProcessors : 1u;
+}
+
+#endif // Platform
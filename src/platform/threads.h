@@ -0,0 +1,63 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include "platforms.h"
+
+#include <stdint.h>
+
+#if defined(POSIX_SYSTEM)
+#include <pthread.h>
+
+typedef pthread_t       cce__thread;
+typedef pthread_mutex_t cce__mutex;
+typedef pthread_cond_t  cce__condition;
+
+#elif defined(WINDOWS_SYSTEM)
+#include <windows.h>
+
+typedef HANDLE             cce__thread;
+typedef SRWLOCK            cce__mutex;
+typedef CONDITION_VARIABLE cce__condition;
+
+#endif // Platform
+
+typedef void (*cce__threadFunction) (void*);
+
+/* Returns 0 on success */
+int  cce__createThread (cce__thread *thread, cce__threadFunction function, void *argument);
+void cce__joinThread (cce__thread thread);
+
+void cce__initMutex (cce__mutex *mutex);
+void cce__destroyMutex (cce__mutex *mutex);
+void cce__lockMutex (cce__mutex *mutex);
+void cce__unlockMutex (cce__mutex *mutex);
+
+void cce__initCondition (cce__condition *condition);
+void cce__destroyCondition (cce__condition *condition);
+void cce__waitCondition (cce__condition *condition, cce__mutex *mutex);
+void cce__signalCondition (cce__condition *condition);
+void cce__broadcastCondition (cce__condition *condition);
+
+uint32_t cce__getProcessorsQuantity (void);
+
+#endif // THREADS_H
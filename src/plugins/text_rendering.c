@@ -28,6 +28,7 @@
 #include "../../include/coffeechain/map2D/base_actions.h"
 #include "../../include/coffeechain/os_interaction.h"
 #include "../../include/coffeechain/plugins/text_rendering.h"
+#include "../../include/coffeechain/resource_pack.h"
 #include "../../include/coffeechain/utils.h"
 
 #define UNK 1
@@ -65,6 +66,7 @@ struct LetterInfoNumerated
 struct INIKeyHandlerStruct
 {
    char *filePath;
+   uint8_t isPacked; // filePath is relative to resource pack root
    char prevSection[128];
    union
    {
@@ -138,7 +140,7 @@ static int cce__processProperties (struct INIKeyHandlerStruct *st)
          path = st->filePath;
       }
       memcpy(path + fileNamePosition, st->imagename, imageNameLength + 1);
-      textureID = cceLoadTexture(path);
+      textureID = (st->isPacked) ? cceLoadPackedTexture(path) : cceLoadTexture(path);
       if (textureID == 0)
       {
          fprintf(stderr, "ENGINE::TEXT_RENDERING::IMAGE_LOADING_ERROR:\n%s - file cannot be loaded\n", path);
@@ -494,9 +496,8 @@ static int cce__iniKeyHandler (void* structure, const char* section, const char*
    return 1;
 }
 
-CCE_PUBLIC_OPTIONS int cceLoadBitmapFont (const char *cceFontName)
+static FILE* openFontFile (const char *cceFontName, size_t nameLength, char **pathPointer)
 {
-   size_t nameLength = strlen(cceFontName);
    const char *resourcePath = cceGetResourcePath();
    size_t resourcePathSize = strlen(resourcePath);
    size_t fullResourcePathSize = resourcePathSize + (resourcePath[resourcePathSize - 1] != '/') + 6; /*+ "fonts/"*/;
@@ -533,10 +534,31 @@ CCE_PUBLIC_OPTIONS int cceLoadBitmapFont (const char *cceFontName)
       {
          fprintf(stderr, "ENGINE::TEXT_RENDERING::FONT_LOADING_FAILURE:\nFont %s was not found\npath: %s\n", cceFontName, path);
          free(path);
-         return -1;
+         return NULL;
       }
    }
+   *pathPointer = path;
+   return file;
+}
+
+CCE_PUBLIC_OPTIONS int cceLoadBitmapFont (const char *cceFontName)
+{
+   size_t nameLength = strlen(cceFontName);
    struct INIKeyHandlerStruct st = {0};
+   /* Resource pack keeps fonts as "fonts/<name>.ini" */
+   char *path = malloc(6 + nameLength + 4 + 8); /* + ".ini" +8 in case imagename is longer than ini file name */
+   memcpy(path, "fonts/", 6);
+   memcpy(path + 6, cceFontName, nameLength);
+   memcpy(path + 6 + nameLength, ".ini", 4 + 1/* '\0' */);
+   FILE *file = cceOpenPackedResource(CCE_RESOURCE_FILE, cceResourceNameHash(path), NULL);
+   st.isPacked = (file != NULL);
+   if (!file)
+   {
+      free(path);
+      file = openFontFile(cceFontName, nameLength, &path);
+      if (!file)
+         return -1;
+   }
    st.filePath = path;
    st.fontID = UINT16_MAX;
    #if defined(INIH_LOCAL)
@@ -0,0 +1,938 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/coffeechain/engine_common.h"
+#include "../include/coffeechain/utils.h"
+
+#include "engine_common_internal.h"
+#include "platform/threads.h"
+
+/* Render thread owns GL context after cceInitEngine2D. GL functions which engine calls after init are replaced in glad
+ * by recorders, they write the call with copies of pointed data to command buffer of the frame. Swap ends the frame:
+ * buffer is given to render thread and next frame is recorded to other buffer while the previous one is replayed.
+ * Calls which return something to game thread wait until render thread replays everything before them */
+
+#define CCE_RENDER_THREAD_RUNNING 0x1
+#define CCE_RENDER_THREAD_STOP    0x2
+
+#define CCE_RENDER_COMMANDS_ALLOCATION_STEP 0x4000u /* In arguments */
+#define CCE_MAPPED_RANGES_MAX 4u
+
+/* Command is replay function, quantity of arguments taken by command (with these two) and arguments,
+ * data copied from game thread memory follows arguments */
+union RenderArgument
+{
+   void (*replay) (const union RenderArgument*);
+   void (*function) (void);
+   GLint i;
+   GLuint u;
+   GLfloat f;
+   GLintptr p;
+   GLsizeiptr s;
+   size_t quantity;
+   const void *data;
+   void *result;
+};
+
+struct RenderCommands
+{
+   union RenderArgument *arguments;
+   size_t quantity;
+   size_t allocated;
+};
+
+struct MappedRange
+{
+   GLenum target;
+   GLintptr offset;
+   GLsizeiptr length;
+   void *data; /* NULL if buffer is really mapped */
+};
+
+static struct
+{
+   struct RenderCommands commands[2];
+   struct RenderCommands *submitted; /* NULL when render thread has nothing to replay */
+   struct MappedRange mappedRanges[CCE_MAPPED_RANGES_MAX];
+   void (*swapBuffers) (void);
+   cce__thread thread;
+   cce__mutex mutex;
+   cce__condition condition;
+   uint8_t recording;
+   uint8_t mappedRangesQuantity;
+   uint8_t flags;
+} g_renderThread;
+
+/* Real GL functions, called only by render thread */
+static struct
+{
+   PFNGLACTIVETEXTUREPROC ActiveTexture;
+   PFNGLBINDBUFFERPROC BindBuffer;
+   PFNGLBINDBUFFERRANGEPROC BindBufferRange;
+   PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+   PFNGLBINDTEXTUREPROC BindTexture;
+   PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+   PFNGLBLENDFUNCPROC BlendFunc;
+   PFNGLBUFFERDATAPROC BufferData;
+   PFNGLBUFFERSUBDATAPROC BufferSubData;
+   PFNGLCLEARPROC Clear;
+   PFNGLCLEARCOLORPROC ClearColor;
+   PFNGLCOPYBUFFERSUBDATAPROC CopyBufferSubData;
+   PFNGLCOPYTEXSUBIMAGE3DPROC CopyTexSubImage3D;
+   PFNGLDELETEBUFFERSPROC DeleteBuffers;
+   PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+   PFNGLDELETEPROGRAMPROC DeleteProgram;
+   PFNGLDELETETEXTURESPROC DeleteTextures;
+   PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
+   PFNGLDEPTHFUNCPROC DepthFunc;
+   PFNGLDEPTHMASKPROC DepthMask;
+   PFNGLDISABLEPROC Disable;
+   PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+   PFNGLENABLEPROC Enable;
+   PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+   PFNGLFRAMEBUFFERTEXTURELAYERPROC FramebufferTextureLayer;
+   PFNGLGENBUFFERSPROC GenBuffers;
+   PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+   PFNGLGENTEXTURESPROC GenTextures;
+   PFNGLGENVERTEXARRAYSPROC GenVertexArrays;
+   PFNGLGETERRORPROC GetError;
+   PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+   PFNGLPIXELSTOREIPROC PixelStorei;
+   PFNGLTEXBUFFERPROC TexBuffer;
+   PFNGLTEXIMAGE3DPROC TexImage3D;
+   PFNGLTEXPARAMETERIPROC TexParameteri;
+   PFNGLTEXSUBIMAGE3DPROC TexSubImage3D;
+   PFNGLUNIFORM1IPROC Uniform1i;
+   PFNGLUNIFORM1IVPROC Uniform1iv;
+   PFNGLUNIFORM2FPROC Uniform2f;
+   PFNGLUNIFORM2IPROC Uniform2i;
+   PFNGLUNIFORM2IVPROC Uniform2iv;
+   PFNGLUNMAPBUFFERPROC UnmapBuffer;
+   PFNGLUSEPROGRAMPROC UseProgram;
+   PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+   PFNGLVERTEXATTRIBIPOINTERPROC VertexAttribIPointer;
+   PFNGLVIEWPORTPROC Viewport;
+} g_gl;
+
+#define CCE_RECORDED_GL_FUNCTIONS(X) \
+X(ActiveTexture) X(BindBuffer) X(BindBufferRange) X(BindFramebuffer) X(BindTexture) X(BindVertexArray) X(BlendFunc) X(BufferData) \
+X(BufferSubData) X(Clear) X(ClearColor) X(CopyBufferSubData) X(CopyTexSubImage3D) X(DeleteBuffers) X(DeleteFramebuffers) \
+X(DeleteProgram) X(DeleteTextures) X(DeleteVertexArrays) X(DepthFunc) X(DepthMask) X(Disable) X(DrawArraysInstanced) X(Enable) \
+X(EnableVertexAttribArray) X(FramebufferTextureLayer) X(GenBuffers) X(GenFramebuffers) X(GenTextures) X(GenVertexArrays) X(GetError) X(MapBufferRange) X(PixelStorei) X(TexBuffer) X(TexImage3D) X(TexParameteri) X(TexSubImage3D) \
+X(Uniform1i) X(Uniform1iv) X(Uniform2f) X(Uniform2i) X(Uniform2iv) X(UnmapBuffer) X(UseProgram) X(VertexAttribDivisor) \
+X(VertexAttribIPointer) X(Viewport)
+
+static uint8_t g_isRenderThreadEnabled = 0u;
+
+/* Has to be called before cceInitEngine2D. Persistently mapped stream buffers aren't used with render thread,
+ * data is copied into command buffer instead */
+CCE_PUBLIC_OPTIONS void cceSetRenderThread (uint8_t isEnabled)
+{
+   g_isRenderThreadEnabled = (isEnabled != 0u);
+}
+
+uint8_t cce__isRenderThreadEnabled (void)
+{
+   return g_isRenderThreadEnabled;
+}
+
+/* Returns arguments of the new command, dataSize bytes of data are copied after them */
+static union RenderArgument* recordCommand (void (*replay) (const union RenderArgument*), size_t argumentsQuantity, const void *data, size_t dataSize)
+{
+   struct RenderCommands *commands = g_renderThread.commands + g_renderThread.recording;
+   const size_t quantity = 2u + argumentsQuantity + (dataSize + sizeof(union RenderArgument) - 1u) / sizeof(union RenderArgument);
+   if (commands->quantity + quantity > commands->allocated)
+   {
+      commands->allocated = commands->quantity + quantity + CCE_RENDER_COMMANDS_ALLOCATION_STEP;
+      commands->arguments = realloc(commands->arguments, commands->allocated * sizeof(union RenderArgument));
+   }
+   union RenderArgument *command = commands->arguments + commands->quantity;
+   command->replay = replay;
+   (command + 1)->quantity = quantity;
+   if (dataSize)
+      memcpy(command + 2 + argumentsQuantity, data, dataSize);
+   commands->quantity += quantity;
+   return command + 2;
+}
+
+/* Waits only while render thread replays the previous buffer, so game thread is at most one frame ahead */
+static void submitCommands (void)
+{
+   cce__lockMutex(&g_renderThread.mutex);
+   while (g_renderThread.submitted)
+      cce__waitCondition(&g_renderThread.condition, &g_renderThread.mutex);
+   g_renderThread.submitted = g_renderThread.commands + g_renderThread.recording;
+   cce__broadcastCondition(&g_renderThread.condition);
+   cce__unlockMutex(&g_renderThread.mutex);
+   g_renderThread.recording ^= 1u;
+   g_renderThread.commands[g_renderThread.recording].quantity = 0u;
+}
+
+/* Results of recorded calls are written to game thread memory when it returns */
+static void finishCommands (void)
+{
+   submitCommands();
+   cce__lockMutex(&g_renderThread.mutex);
+   while (g_renderThread.submitted)
+      cce__waitCondition(&g_renderThread.condition, &g_renderThread.mutex);
+   cce__unlockMutex(&g_renderThread.mutex);
+}
+
+static void replayCommands (const struct RenderCommands *commands)
+{
+   for (const union RenderArgument *iterator = commands->arguments, *end = commands->arguments + commands->quantity; iterator < end;
+        iterator += (iterator + 1)->quantity)
+   {
+      iterator->replay(iterator + 2);
+#ifndef NDEBUG
+      GLenum error = g_gl.GetError();
+      if (error != GL_NO_ERROR)
+         fprintf(stderr, "ENGINE::RENDER_THREAD::OPENGL_ERROR:\n0x%X is raised by replayed command\n", error);
+#endif // NDEBUG
+   }
+}
+
+static void renderThread (void *argument)
+{
+   CCE_UNUSED(argument);
+   cce__makeContextCurrent(1u);
+   cce__lockMutex(&g_renderThread.mutex);
+   while (1)
+   {
+      while (!g_renderThread.submitted && !(g_renderThread.flags & CCE_RENDER_THREAD_STOP))
+         cce__waitCondition(&g_renderThread.condition, &g_renderThread.mutex);
+      if (!g_renderThread.submitted)
+         break;
+      cce__unlockMutex(&g_renderThread.mutex);
+      replayCommands(g_renderThread.submitted);
+      cce__lockMutex(&g_renderThread.mutex);
+      g_renderThread.submitted = NULL;
+      cce__broadcastCondition(&g_renderThread.condition);
+   }
+   cce__unlockMutex(&g_renderThread.mutex);
+   cce__makeContextCurrent(0u);
+}
+
+static void replayFunction (const union RenderArgument *arguments)
+{
+   arguments->function();
+}
+
+/* Calls function on the thread which owns GL context, in order with GL calls around it */
+void cce__callOnRenderThread (void (*function) (void))
+{
+   if (!(g_renderThread.flags & CCE_RENDER_THREAD_RUNNING))
+   {
+      function();
+      return;
+   }
+   recordCommand(replayFunction, 1u, NULL, 0u)->function = function;
+}
+
+static void swapBuffers__renderThread (void)
+{
+   recordCommand(replayFunction, 1u, NULL, 0u)->function = g_renderThread.swapBuffers;
+   submitCommands();
+}
+
+static void replayActiveTexture (const union RenderArgument *arguments)
+{
+   g_gl.ActiveTexture(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordActiveTexture (GLenum texture)
+{
+   recordCommand(replayActiveTexture, 1u, NULL, 0u)->u = texture;
+}
+
+static void replayBindBuffer (const union RenderArgument *arguments)
+{
+   g_gl.BindBuffer(arguments[0].u, arguments[1].u);
+}
+
+static void GLAD_API_PTR recordBindBuffer (GLenum target, GLuint buffer)
+{
+   union RenderArgument *arguments = recordCommand(replayBindBuffer, 2u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = buffer;
+}
+
+static void replayBindBufferRange (const union RenderArgument *arguments)
+{
+   g_gl.BindBufferRange(arguments[0].u, arguments[1].u, arguments[2].u, arguments[3].p, arguments[4].s);
+}
+
+static void GLAD_API_PTR recordBindBufferRange (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+   union RenderArgument *arguments = recordCommand(replayBindBufferRange, 5u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = index;
+   arguments[2].u = buffer;
+   arguments[3].p = offset;
+   arguments[4].s = size;
+}
+
+static void replayBindFramebuffer (const union RenderArgument *arguments)
+{
+   g_gl.BindFramebuffer(arguments[0].u, arguments[1].u);
+}
+
+static void GLAD_API_PTR recordBindFramebuffer (GLenum target, GLuint framebuffer)
+{
+   union RenderArgument *arguments = recordCommand(replayBindFramebuffer, 2u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = framebuffer;
+}
+
+static void replayBindTexture (const union RenderArgument *arguments)
+{
+   g_gl.BindTexture(arguments[0].u, arguments[1].u);
+}
+
+static void GLAD_API_PTR recordBindTexture (GLenum target, GLuint texture)
+{
+   union RenderArgument *arguments = recordCommand(replayBindTexture, 2u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = texture;
+}
+
+static void replayBindVertexArray (const union RenderArgument *arguments)
+{
+   g_gl.BindVertexArray(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordBindVertexArray (GLuint array)
+{
+   recordCommand(replayBindVertexArray, 1u, NULL, 0u)->u = array;
+}
+
+static void replayBlendFunc (const union RenderArgument *arguments)
+{
+   g_gl.BlendFunc(arguments[0].u, arguments[1].u);
+}
+
+static void GLAD_API_PTR recordBlendFunc (GLenum sfactor, GLenum dfactor)
+{
+   union RenderArgument *arguments = recordCommand(replayBlendFunc, 2u, NULL, 0u);
+   arguments[0].u = sfactor;
+   arguments[1].u = dfactor;
+}
+
+/* NULL data is kept NULL, so buffer is only orphaned */
+static void replayBufferData (const union RenderArgument *arguments)
+{
+   g_gl.BufferData(arguments[0].u, arguments[1].s, arguments[2].data ? arguments + 4 : NULL, arguments[3].u);
+}
+
+static void GLAD_API_PTR recordBufferData (GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+   union RenderArgument *arguments = recordCommand(replayBufferData, 4u, data, data ? size : 0u);
+   arguments[0].u = target;
+   arguments[1].s = size;
+   arguments[2].data = data;
+   arguments[3].u = usage;
+}
+
+static void replayBufferSubData (const union RenderArgument *arguments)
+{
+   g_gl.BufferSubData(arguments[0].u, arguments[1].p, arguments[2].s, arguments + 3);
+}
+
+static void GLAD_API_PTR recordBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+   union RenderArgument *arguments = recordCommand(replayBufferSubData, 3u, data, size);
+   arguments[0].u = target;
+   arguments[1].p = offset;
+   arguments[2].s = size;
+}
+
+static void replayClear (const union RenderArgument *arguments)
+{
+   g_gl.Clear(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordClear (GLbitfield mask)
+{
+   recordCommand(replayClear, 1u, NULL, 0u)->u = mask;
+}
+
+static void replayClearColor (const union RenderArgument *arguments)
+{
+   g_gl.ClearColor(arguments[0].f, arguments[1].f, arguments[2].f, arguments[3].f);
+}
+
+static void GLAD_API_PTR recordClearColor (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+   union RenderArgument *arguments = recordCommand(replayClearColor, 4u, NULL, 0u);
+   arguments[0].f = red;
+   arguments[1].f = green;
+   arguments[2].f = blue;
+   arguments[3].f = alpha;
+}
+
+static void replayCopyBufferSubData (const union RenderArgument *arguments)
+{
+   g_gl.CopyBufferSubData(arguments[0].u, arguments[1].u, arguments[2].p, arguments[3].p, arguments[4].s);
+}
+
+static void GLAD_API_PTR recordCopyBufferSubData (GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+{
+   union RenderArgument *arguments = recordCommand(replayCopyBufferSubData, 5u, NULL, 0u);
+   arguments[0].u = readTarget;
+   arguments[1].u = writeTarget;
+   arguments[2].p = readOffset;
+   arguments[3].p = writeOffset;
+   arguments[4].s = size;
+}
+
+static void replayCopyTexSubImage3D (const union RenderArgument *arguments)
+{
+   g_gl.CopyTexSubImage3D(arguments[0].u, arguments[1].i, arguments[2].i, arguments[3].i, arguments[4].i, arguments[5].i, arguments[6].i,
+                          arguments[7].i, arguments[8].i);
+}
+
+static void GLAD_API_PTR recordCopyTexSubImage3D (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                                  GLint x, GLint y, GLsizei width, GLsizei height)
+{
+   union RenderArgument *arguments = recordCommand(replayCopyTexSubImage3D, 9u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].i = level;
+   arguments[2].i = xoffset;
+   arguments[3].i = yoffset;
+   arguments[4].i = zoffset;
+   arguments[5].i = x;
+   arguments[6].i = y;
+   arguments[7].i = width;
+   arguments[8].i = height;
+}
+
+static void replayDeleteBuffers (const union RenderArgument *arguments)
+{
+   g_gl.DeleteBuffers(arguments[0].i, (const GLuint*) (arguments + 1));
+}
+
+static void GLAD_API_PTR recordDeleteBuffers (GLsizei n, const GLuint *buffers)
+{
+   recordCommand(replayDeleteBuffers, 1u, buffers, n * sizeof(GLuint))->i = n;
+}
+
+static void replayDeleteFramebuffers (const union RenderArgument *arguments)
+{
+   g_gl.DeleteFramebuffers(arguments[0].i, (const GLuint*) (arguments + 1));
+}
+
+static void GLAD_API_PTR recordDeleteFramebuffers (GLsizei n, const GLuint *framebuffers)
+{
+   recordCommand(replayDeleteFramebuffers, 1u, framebuffers, n * sizeof(GLuint))->i = n;
+}
+
+static void replayDeleteProgram (const union RenderArgument *arguments)
+{
+   g_gl.DeleteProgram(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordDeleteProgram (GLuint program)
+{
+   recordCommand(replayDeleteProgram, 1u, NULL, 0u)->u = program;
+}
+
+static void replayDeleteTextures (const union RenderArgument *arguments)
+{
+   g_gl.DeleteTextures(arguments[0].i, (const GLuint*) (arguments + 1));
+}
+
+static void GLAD_API_PTR recordDeleteTextures (GLsizei n, const GLuint *textures)
+{
+   recordCommand(replayDeleteTextures, 1u, textures, n * sizeof(GLuint))->i = n;
+}
+
+static void replayDeleteVertexArrays (const union RenderArgument *arguments)
+{
+   g_gl.DeleteVertexArrays(arguments[0].i, (const GLuint*) (arguments + 1));
+}
+
+static void GLAD_API_PTR recordDeleteVertexArrays (GLsizei n, const GLuint *arrays)
+{
+   recordCommand(replayDeleteVertexArrays, 1u, arrays, n * sizeof(GLuint))->i = n;
+}
+
+static void replayDepthFunc (const union RenderArgument *arguments)
+{
+   g_gl.DepthFunc(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordDepthFunc (GLenum func)
+{
+   recordCommand(replayDepthFunc, 1u, NULL, 0u)->u = func;
+}
+
+static void replayDepthMask (const union RenderArgument *arguments)
+{
+   g_gl.DepthMask((GLboolean) arguments[0].u);
+}
+
+static void GLAD_API_PTR recordDepthMask (GLboolean flag)
+{
+   recordCommand(replayDepthMask, 1u, NULL, 0u)->u = flag;
+}
+
+static void replayDisable (const union RenderArgument *arguments)
+{
+   g_gl.Disable(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordDisable (GLenum cap)
+{
+   recordCommand(replayDisable, 1u, NULL, 0u)->u = cap;
+}
+
+static void replayDrawArraysInstanced (const union RenderArgument *arguments)
+{
+   g_gl.DrawArraysInstanced(arguments[0].u, arguments[1].i, arguments[2].i, arguments[3].i);
+}
+
+static void GLAD_API_PTR recordDrawArraysInstanced (GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+   union RenderArgument *arguments = recordCommand(replayDrawArraysInstanced, 4u, NULL, 0u);
+   arguments[0].u = mode;
+   arguments[1].i = first;
+   arguments[2].i = count;
+   arguments[3].i = instancecount;
+}
+
+static void replayEnable (const union RenderArgument *arguments)
+{
+   g_gl.Enable(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordEnable (GLenum cap)
+{
+   recordCommand(replayEnable, 1u, NULL, 0u)->u = cap;
+}
+
+static void replayEnableVertexAttribArray (const union RenderArgument *arguments)
+{
+   g_gl.EnableVertexAttribArray(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordEnableVertexAttribArray (GLuint index)
+{
+   recordCommand(replayEnableVertexAttribArray, 1u, NULL, 0u)->u = index;
+}
+
+static void replayFramebufferTextureLayer (const union RenderArgument *arguments)
+{
+   g_gl.FramebufferTextureLayer(arguments[0].u, arguments[1].u, arguments[2].u, arguments[3].i, arguments[4].i);
+}
+
+static void GLAD_API_PTR recordFramebufferTextureLayer (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
+{
+   union RenderArgument *arguments = recordCommand(replayFramebufferTextureLayer, 5u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = attachment;
+   arguments[2].u = texture;
+   arguments[3].i = level;
+   arguments[4].i = layer;
+}
+
+/* Names are created by GL in core profile, so these wait for render thread */
+static void replayGenBuffers (const union RenderArgument *arguments)
+{
+   g_gl.GenBuffers(arguments[0].i, arguments[1].result);
+}
+
+static void GLAD_API_PTR recordGenBuffers (GLsizei n, GLuint *buffers)
+{
+   union RenderArgument *arguments = recordCommand(replayGenBuffers, 2u, NULL, 0u);
+   arguments[0].i = n;
+   arguments[1].result = buffers;
+   finishCommands();
+}
+
+static void replayGenFramebuffers (const union RenderArgument *arguments)
+{
+   g_gl.GenFramebuffers(arguments[0].i, arguments[1].result);
+}
+
+static void GLAD_API_PTR recordGenFramebuffers (GLsizei n, GLuint *framebuffers)
+{
+   union RenderArgument *arguments = recordCommand(replayGenFramebuffers, 2u, NULL, 0u);
+   arguments[0].i = n;
+   arguments[1].result = framebuffers;
+   finishCommands();
+}
+
+static void replayGenTextures (const union RenderArgument *arguments)
+{
+   g_gl.GenTextures(arguments[0].i, arguments[1].result);
+}
+
+static void GLAD_API_PTR recordGenTextures (GLsizei n, GLuint *textures)
+{
+   union RenderArgument *arguments = recordCommand(replayGenTextures, 2u, NULL, 0u);
+   arguments[0].i = n;
+   arguments[1].result = textures;
+   finishCommands();
+}
+
+static void replayGenVertexArrays (const union RenderArgument *arguments)
+{
+   g_gl.GenVertexArrays(arguments[0].i, arguments[1].result);
+}
+
+static void GLAD_API_PTR recordGenVertexArrays (GLsizei n, GLuint *arrays)
+{
+   union RenderArgument *arguments = recordCommand(replayGenVertexArrays, 2u, NULL, 0u);
+   arguments[0].i = n;
+   arguments[1].result = arrays;
+   finishCommands();
+}
+
+/* Errors are checked by render thread after every replayed command in debug build */
+static GLenum GLAD_API_PTR recordGetError (void)
+{
+   return GL_NO_ERROR;
+}
+
+static void replayMapBufferRange (const union RenderArgument *arguments)
+{
+   *((void**) arguments[4].result) = g_gl.MapBufferRange(arguments[0].u, arguments[1].p, arguments[2].s, arguments[3].u);
+}
+
+/* Range which isn't read is written by game thread to memory of its own, which is uploaded at unmap without waiting for render thread */
+static void* GLAD_API_PTR recordMapBufferRange (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+   void *data = NULL;
+   if (g_renderThread.mappedRangesQuantity < CCE_MAPPED_RANGES_MAX)
+   {
+      if (!(access & GL_MAP_READ_BIT))
+         data = malloc(length);
+      *(g_renderThread.mappedRanges + g_renderThread.mappedRangesQuantity) = (struct MappedRange) {target, offset, length, data};
+      ++g_renderThread.mappedRangesQuantity;
+      if (data)
+         return data;
+   }
+
+   union RenderArgument *arguments = recordCommand(replayMapBufferRange, 5u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].p = offset;
+   arguments[2].s = length;
+   arguments[3].u = access;
+   arguments[4].result = &data;
+   finishCommands();
+   return data;
+}
+
+static void replayPixelStorei (const union RenderArgument *arguments)
+{
+   g_gl.PixelStorei(arguments[0].u, arguments[1].i);
+}
+
+static void GLAD_API_PTR recordPixelStorei (GLenum pname, GLint param)
+{
+   union RenderArgument *arguments = recordCommand(replayPixelStorei, 2u, NULL, 0u);
+   arguments[0].u = pname;
+   arguments[1].i = param;
+}
+
+static void replayTexBuffer (const union RenderArgument *arguments)
+{
+   g_gl.TexBuffer(arguments[0].u, arguments[1].u, arguments[2].u);
+}
+
+static void GLAD_API_PTR recordTexBuffer (GLenum target, GLenum internalformat, GLuint buffer)
+{
+   union RenderArgument *arguments = recordCommand(replayTexBuffer, 3u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = internalformat;
+   arguments[2].u = buffer;
+}
+
+/* Engine uploads pixels only from pixel unpack buffer, so pixels is an offset (or NULL) and isn't copied */
+static void replayTexImage3D (const union RenderArgument *arguments)
+{
+   g_gl.TexImage3D(arguments[0].u, arguments[1].i, arguments[2].i, arguments[3].i, arguments[4].i, arguments[5].i, arguments[6].i,
+                   arguments[7].u, arguments[8].u, arguments[9].data);
+}
+
+static void GLAD_API_PTR recordTexImage3D (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth,
+                                           GLint border, GLenum format, GLenum type, const void *pixels)
+{
+   union RenderArgument *arguments = recordCommand(replayTexImage3D, 10u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].i = level;
+   arguments[2].i = internalformat;
+   arguments[3].i = width;
+   arguments[4].i = height;
+   arguments[5].i = depth;
+   arguments[6].i = border;
+   arguments[7].u = format;
+   arguments[8].u = type;
+   arguments[9].data = pixels;
+}
+
+static void replayTexParameteri (const union RenderArgument *arguments)
+{
+   g_gl.TexParameteri(arguments[0].u, arguments[1].u, arguments[2].i);
+}
+
+static void GLAD_API_PTR recordTexParameteri (GLenum target, GLenum pname, GLint param)
+{
+   union RenderArgument *arguments = recordCommand(replayTexParameteri, 3u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].u = pname;
+   arguments[2].i = param;
+}
+
+static void replayTexSubImage3D (const union RenderArgument *arguments)
+{
+   g_gl.TexSubImage3D(arguments[0].u, arguments[1].i, arguments[2].i, arguments[3].i, arguments[4].i, arguments[5].i, arguments[6].i,
+                      arguments[7].i, arguments[8].u, arguments[9].u, arguments[10].data);
+}
+
+static void GLAD_API_PTR recordTexSubImage3D (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                              GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels)
+{
+   union RenderArgument *arguments = recordCommand(replayTexSubImage3D, 11u, NULL, 0u);
+   arguments[0].u = target;
+   arguments[1].i = level;
+   arguments[2].i = xoffset;
+   arguments[3].i = yoffset;
+   arguments[4].i = zoffset;
+   arguments[5].i = width;
+   arguments[6].i = height;
+   arguments[7].i = depth;
+   arguments[8].u = format;
+   arguments[9].u = type;
+   arguments[10].data = pixels;
+}
+
+static void replayUniform1i (const union RenderArgument *arguments)
+{
+   g_gl.Uniform1i(arguments[0].i, arguments[1].i);
+}
+
+static void GLAD_API_PTR recordUniform1i (GLint location, GLint v0)
+{
+   union RenderArgument *arguments = recordCommand(replayUniform1i, 2u, NULL, 0u);
+   arguments[0].i = location;
+   arguments[1].i = v0;
+}
+
+static void replayUniform1iv (const union RenderArgument *arguments)
+{
+   g_gl.Uniform1iv(arguments[0].i, arguments[1].i, (const GLint*) (arguments + 2));
+}
+
+static void GLAD_API_PTR recordUniform1iv (GLint location, GLsizei count, const GLint *value)
+{
+   union RenderArgument *arguments = recordCommand(replayUniform1iv, 2u, value, count * sizeof(GLint));
+   arguments[0].i = location;
+   arguments[1].i = count;
+}
+
+static void replayUniform2f (const union RenderArgument *arguments)
+{
+   g_gl.Uniform2f(arguments[0].i, arguments[1].f, arguments[2].f);
+}
+
+static void GLAD_API_PTR recordUniform2f (GLint location, GLfloat v0, GLfloat v1)
+{
+   union RenderArgument *arguments = recordCommand(replayUniform2f, 3u, NULL, 0u);
+   arguments[0].i = location;
+   arguments[1].f = v0;
+   arguments[2].f = v1;
+}
+
+static void replayUniform2i (const union RenderArgument *arguments)
+{
+   g_gl.Uniform2i(arguments[0].i, arguments[1].i, arguments[2].i);
+}
+
+static void GLAD_API_PTR recordUniform2i (GLint location, GLint v0, GLint v1)
+{
+   union RenderArgument *arguments = recordCommand(replayUniform2i, 3u, NULL, 0u);
+   arguments[0].i = location;
+   arguments[1].i = v0;
+   arguments[2].i = v1;
+}
+
+static void replayUniform2iv (const union RenderArgument *arguments)
+{
+   g_gl.Uniform2iv(arguments[0].i, arguments[1].i, (const GLint*) (arguments + 2));
+}
+
+static void GLAD_API_PTR recordUniform2iv (GLint location, GLsizei count, const GLint *value)
+{
+   union RenderArgument *arguments = recordCommand(replayUniform2iv, 2u, value, count * 2u * sizeof(GLint));
+   arguments[0].i = location;
+   arguments[1].i = count;
+}
+
+static void replayUnmapBuffer (const union RenderArgument *arguments)
+{
+   g_gl.UnmapBuffer(arguments[0].u);
+}
+
+/* Written range is uploaded from memory given by recordMapBufferRange, which is freed after the upload */
+static void replayUploadMappedRange (const union RenderArgument *arguments)
+{
+   g_gl.BufferSubData(arguments[0].u, arguments[1].p, arguments[2].s, arguments[3].result);
+   free(arguments[3].result);
+}
+
+static GLboolean GLAD_API_PTR recordUnmapBuffer (GLenum target)
+{
+   for (struct MappedRange *iterator = g_renderThread.mappedRanges, *end = g_renderThread.mappedRanges + g_renderThread.mappedRangesQuantity;
+        iterator < end; ++iterator)
+   {
+      if (iterator->target != target)
+         continue;
+
+      if (iterator->data)
+      {
+         union RenderArgument *arguments = recordCommand(replayUploadMappedRange, 4u, NULL, 0u);
+         arguments[0].u = target;
+         arguments[1].p = iterator->offset;
+         arguments[2].s = iterator->length;
+         arguments[3].result = iterator->data;
+      }
+      else
+      {
+         recordCommand(replayUnmapBuffer, 1u, NULL, 0u)->u = target;
+      }
+      *iterator = *(end - 1);
+      --g_renderThread.mappedRangesQuantity;
+      return GL_TRUE;
+   }
+   recordCommand(replayUnmapBuffer, 1u, NULL, 0u)->u = target;
+   return GL_TRUE;
+}
+
+static void replayUseProgram (const union RenderArgument *arguments)
+{
+   g_gl.UseProgram(arguments[0].u);
+}
+
+static void GLAD_API_PTR recordUseProgram (GLuint program)
+{
+   recordCommand(replayUseProgram, 1u, NULL, 0u)->u = program;
+}
+
+static void replayVertexAttribDivisor (const union RenderArgument *arguments)
+{
+   g_gl.VertexAttribDivisor(arguments[0].u, arguments[1].u);
+}
+
+static void GLAD_API_PTR recordVertexAttribDivisor (GLuint index, GLuint divisor)
+{
+   union RenderArgument *arguments = recordCommand(replayVertexAttribDivisor, 2u, NULL, 0u);
+   arguments[0].u = index;
+   arguments[1].u = divisor;
+}
+
+/* Pointer is an offset in the bound array buffer */
+static void replayVertexAttribIPointer (const union RenderArgument *arguments)
+{
+   g_gl.VertexAttribIPointer(arguments[0].u, arguments[1].i, arguments[2].u, arguments[3].i, arguments[4].data);
+}
+
+static void GLAD_API_PTR recordVertexAttribIPointer (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer)
+{
+   union RenderArgument *arguments = recordCommand(replayVertexAttribIPointer, 5u, NULL, 0u);
+   arguments[0].u = index;
+   arguments[1].i = size;
+   arguments[2].u = type;
+   arguments[3].i = stride;
+   arguments[4].data = pointer;
+}
+
+static void replayViewport (const union RenderArgument *arguments)
+{
+   g_gl.Viewport(arguments[0].i, arguments[1].i, arguments[2].i, arguments[3].i);
+}
+
+static void GLAD_API_PTR recordViewport (GLint x, GLint y, GLsizei width, GLsizei height)
+{
+   union RenderArgument *arguments = recordCommand(replayViewport, 4u, NULL, 0u);
+   arguments[0].i = x;
+   arguments[1].i = y;
+   arguments[2].i = width;
+   arguments[3].i = height;
+}
+
+#define CCE_RECORD_GL_FUNCTION(name) g_gl.name = glad_gl##name; glad_gl##name = record##name;
+#define CCE_RESTORE_GL_FUNCTION(name) glad_gl##name = g_gl.name;
+
+/* Called after engine's initialization, GL context is given to render thread. Returns 0 on success */
+int cce__startRenderThread (void)
+{
+   if (g_renderThread.flags & CCE_RENDER_THREAD_RUNNING)
+      return 0;
+   memset(&g_renderThread, 0, sizeof(g_renderThread));
+   cce__initMutex(&g_renderThread.mutex);
+   cce__initCondition(&g_renderThread.condition);
+   CCE_RECORDED_GL_FUNCTIONS(CCE_RECORD_GL_FUNCTION)
+   g_renderThread.swapBuffers = cce__swapBuffers;
+   cce__swapBuffers = swapBuffers__renderThread;
+   g_renderThread.flags = CCE_RENDER_THREAD_RUNNING;
+   cce__makeContextCurrent(0u);
+   if (cce__createThread(&g_renderThread.thread, renderThread, NULL) != 0)
+   {
+      cce__makeContextCurrent(1u);
+      CCE_RECORDED_GL_FUNCTIONS(CCE_RESTORE_GL_FUNCTION)
+      cce__swapBuffers = g_renderThread.swapBuffers;
+      g_renderThread.flags = 0u;
+      cce__destroyCondition(&g_renderThread.condition);
+      cce__destroyMutex(&g_renderThread.mutex);
+      return -1;
+   }
+   return 0;
+}
+
+/* Replays everything recorded and gives GL context back to the calling thread */
+void cce__stopRenderThread (void)
+{
+   if (!(g_renderThread.flags & CCE_RENDER_THREAD_RUNNING))
+      return;
+   submitCommands();
+   cce__lockMutex(&g_renderThread.mutex);
+   g_renderThread.flags |= CCE_RENDER_THREAD_STOP;
+   cce__broadcastCondition(&g_renderThread.condition);
+   cce__unlockMutex(&g_renderThread.mutex);
+   cce__joinThread(g_renderThread.thread);
+   cce__makeContextCurrent(1u);
+   CCE_RECORDED_GL_FUNCTIONS(CCE_RESTORE_GL_FUNCTION)
+   cce__swapBuffers = g_renderThread.swapBuffers;
+   for (struct MappedRange *iterator = g_renderThread.mappedRanges, *end = g_renderThread.mappedRanges + g_renderThread.mappedRangesQuantity;
+        iterator < end; ++iterator)
+   {
+      free(iterator->data);
+   }
+   free(g_renderThread.commands[0].arguments);
+   free(g_renderThread.commands[1].arguments);
+   cce__destroyCondition(&g_renderThread.condition);
+   cce__destroyMutex(&g_renderThread.mutex);
+   g_renderThread.flags = 0u;
+}
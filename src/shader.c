@@ -22,47 +22,237 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../include/coffeechain/engine_common.h"
 #include "../include/coffeechain/os_interaction.h"
+#include "../include/coffeechain/utils.h"
 
 #include "shader.h"
 #include "engine_common_internal.h"
+#include "platform/files.h"
 
 #undef NDEBUG
 /* There is EPIC workaround to set defines in GLSL at runtime */
 
-unsigned int makeVFshaderProgram  (const char *const vertexPath, const char *const fragmentPath, uint16_t shadersVersion,
-                                   const char *const vertexShaderAdditionalString, const char *const fragmentShaderAdditionalString)
+/* Linked programs are kept in <app data>/<folderName>/shader_cache/<key>.c2p, where key is hash of full sources (with version and defines)
+ * and of GL_RENDERER and GL_VERSION strings. Program binaries of other driver are rejected by glProgramBinary, then sources are compiled */
+#define CCE_PROGRAM_CACHE_VERSION 1u
+#define CCE_PROGRAM_CACHE_NAME_SIZE 32u
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_PROGRAM_BINARY_FORMATS
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+struct ProgramCacheHeader
 {
-   unsigned int vertexShader = 0u, fragmentShader = 0u, shaderProgram = 0u;
-   char *shaderSrc = fileRead(vertexPath);
-   if (shaderSrc == NULL)
+   char     magic[4]; /* "C2PB" */
+   uint16_t version;
+   uint16_t reserved;
+   uint32_t format;
+   uint32_t size;
+   uint64_t key;
+}; // 24 bytes, followed by size bytes of program binary
+
+static char  *g_programCachePath = NULL;
+static size_t g_programCachePathLength;
+
+/* folderName is folder of the game in app data directory, NULL turns cache off. Has to be called before cceInitEngine2D */
+CCE_PUBLIC_OPTIONS int cceSetShaderCache (const char *folderName)
+{
+   cce__terminateShaderCache();
+   if (!folderName)
+      return 0;
+   char *path = cceGetAppDataPath(folderName, 16u + CCE_PROGRAM_CACHE_NAME_SIZE);
+   if (!path)
+      return -1;
+   size_t pathLength = strlen(path);
+   cceAppendPath(path, pathLength + 16u + CCE_PROGRAM_CACHE_NAME_SIZE, "shader_cache");
+   if (!cceGetDirectory(path, pathLength + 16u + CCE_PROGRAM_CACHE_NAME_SIZE))
    {
-      fprintf(stderr, "OPENGL::SHADER::VERTEX::FAILED_TO_LOAD:\n%s\n", vertexPath);
-      goto FINAL;
+      free(path);
+      return -1;
    }
-   char *shaderModifiedSrc = addStringsInShader(shadersVersion, vertexShaderAdditionalString, shaderSrc);
-   free(shaderSrc);
-   vertexShader = compileShader(shaderModifiedSrc, GL_VERTEX_SHADER);
-   free(shaderModifiedSrc);
-   if (vertexShader == 0u)
-      goto FINAL;
+   g_programCachePathLength = strlen(path);
+   cceAppendPath(path, g_programCachePathLength + CCE_PROGRAM_CACHE_NAME_SIZE, "");
+   g_programCachePathLength = strlen(path);
+   g_programCachePath = path;
+   return 0;
+}
+
+void cce__terminateShaderCache (void)
+{
+   free(g_programCachePath);
+   g_programCachePath = NULL;
+}
+
+static uint64_t getProgramCacheKey (const char *const *sources, uint8_t sourcesQuantity)
+{
+   struct cce_hash64State state;
+   cceHash64Init(&state, CCE_PROGRAM_CACHE_VERSION);
+   for (const char *const *iterator = sources, *const *end = sources + sourcesQuantity; iterator < end; ++iterator)
+   {
+      cceHash64Update(&state, *iterator, strlen(*iterator) + 1u); // With \0, so sources can't be shifted into each other
+   }
+   const char *strings[] = {(const char*) glGetString(GL_RENDERER), (const char*) glGetString(GL_VERSION)};
+   for (uint8_t i = 0u; i < 2u; ++i)
+   {
+      if (strings[i])
+         cceHash64Update(&state, strings[i], strlen(strings[i]) + 1u);
+   }
+   return cceHash64Final(&state);
+}
+
+/* path must have g_programCachePathLength + CCE_PROGRAM_CACHE_NAME_SIZE bytes */
+static void getProgramCachePath (char *path, uint64_t key, const char *extension)
+{
+   memcpy(path, g_programCachePath, g_programCachePathLength);
+   snprintf(path + g_programCachePathLength, CCE_PROGRAM_CACHE_NAME_SIZE, "%016llx%s", (unsigned long long) key, extension);
+}
+
+/* Binary of driver that is no longer used has unknown format, glProgramBinary would fail with GL_INVALID_ENUM for it */
+static int isProgramBinaryFormatSupported (GLenum format)
+{
+   GLint formatsQuantity = 0;
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsQuantity);
+   if (formatsQuantity <= 0)
+      return 0;
+   GLint *formats = malloc(formatsQuantity * sizeof(GLint));
+   glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats);
+   int isSupported = 0;
+   for (GLint i = 0; i < formatsQuantity && !isSupported; ++i)
+      isSupported = ((GLenum) formats[i] == format);
+   free(formats);
+   return isSupported;
+}
+
+/* Returns 0 if there is no valid binary of the program */
+static unsigned int readProgramCache (uint64_t key)
+{
+   if (!g_programCachePath || !cce__glProgramBinary)
+      return 0u;
+   char *path = malloc(g_programCachePathLength + CCE_PROGRAM_CACHE_NAME_SIZE);
+   getProgramCachePath(path, key, ".c2p");
+   size_t fileSize;
+   const uint8_t *file = cce__mapFile(path, &fileSize);
+   free(path);
+   if (!file)
+      return 0u;
+   
+   struct ProgramCacheHeader header;
+   if (fileSize >= sizeof(struct ProgramCacheHeader))
+      memcpy(&header, file, sizeof(struct ProgramCacheHeader));
+   if (fileSize < sizeof(struct ProgramCacheHeader) || memcmp(header.magic, "C2PB", 4u) != 0 || header.version != CCE_PROGRAM_CACHE_VERSION ||
+       header.key != key || header.size == 0u || fileSize - sizeof(struct ProgramCacheHeader) < header.size ||
+       !isProgramBinaryFormatSupported(header.format))
+   {
+      cce__unmapFile(file, fileSize);
+      return 0u;
+   }
+   unsigned int shaderProgram = glCreateProgram();
+   cce__glProgramBinary(shaderProgram, header.format, file + sizeof(struct ProgramCacheHeader), header.size);
+   cce__unmapFile(file, fileSize);
+   int success;
+   glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success); // Binary rejected by driver (e.g. after its update) isn't linked
+   if (!success)
+   {
+      glDeleteProgram(shaderProgram);
+      return 0u;
+   }
+   return shaderProgram;
+}
+
+/* Written to temporary file first, so other process never maps half-written file. Failures only mean no cache */
+static void writeProgramCache (unsigned int shaderProgram, uint64_t key)
+{
+   if (!g_programCachePath || !cce__glGetProgramBinary || shaderProgram == 0u)
+      return;
+   GLint formatsQuantity = 0, size = 0;
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsQuantity);
+   glGetProgramiv(shaderProgram, GL_PROGRAM_BINARY_LENGTH, &size);
+   if (formatsQuantity <= 0 || size <= 0)
+      return;
    
-   shaderSrc = fileRead(fragmentPath);
+   struct ProgramCacheHeader header;
+   memcpy(header.magic, "C2PB", 4u);
+   header.version = CCE_PROGRAM_CACHE_VERSION;
+   header.reserved = 0u;
+   header.key = key;
+   uint8_t *binary = malloc(size);
+   GLsizei length = 0;
+   GLenum format = 0u;
+   cce__glGetProgramBinary(shaderProgram, size, &length, &format, binary);
+   header.format = format;
+   header.size = length;
+   if (length > 0)
+   {
+      char *path = malloc(g_programCachePathLength + CCE_PROGRAM_CACHE_NAME_SIZE);
+      char *temporaryPath = malloc(g_programCachePathLength + CCE_PROGRAM_CACHE_NAME_SIZE);
+      getProgramCachePath(path, key, ".c2p");
+      getProgramCachePath(temporaryPath, key, ".tmp");
+      FILE *file = fopen(temporaryPath, "wb");
+      if (file)
+      {
+         int isWritten = (fwrite(&header, sizeof(struct ProgramCacheHeader), 1u, file) == 1u) && (fwrite(binary, 1u, length, file) == (size_t) length);
+         isWritten = (fclose(file) == 0) && isWritten;
+         if (!isWritten || cce__replaceFile(temporaryPath, path) != 0)
+            remove(temporaryPath);
+      }
+      free(temporaryPath);
+      free(path);
+   }
+   free(binary);
+}
+
+/* Returns source with version and defines, NULL if the file can't be read */
+static char* loadShaderSource (const char *const path, uint16_t shadersVersion, const char *const additionalString, const char *const shaderType)
+{
+   char *shaderSrc = fileRead(path);
    if (shaderSrc == NULL)
    {
-      fprintf(stderr, "OPENGL::SHADER::FRAGMENT::FAILED_TO_LOAD:\n%s\n", fragmentPath);
-      goto FINAL;
+      fprintf(stderr, "OPENGL::SHADER::%s::FAILED_TO_LOAD:\n%s\n", shaderType, path);
+      return NULL;
    }
-   shaderModifiedSrc = addStringsInShader(shadersVersion, fragmentShaderAdditionalString, shaderSrc);
+   char *shaderModifiedSrc = addStringsInShader(shadersVersion, additionalString, shaderSrc);
    free(shaderSrc);
-   fragmentShader = compileShader(shaderModifiedSrc, GL_FRAGMENT_SHADER);
-   free(shaderModifiedSrc);
+   return shaderModifiedSrc;
+}
+
+unsigned int makeVFshaderProgram  (const char *const vertexPath, const char *const fragmentPath, uint16_t shadersVersion,
+                                   const char *const vertexShaderAdditionalString, const char *const fragmentShaderAdditionalString)
+{
+   unsigned int vertexShader = 0u, fragmentShader = 0u, shaderProgram = 0u;
+   char *vertexSrc = loadShaderSource(vertexPath, shadersVersion, vertexShaderAdditionalString, "VERTEX");
+   char *fragmentSrc = loadShaderSource(fragmentPath, shadersVersion, fragmentShaderAdditionalString, "FRAGMENT");
+   if (vertexSrc == NULL || fragmentSrc == NULL)
+      goto FINAL;
+   
+   const char *sources[] = {vertexSrc, fragmentSrc};
+   uint64_t key = getProgramCacheKey(sources, 2u);
+   shaderProgram = readProgramCache(key);
+   if (shaderProgram != 0u)
+      goto FINAL;
+   
+   vertexShader = compileShader(vertexSrc, GL_VERTEX_SHADER);
+   if (vertexShader == 0u)
+      goto FINAL;
+   fragmentShader = compileShader(fragmentSrc, GL_FRAGMENT_SHADER);
    if (fragmentShader == 0u)
       goto FINAL;
    
    shaderProgram = createVFshaderProgram(vertexShader, fragmentShader);
+   writeProgramCache(shaderProgram, key);
    
 FINAL:
+   free(vertexSrc);
+   free(fragmentSrc);
    glDeleteShader(vertexShader);
    glDeleteShader(fragmentShader);
    return shaderProgram;
@@ -72,48 +262,35 @@ unsigned int makeVGFshaderProgram (const char *const vertexPath, const char *con
                                    const char *const vertexShaderAdditionalString, const char *const geometryShaderAdditionalString, const char *const fragmentShaderAdditionalString)
 {
    unsigned int vertexShader = 0u, geometryShader = 0u, fragmentShader = 0u, shaderProgram = 0u;
-   char *shaderSrc = fileRead(vertexPath);
-   if (shaderSrc == NULL)
-   {
-      fprintf(stderr, "OPENGL::SHADER::VERTEX::FAILED_TO_LOAD:\n%s\n", vertexPath);
+   char *vertexSrc = loadShaderSource(vertexPath, shadersVersion, vertexShaderAdditionalString, "VERTEX");
+   char *geometrySrc = loadShaderSource(geometryPath, shadersVersion, geometryShaderAdditionalString, "GEOMETRY");
+   char *fragmentSrc = loadShaderSource(fragmentPath, shadersVersion, fragmentShaderAdditionalString, "FRAGMENT");
+   if (vertexSrc == NULL || geometrySrc == NULL || fragmentSrc == NULL)
       goto FINAL;
-   }
-   char *shaderModifiedSrc = addStringsInShader(shadersVersion, vertexShaderAdditionalString, shaderSrc);
-   free(shaderSrc);
-   vertexShader = compileShader(shaderModifiedSrc, GL_VERTEX_SHADER);
-   free(shaderModifiedSrc);
-   if (vertexShader == 0u)
+   
+   const char *sources[] = {vertexSrc, geometrySrc, fragmentSrc};
+   uint64_t key = getProgramCacheKey(sources, 3u);
+   shaderProgram = readProgramCache(key);
+   if (shaderProgram != 0u)
       goto FINAL;
    
-   shaderSrc = fileRead(geometryPath);
-   if (shaderSrc == NULL)
-   {
-      fprintf(stderr, "OPENGL::SHADER::GEOMETRY::FAILED_TO_LOAD:\n%s\n", fragmentPath);
+   vertexShader = compileShader(vertexSrc, GL_VERTEX_SHADER);
+   if (vertexShader == 0u)
       goto FINAL;
-   }
-   shaderModifiedSrc = addStringsInShader(shadersVersion, geometryShaderAdditionalString, shaderSrc);
-   free(shaderSrc);
-   geometryShader = compileShader(shaderModifiedSrc, GL_GEOMETRY_SHADER);
-   free(shaderModifiedSrc);
+   geometryShader = compileShader(geometrySrc, GL_GEOMETRY_SHADER);
    if (geometryShader == 0u)
       goto FINAL;
-   
-   shaderSrc = fileRead(fragmentPath);
-   if (shaderSrc == NULL)
-   {
-      fprintf(stderr, "OPENGL::SHADER::FRAGMENT::FAILED_TO_LOAD:\n%s\n", fragmentPath);
-      goto FINAL;
-   }
-   shaderModifiedSrc = addStringsInShader(shadersVersion, fragmentShaderAdditionalString, shaderSrc);
-   free(shaderSrc);
-   fragmentShader = compileShader(shaderModifiedSrc, GL_FRAGMENT_SHADER);
-   free(shaderModifiedSrc);
+   fragmentShader = compileShader(fragmentSrc, GL_FRAGMENT_SHADER);
    if (fragmentShader == 0u)
       goto FINAL;
    
    shaderProgram = createVGFshaderProgram(vertexShader, geometryShader, fragmentShader);
+   writeProgramCache(shaderProgram, key);
    
 FINAL:
+   free(vertexSrc);
+   free(geometrySrc);
+   free(fragmentSrc);
    glDeleteShader(vertexShader);
    glDeleteShader(geometryShader);
    glDeleteShader(fragmentShader);
@@ -177,6 +354,8 @@ unsigned int compileShader (const char *shaderSource, GLenum shaderType)
 unsigned int createVFshaderProgram (unsigned int vertexShader, unsigned int fragmentShader)
 {
    unsigned int shaderProgram = glCreateProgram();
+   if (g_programCachePath && cce__glProgramParameteri)
+      cce__glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
    glAttachShader(shaderProgram, vertexShader);
    glAttachShader(shaderProgram, fragmentShader);
    glLinkProgram(shaderProgram);
@@ -194,6 +373,8 @@ unsigned int createVFshaderProgram (unsigned int vertexShader, unsigned int frag
 unsigned int createVGFshaderProgram (unsigned int vertexShader, unsigned int geometryShader, unsigned int fragmentShader)
 {
    unsigned int shaderProgram = glCreateProgram();
+   if (g_programCachePath && cce__glProgramParameteri)
+      cce__glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
    glAttachShader(shaderProgram, vertexShader);
    glAttachShader(shaderProgram, geometryShader);
    glAttachShader(shaderProgram, fragmentShader);
@@ -39,6 +39,7 @@ char* addStringsInShader (uint16_t shadersVersion, const char *const shaderAddit
 unsigned int compileShader (const char *shaderSource, GLenum shaderType);
 unsigned int createVFshaderProgram (unsigned int vertexShader, unsigned int fragmentShader);
 unsigned int createVGFshaderProgram (unsigned int vertexShader, unsigned int geometryShader, unsigned int fragmentShader);
+void cce__terminateShaderCache (void);
 
 #ifdef __cplusplus
 }
@@ -23,12 +23,7 @@
 
 #include "../include/coffeechain/engine_common.h"
 #include "../include/coffeechain/endianess.h"
-
-struct UnicodeCharWithSize
-{
-   uint32_t ch;
-   uint32_t size;
-};
+#include "../include/coffeechain/utils.h"
 
 CCE_PUBLIC_OPTIONS size_t cceBinarySearch (const void *const array, size_t arraySize, size_t typeSize, size_t step, size_t value)
 {
@@ -160,3 +155,139 @@ CCE_PUBLIC_OPTIONS uint32_t cceGetCharFromStringUTF8 (const char *string, size_t
    }
    return cceGetCharUTF8(str);
 }
+
+/* 64-bit hash, same output as xxHash64. Used to verify files, not for security */
+#define CCE_PRIME64_1 0x9E3779B185EBCA87u
+#define CCE_PRIME64_2 0xC2B2AE3D27D4EB4Fu
+#define CCE_PRIME64_3 0x165667B19E3779F9u
+#define CCE_PRIME64_4 0x85EBCA77C2B2AE63u
+#define CCE_PRIME64_5 0x27D4EB2F165667C5u
+
+#define CCE_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline uint64_t readInt64LE (const uint8_t *data)
+{
+   uint64_t value;
+   memcpy(&value, data, sizeof(uint64_t));
+   return cceLittleEndianToHostEndianInt64(value);
+}
+
+static inline uint32_t readInt32LE (const uint8_t *data)
+{
+   uint32_t value;
+   memcpy(&value, data, sizeof(uint32_t));
+   return cceLittleEndianToHostEndianInt32(value);
+}
+
+static inline uint64_t hash64Round (uint64_t accumulator, uint64_t input)
+{
+   accumulator += input * CCE_PRIME64_2;
+   accumulator = CCE_ROTL64(accumulator, 31);
+   return accumulator * CCE_PRIME64_1;
+}
+
+static inline uint64_t hash64MergeRound (uint64_t accumulator, uint64_t value)
+{
+   accumulator ^= hash64Round(0u, value);
+   return accumulator * CCE_PRIME64_1 + CCE_PRIME64_4;
+}
+
+/* Consumes all whole 32-byte stripes, returns pointer to the remaining tail */
+static const uint8_t* hash64Stripes (uint64_t *accumulators, const uint8_t *data, const uint8_t *end)
+{
+   uint64_t v1 = accumulators[0], v2 = accumulators[1], v3 = accumulators[2], v4 = accumulators[3];
+   for (; end - data >= 32; data += 32)
+   {
+      v1 = hash64Round(v1, readInt64LE(data));
+      v2 = hash64Round(v2, readInt64LE(data + 8));
+      v3 = hash64Round(v3, readInt64LE(data + 16));
+      v4 = hash64Round(v4, readInt64LE(data + 24));
+   }
+   accumulators[0] = v1, accumulators[1] = v2, accumulators[2] = v3, accumulators[3] = v4;
+   return data;
+}
+
+CCE_PUBLIC_OPTIONS void cceHash64Init (struct cce_hash64State *state, uint64_t seed)
+{
+   memset(state, 0, sizeof(struct cce_hash64State));
+   state->accumulators[0] = seed + CCE_PRIME64_1 + CCE_PRIME64_2;
+   state->accumulators[1] = seed + CCE_PRIME64_2;
+   state->accumulators[2] = seed;
+   state->accumulators[3] = seed - CCE_PRIME64_1;
+   state->seed = seed;
+}
+
+CCE_PUBLIC_OPTIONS void cceHash64Update (struct cce_hash64State *state, const void *data, size_t size)
+{
+   const uint8_t *iterator = (const uint8_t*) data, *end = iterator + size;
+   state->totalSize += size;
+   if (state->bufferedSize + size < 32u)
+   {
+      memcpy(state->buffer + state->bufferedSize, iterator, size);
+      state->bufferedSize += size;
+      return;
+   }
+   if (state->bufferedSize)
+   {
+      size_t fill = 32u - state->bufferedSize;
+      memcpy(state->buffer + state->bufferedSize, iterator, fill);
+      hash64Stripes(state->accumulators, state->buffer, state->buffer + 32);
+      iterator += fill;
+      state->bufferedSize = 0u;
+   }
+   iterator = hash64Stripes(state->accumulators, iterator, end);
+   memcpy(state->buffer, iterator, end - iterator);
+   state->bufferedSize = end - iterator;
+}
+
+CCE_PUBLIC_OPTIONS uint64_t cceHash64Final (const struct cce_hash64State *state)
+{
+   uint64_t hash;
+   if (state->totalSize >= 32u)
+   {
+      const uint64_t *v = state->accumulators;
+      hash = CCE_ROTL64(v[0], 1) + CCE_ROTL64(v[1], 7) + CCE_ROTL64(v[2], 12) + CCE_ROTL64(v[3], 18);
+      hash = hash64MergeRound(hash, v[0]);
+      hash = hash64MergeRound(hash, v[1]);
+      hash = hash64MergeRound(hash, v[2]);
+      hash = hash64MergeRound(hash, v[3]);
+   }
+   else
+   {
+      hash = state->seed + CCE_PRIME64_5;
+   }
+   hash += state->totalSize;
+   
+   const uint8_t *iterator = state->buffer, *end = state->buffer + state->bufferedSize;
+   for (; end - iterator >= 8; iterator += 8)
+   {
+      hash ^= hash64Round(0u, readInt64LE(iterator));
+      hash = CCE_ROTL64(hash, 27) * CCE_PRIME64_1 + CCE_PRIME64_4;
+   }
+   if (end - iterator >= 4)
+   {
+      hash ^= (uint64_t) readInt32LE(iterator) * CCE_PRIME64_1;
+      hash = CCE_ROTL64(hash, 23) * CCE_PRIME64_2 + CCE_PRIME64_3;
+      iterator += 4;
+   }
+   for (; iterator < end; ++iterator)
+   {
+      hash ^= (*iterator) * CCE_PRIME64_5;
+      hash = CCE_ROTL64(hash, 11) * CCE_PRIME64_1;
+   }
+   
+   hash ^= hash >> 33;
+   hash *= CCE_PRIME64_2;
+   hash ^= hash >> 29;
+   hash *= CCE_PRIME64_3;
+   hash ^= hash >> 32;
+   return hash;
+}
+
+CCE_PUBLIC_OPTIONS uint64_t cceHash64 (const void *data, size_t size, uint64_t seed)
+{
+   struct cce_hash64State state;
+   cceHash64Init(&state, seed);
+   cceHash64Update(&state, data, size);
+   return cceHash64Final(&state);
+}
@@ -0,0 +1,71 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+/* coffeechain-mapbake - converts map_<n>.c2m into GPU-ready vertex blob map_<n>.c2b, so cceLoadMap2D can skip per-element conversion.
+ * Texture size must be the same as textureMaxWidth and textureMaxHeight passed to cceInitEngine2D, otherwise baked map is ignored */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <coffeechain/endianess.h>
+#include <coffeechain/map2D/map2D.h>
+
+static void printUsage (const char *programName)
+{
+   fprintf(stderr, "Usage: %s MAPS_PATH TEXTURES_PATH WIDTHxHEIGHT MAP_ID|FIRST_ID-LAST_ID...\n", programName);
+}
+
+int main (int argc, char **argv)
+{
+   if (argc < 5)
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   unsigned long textureMaxWidth, textureMaxHeight;
+   if (sscanf(argv[3], "%lux%lu", &textureMaxWidth, &textureMaxHeight) != 2 || textureMaxWidth == 0 || textureMaxHeight == 0)
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   cceInitEndianConversion();
+   cceSetMap2Dpath(argv[1]);
+   int result = 0;
+   for (char **iterator = argv + 4, **end = argv + argc; iterator < end; ++iterator)
+   {
+      unsigned long first, last;
+      int read = sscanf(*iterator, "%lu-%lu", &first, &last);
+      if (read < 1 || first > 0xFFFF || (read == 2 && (last > 0xFFFF || last < first)))
+      {
+         fprintf(stderr, "%s - invalid map ID\n", *iterator);
+         result = 1;
+         continue;
+      }
+      if (read == 1)
+         last = first;
+      for (unsigned long ID = first; ID <= last; ++ID)
+      {
+         if (cceBakeMap2D(ID, argv[2], textureMaxWidth, textureMaxHeight) != 0)
+            result = 1;
+      }
+   }
+   return result;
+}
@@ -0,0 +1,36 @@
+/*
+    CoffeeChain - open source engine for making games.
+    Copyright (C) 2020-2022 Andrey Givoronsky
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+/* coffeechain-respack - packs maps, baked maps, images and other resources into single file, which is opened by cceOpenResourcePack.
+ * Files are given relative to RESOURCES_PATH, for example: coffeechain-respack game.c2p res $(cd res && find . -type f) */
+
+#include <stdio.h>
+
+#include <coffeechain/resource_pack.h>
+
+int main (int argc, char **argv)
+{
+   if (argc < 4)
+   {
+      fprintf(stderr, "Usage: %s OUTPUT RESOURCES_PATH FILE...\n", argv[0]);
+      return 1;
+   }
+   return (cceCreateResourcePack(argv[1], argv[2], (const char *const *) (argv + 3), argc - 3) != 0);
+}